@@ -0,0 +1,240 @@
+#ifndef ASYNC_QUERY_HPP
+#define ASYNC_QUERY_HPP
+
+#if !defined(__cpp_impl_coroutine)
+#error "AsyncQuery.hpp usa corrotinas: compile com -std=c++20"
+#endif
+
+#include <coroutine>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+
+#include "DiskIVF.hpp"
+
+/**
+ * @class PageFetcher
+ * @brief Traz páginas de um arquivo mapeado para a memória fora da thread que consulta.
+ * * Faz o papel de uma fila de submissão/conclusão de E/S assíncrona (como o
+ * io_uring): a corrotina que precisa de um trecho frio entrega o pedido e
+ * suspende; uma das threads de E/S chama madvise(WILLNEED) no trecho e lê um
+ * byte de cada página, de modo que é ela que fica bloqueada nas faltas de
+ * página. Quando o trecho está em memória, a corrotina vai para a fila de
+ * prontas, que o escalonador (runAsyncQueries) esvazia.
+ */
+class PageFetcher {
+public:
+    explicit PageFetcher(int io_threads = 4) {
+        for (int t = 0; t < std::max(1, io_threads); ++t) workers.emplace_back([this] { work(); });
+    }
+
+    ~PageFetcher() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        pending.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    PageFetcher(const PageFetcher&) = delete;
+    PageFetcher& operator=(const PageFetcher&) = delete;
+
+    /**
+     * @struct Await
+     * @brief co_await fetcher.fetch(addr, bytes): suspende só se alguma página do trecho estiver fora da memória.
+     */
+    struct Await {
+        PageFetcher& fetcher;
+        const char* addr;
+        size_t bytes;
+
+        bool await_ready() const {
+            bool hot = DiskIVF::resident(addr, bytes);
+            (hot ? fetcher.hot : fetcher.cold)++;
+            return hot;
+        }
+        void await_suspend(std::coroutine_handle<> h) { fetcher.submit({addr, bytes, h}); }
+        void await_resume() const {}
+    };
+
+    Await fetch(const char* addr, size_t bytes) { return Await{*this, addr, bytes}; }
+
+    // Move para 'out' as corrotinas cujas páginas chegaram; espera se ainda não há nenhuma.
+    void waitReady(std::vector<std::coroutine_handle<>>& out) {
+        std::unique_lock<std::mutex> lk(lock);
+        done.wait(lk, [&] { return !ready.empty(); });
+        out.insert(out.end(), ready.begin(), ready.end());
+        ready.clear();
+    }
+
+    uint64_t hotFetches() const { return hot.load(); }
+    uint64_t coldFetches() const { return cold.load(); }
+
+private:
+    struct Request {
+        const char* addr;
+        size_t bytes;
+        std::coroutine_handle<> waiter;
+    };
+
+    std::mutex lock;
+    std::condition_variable pending, done;
+    std::deque<Request> requests;
+    std::vector<std::coroutine_handle<>> ready;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+    std::atomic<uint64_t> hot{0}, cold{0};
+
+    void submit(const Request& r) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            requests.push_back(r);
+        }
+        pending.notify_one();
+    }
+
+    void work() {
+        while (true) {
+            Request r;
+            {
+                std::unique_lock<std::mutex> lk(lock);
+                pending.wait(lk, [&] { return stopping || !requests.empty(); });
+                if (requests.empty()) return;
+                r = requests.front();
+                requests.pop_front();
+            }
+            const size_t page = fvi::pageSize();
+            uintptr_t first = reinterpret_cast<uintptr_t>(r.addr) / page * page;
+            uintptr_t end = reinterpret_cast<uintptr_t>(r.addr) + r.bytes;
+            ::madvise(reinterpret_cast<void*>(first), end - first, MADV_WILLNEED);
+            unsigned sink = 0;
+            for (uintptr_t p = first; p < end; p += page) sink += *reinterpret_cast<const volatile char*>(p);
+            (void)sink;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                ready.push_back(r.waiter);
+            }
+            done.notify_one();
+        }
+    }
+};
+
+/**
+ * @class QueryTask
+ * @brief Corrotina de uma consulta: começa suspensa, guarda o resultado e fica suspensa no fim.
+ * @details Quem cria a tarefa a retoma com resume() e a destrói depois de ler o resultado.
+ */
+class QueryTask {
+public:
+    struct promise_type {
+        QueryResult result;
+        size_t slot = 0; // posição da consulta no escalonador
+
+        QueryTask get_return_object() { return QueryTask(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_value(QueryResult r) { result = std::move(r); }
+        void unhandled_exception() { std::terminate(); }
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit QueryTask(Handle h = nullptr) : handle(h) {}
+    QueryTask(QueryTask&& o) noexcept : handle(o.handle) { o.handle = nullptr; }
+    QueryTask& operator=(QueryTask&& o) noexcept {
+        if (this != &o) {
+            if (handle) handle.destroy();
+            handle = o.handle;
+            o.handle = nullptr;
+        }
+        return *this;
+    }
+    ~QueryTask() {
+        if (handle) handle.destroy();
+    }
+
+    Handle handle;
+};
+
+/**
+ * @brief A mesma busca de DiskIVF::query, como corrotina.
+ * @details Antes de varrer a primeira lista pede a leitura antecipada de todas
+ * as listas sondadas; cada lista ainda fria é esperada com co_await, e a
+ * thread segue com outras consultas enquanto as páginas chegam. A consulta é
+ * copiada para o quadro da corrotina.
+ */
+inline QueryTask queryAsync(const DiskIVF& index, PageFetcher& io, FeatureVector query_vec, int k) {
+    QueryResult result;
+    if (k <= 0 || !index.ok()) co_return result;
+    float qn[DiskIVF::DIM];
+    normalizeToFloat(query_vec, qn);
+    std::vector<int> lists = index.probe(qn, result);
+    for (int list : lists) index.prefetch(list);
+    CandidateHeap<const char*> heap(static_cast<size_t>(k));
+    for (int list : lists) {
+        co_await io.fetch(index.listData(list), index.listBytes(list));
+        index.scanList(list, qn, heap, result);
+    }
+    result.neighbors = index.collect(heap, k);
+    co_return result;
+}
+
+/**
+ * @brief Responde as consultas numa única thread, com até 'max_inflight' corrotinas em andamento.
+ * @details Enquanto as páginas de uma consulta são lidas, a thread retoma as
+ * que já estão prontas ou começa novas; só dorme quando todas as consultas em
+ * andamento esperam E/S. Com max_inflight = 1 o comportamento é o da busca
+ * síncrona (mais a troca de thread). Se 'latencies_ms' não for nulo, recebe o
+ * tempo de cada consulta desde que ela começou.
+ */
+inline std::vector<QueryResult> runAsyncQueries(const DiskIVF& index, PageFetcher& io,
+                                                const std::vector<FeatureVector>& queries, int k,
+                                                size_t max_inflight, std::vector<double>* latencies_ms = nullptr) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<QueryResult> results(queries.size());
+    if (latencies_ms) latencies_ms->assign(queries.size(), 0.0);
+    max_inflight = std::max<size_t>(1, max_inflight);
+
+    std::vector<QueryTask> tasks(queries.size());
+    std::vector<Clock::time_point> started(queries.size());
+    std::vector<std::coroutine_handle<>> runnable;
+    size_t next = 0, running = 0, finished = 0;
+
+    // Retoma a corrotina; se ela terminou, guarda o resultado e libera a vaga.
+    auto step = [&](std::coroutine_handle<> h) {
+        h.resume();
+        if (!h.done()) return; // suspensa à espera de páginas
+        auto& promise = QueryTask::Handle::from_address(h.address()).promise();
+        size_t slot = promise.slot;
+        results[slot] = std::move(promise.result);
+        if (latencies_ms) {
+            (*latencies_ms)[slot] = std::chrono::duration<double, std::milli>(Clock::now() - started[slot]).count();
+        }
+        tasks[slot] = QueryTask();
+        running--;
+        finished++;
+    };
+
+    while (finished < queries.size()) {
+        while (running < max_inflight && next < queries.size()) {
+            tasks[next] = queryAsync(index, io, queries[next], k);
+            tasks[next].handle.promise().slot = next;
+            started[next] = Clock::now();
+            running++;
+            step(tasks[next++].handle);
+        }
+        if (finished == queries.size()) break;
+        runnable.clear();
+        io.waitReady(runnable);
+        for (auto h : runnable) step(h);
+    }
+    return results;
+}
+
+#endif // ASYNC_QUERY_HPP
@@ -0,0 +1,335 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+#include <utility>
+
+#include "DataStructure.hpp"
+#include "Evaluation.hpp"
+#include "PerfCounters.hpp"
+
+/**
+ * @brief Origem das consultas de um experimento.
+ * - Random: amostra aleatória do próprio conjunto indexado (cada consulta tem um vizinho a distância 0).
+ * - HeldOut: amostra retirada do conjunto antes da indexação (consultas "novas").
+ * - Synthetic: vetores do conjunto com ruído gaussiano (perto dos dados, mas fora deles).
+ */
+enum class QuerySetKind { Random, HeldOut, Synthetic };
+
+inline const char* querySetName(QuerySetKind kind) {
+    switch (kind) {
+        case QuerySetKind::Random: return "random";
+        case QuerySetKind::HeldOut: return "heldout";
+        case QuerySetKind::Synthetic: return "synthetic";
+    }
+    return "?";
+}
+
+/**
+ * @brief Separa o conjunto de dados em vetores a indexar e consultas.
+ * @param dataset Conjunto completo.
+ * @param count Número de consultas (limitado ao tamanho do conjunto; no HeldOut sobra ao menos um vetor indexado).
+ * @param max_value Maior valor de um componente, usado para escalar o ruído das consultas sintéticas.
+ * @param seed Semente, para que o sorteio seja reprodutível.
+ * @return Par (vetores a indexar, consultas).
+ */
+inline std::pair<std::vector<FeatureVector>, std::vector<FeatureVector>>
+makeQuerySet(QuerySetKind kind, const std::vector<FeatureVector>& dataset, size_t count,
+             double max_value, unsigned seed = 7) {
+    std::vector<FeatureVector> indexed = dataset;
+    std::vector<FeatureVector> queries;
+    if (dataset.empty()) return {indexed, queries};
+
+    std::mt19937 rng(seed);
+    std::vector<size_t> order(dataset.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    if (kind == QuerySetKind::HeldOut) {
+        count = std::min(count, dataset.size() - 1);
+        std::vector<char> held(dataset.size(), 0);
+        for (size_t i = 0; i < count; ++i) {
+            held[order[i]] = 1;
+            queries.push_back(dataset[order[i]]);
+        }
+        indexed.clear();
+        for (size_t i = 0; i < dataset.size(); ++i) {
+            if (!held[i]) indexed.push_back(dataset[i]);
+        }
+        return {indexed, queries};
+    }
+
+    count = std::min(count, dataset.size());
+    std::normal_distribution<double> noise(0.0, 0.02 * max_value);
+    for (size_t i = 0; i < count; ++i) {
+        FeatureVector q = dataset[order[i]];
+        if (kind == QuerySetKind::Synthetic) {
+            for (int d = 0; d < FeatureVector::DIM; ++d) {
+                double x = static_cast<double>(q[d]) + noise(rng);
+                q[d] = static_cast<FeatureVector::ScalarType>(std::min(max_value, std::max(0.0, x)));
+            }
+            q.image_id = -1 - static_cast<int>(i); // não corresponde a nenhuma imagem
+        }
+        queries.push_back(q);
+    }
+    return {indexed, queries};
+}
+
+/**
+ * @struct BenchmarkConfig
+ * @brief Parâmetros de uma medição: passadas de aquecimento (não medidas) e repetições medidas.
+ */
+struct BenchmarkConfig {
+    int k = 5;
+    int warmup_passes = 1;
+    int repetitions = 5;
+    bool perf_counters = false; // mede ciclos, instruções, falhas de LLC e desvios mal previstos
+};
+
+/**
+ * @struct LatencyStats
+ * @brief Distribuição das latências de todas as consultas de todas as repetições (em ms).
+ */
+struct LatencyStats {
+    double mean = 0.0, stddev = 0.0, min = 0.0, max = 0.0;
+    double p50 = 0.0, p90 = 0.0, p99 = 0.0, p999 = 0.0;
+    double throughput_qps = 0.0; // consultas por segundo, média das repetições
+    size_t samples = 0;
+};
+
+/**
+ * @brief Percentil pelo método do posto mais próximo sobre amostras já ordenadas.
+ */
+inline double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+inline LatencyStats summarizeLatencies(std::vector<double> samples_ms) {
+    LatencyStats s;
+    s.samples = samples_ms.size();
+    if (samples_ms.empty()) return s;
+    std::sort(samples_ms.begin(), samples_ms.end());
+    s.min = samples_ms.front();
+    s.max = samples_ms.back();
+    s.mean = std::accumulate(samples_ms.begin(), samples_ms.end(), 0.0) / samples_ms.size();
+    double var = 0.0;
+    for (double x : samples_ms) var += (x - s.mean) * (x - s.mean);
+    s.stddev = samples_ms.size() > 1 ? std::sqrt(var / (samples_ms.size() - 1)) : 0.0;
+    s.p50 = percentile(samples_ms, 50.0);
+    s.p90 = percentile(samples_ms, 90.0);
+    s.p99 = percentile(samples_ms, 99.0);
+    s.p999 = percentile(samples_ms, 99.9);
+    return s;
+}
+
+/**
+ * @struct BenchmarkResult
+ * @brief Resultado de uma estrutura: latências, custo e qualidade.
+ * @details 'query_ms' e 'results' têm uma entrada por consulta (a mediana das
+ * repetições e os vizinhos da última repetição), para o relatório por consulta.
+ */
+struct BenchmarkResult {
+    std::string name;
+    LatencyStats latency;
+    double mean_comparisons = 0.0;
+    AccuracyMetrics accuracy;
+    PerfSample query_perf; // contadores de hardware por consulta (NaN se não medidos)
+    QueryStats stats;      // soma das estatísticas de percurso da última repetição
+    int repetitions = 0;   // repetições medidas de fato
+    std::vector<double> query_ms;
+    std::vector<QueryResult> results;
+};
+
+/**
+ * @brief Mede uma estrutura sobre um conjunto de consultas.
+ * @details Nada é impresso nem avaliado dentro dos laços medidos: cada
+ * repetição só chama query() e guarda a latência (steady_clock) num vetor
+ * pré-alocado. A avaliação contra os vizinhos exatos é feita depois.
+ */
+inline BenchmarkResult runBenchmark(const std::string& name, DataStructure& structure,
+                                    const std::vector<FeatureVector>& queries, const GroundTruth& truth,
+                                    const BenchmarkConfig& config) {
+    using Clock = std::chrono::steady_clock;
+    BenchmarkResult out;
+    out.name = name;
+    const size_t nq = queries.size();
+    if (nq == 0) return out;
+
+    // Aquecimento: carrega caches, preditores e estruturas preguiçosas (ex.: reconstruções).
+    for (int w = 0; w < config.warmup_passes; ++w) {
+        for (const auto& q : queries) structure.query(q, config.k);
+    }
+
+    int reps = std::max(1, config.repetitions);
+    out.repetitions = reps;
+    std::vector<double> samples(nq * reps);
+    std::vector<QueryResult> last(nq);
+    double qps_sum = 0.0;
+    // Os contadores cobrem todas as repetições (inclusive as leituras do relógio) e são divididos por consulta.
+    // Só são abertos se pedidos: cada PerfCounters abre seus descritores de perf_event.
+    std::optional<PerfCounters> counters;
+    if (config.perf_counters) counters.emplace();
+    bool measure = counters && counters->available();
+    if (measure) counters->start();
+    for (int r = 0; r < reps; ++r) {
+        auto rep_start = Clock::now();
+        for (size_t i = 0; i < nq; ++i) {
+            auto t0 = Clock::now();
+            QueryResult result = structure.query(queries[i], config.k);
+            auto t1 = Clock::now();
+            samples[r * nq + i] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            if (r == reps - 1) last[i] = std::move(result);
+        }
+        double rep_seconds = std::chrono::duration<double>(Clock::now() - rep_start).count();
+        if (rep_seconds > 0.0) qps_sum += nq / rep_seconds;
+    }
+    if (measure) out.query_perf = counters->stop().per(static_cast<double>(nq) * reps);
+
+    out.latency = summarizeLatencies(samples);
+    out.latency.throughput_qps = qps_sum / reps;
+
+    // Latência por consulta: mediana das repetições.
+    out.query_ms.resize(nq);
+    std::vector<double> per_query(reps);
+    for (size_t i = 0; i < nq; ++i) {
+        for (int r = 0; r < reps; ++r) per_query[r] = samples[r * nq + i];
+        std::nth_element(per_query.begin(), per_query.begin() + reps / 2, per_query.end());
+        out.query_ms[i] = per_query[reps / 2];
+    }
+
+    // Qualidade e custo, fora da medição.
+    out.accuracy.recall = out.accuracy.precision = out.accuracy.distance_ratio = 0.0;
+    for (size_t i = 0; i < nq; ++i) {
+        AccuracyMetrics acc = evaluateQuery(queries[i], last[i].neighbors, truth.neighbors[i], truth.distances[i]);
+        out.accuracy.recall += acc.recall;
+        out.accuracy.precision += acc.precision;
+        out.accuracy.distance_ratio += acc.distance_ratio;
+        out.mean_comparisons += last[i].comparisons;
+        out.stats.accumulate(last[i].stats);
+    }
+    out.accuracy.recall /= nq;
+    out.accuracy.precision /= nq;
+    out.accuracy.distance_ratio /= nq;
+    out.mean_comparisons /= nq;
+    out.results = std::move(last);
+    return out;
+}
+
+/**
+ * @brief Formato da tabela de resultados.
+ * - Csv / Tsv: cabeçalho e uma linha por registro, separados por vírgula ou tabulação.
+ * - Json: JSON Lines, um objeto por linha (números sem aspas).
+ */
+enum class TableFormat { Csv, Tsv, Json };
+
+/**
+ * @class ResultTable
+ * @brief Escreve registros com colunas fixas no formato escolhido.
+ */
+class ResultTable {
+public:
+    ResultTable(std::ostream& os, TableFormat format, std::vector<std::string> columns)
+        : os(os), format(format), columns(std::move(columns)) {
+        if (format == TableFormat::Json) return;
+        for (size_t i = 0; i < this->columns.size(); ++i) os << (i ? separator() : "") << this->columns[i];
+        os << "\n";
+    }
+
+    void row(const std::vector<std::string>& values) {
+        if (format == TableFormat::Json) {
+            os << "{";
+            for (size_t i = 0; i < columns.size() && i < values.size(); ++i) {
+                os << (i ? ", " : "") << "\"" << columns[i] << "\": " << jsonValue(values[i]);
+            }
+            os << "}\n";
+            return;
+        }
+        for (size_t i = 0; i < values.size(); ++i) os << (i ? separator() : "") << values[i];
+        os << "\n";
+    }
+
+private:
+    std::ostream& os;
+    TableFormat format;
+    std::vector<std::string> columns;
+
+    const char* separator() const { return format == TableFormat::Tsv ? "\t" : ","; }
+
+    // Números saem como estão; vazios e não finitos (nan, -nan, inf, infinity...) viram null, que o JSON aceita.
+    static std::string jsonValue(const std::string& v) {
+        if (v.empty()) return "null";
+        char* end = nullptr;
+        double x = std::strtod(v.c_str(), &end);
+        if (end && *end == '\0') return std::isfinite(x) ? v : "null";
+        std::string quoted = "\"";
+        for (char c : v) {
+            if (c == '"' || c == '\\') quoted += '\\';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+};
+
+/**
+ * @struct BuildInfo
+ * @brief Custo da construção de uma estrutura: tempo, memória e contadores de hardware.
+ */
+struct BuildInfo {
+    size_t vectors = 0;     // vetores indexados
+    double ms = 0.0;
+    MemoryUsage memory;     // memoryUsage() da estrutura construída
+    long long heap_bytes = -1; // bytes vivos a mais no heap após a construção (-1 sem o contador)
+    PerfSample perf;
+};
+
+/**
+ * @brief Colunas e valores da tabela de resultados (um registro por estrutura, parâmetros e k).
+ */
+inline std::vector<std::string> summaryColumns() {
+    std::vector<std::string> columns = {"estrutura", "parametros", "k", "consultas", "vetores", "conjunto_consultas", "repeticoes", "construcao_ms",
+            "memoria_bytes", "memoria_payload_bytes", "memoria_overhead_bytes", "memoria_folga_bytes", "memoria_heap_bytes",
+            "media_ms", "desvio_ms", "p50_ms", "p90_ms", "p99_ms", "p999_ms", "max_ms", "throughput_qps",
+            "comparacoes", "recall_at_k", "precision_at_k", "distance_ratio",
+            "construcao_ciclos", "construcao_instrucoes", "construcao_llc_misses", "construcao_branch_misses",
+            "consulta_ciclos", "consulta_instrucoes", "consulta_llc_misses", "consulta_branch_misses"};
+    // Estatísticas de percurso (média por consulta), se compiladas.
+    for (const auto& c : QueryStats::columns()) columns.push_back(c);
+    return columns;
+}
+
+inline std::vector<std::string> summaryValues(const BenchmarkResult& r, const std::string& params,
+                                              QuerySetKind kind, const BenchmarkConfig& config, const BuildInfo& build) {
+    auto num = [](double x) {
+        if (std::isnan(x)) return std::string(); // contador indisponível: campo vazio
+        std::ostringstream ss;
+        ss << x;
+        return ss.str();
+    };
+    std::vector<std::string> values = {r.name, params, std::to_string(config.k), std::to_string(r.results.size()),
+            std::to_string(build.vectors), querySetName(kind),
+            std::to_string(r.repetitions), num(build.ms),
+            std::to_string(build.memory.total()), std::to_string(build.memory.payload),
+            std::to_string(build.memory.overhead), std::to_string(build.memory.slack),
+            build.heap_bytes < 0 ? std::string() : std::to_string(build.heap_bytes), num(r.latency.mean), num(r.latency.stddev),
+            num(r.latency.p50), num(r.latency.p90), num(r.latency.p99), num(r.latency.p999), num(r.latency.max),
+            num(r.latency.throughput_qps), num(r.mean_comparisons), num(r.accuracy.recall),
+            num(r.accuracy.precision), num(r.accuracy.distance_ratio)};
+    for (const PerfSample* perf : {&build.perf, &r.query_perf}) {
+        for (double v : perf->values) values.push_back(num(v));
+    }
+    for (double v : r.stats.values()) values.push_back(num(r.results.empty() ? 0.0 : v / r.results.size()));
+    return values;
+}
+
+#endif // BENCHMARK_HPP
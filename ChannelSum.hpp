@@ -0,0 +1,290 @@
+// ChannelSum.hpp
+
+#ifndef CHANNEL_SUM_HPP
+#define CHANNEL_SUM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @struct ChannelTotals
+ * @brief Soma acumulada dos canais R, G e B de uma imagem.
+ * * Usamos inteiros de 64 bits: mesmo uma imagem de 2^32 pixels brancos
+ * (255 * 2^32) cabe folgadamente no acumulador.
+ */
+struct ChannelTotals {
+    unsigned long long r = 0, g = 0, b = 0;
+};
+
+/**
+ * @brief Versão escalar (referência) da soma de canais.
+ * @details Percorre os pixels com um ponteiro que avança 'channels' bytes por vez,
+ * evitando a multiplicação i * channels a cada acesso. Serve de fallback para
+ * arquiteturas sem SIMD e para as sobras (cauda) dos laços vetorizados.
+ * @param data Pixels intercalados (RGBRGB... ou RGBARGBA...).
+ * @param num_pixels Número de pixels a somar.
+ * @param channels Número de canais por pixel (>= 3).
+ */
+inline ChannelTotals sumChannelsScalar(const unsigned char* data, size_t num_pixels, int channels) {
+    ChannelTotals t;
+    const unsigned char* p = data;
+    for (size_t i = 0; i < num_pixels; ++i, p += channels) {
+        t.r += p[0];
+        t.g += p[1];
+        t.b += p[2];
+    }
+    return t;
+}
+
+namespace channel_sum_detail {
+
+// Máscaras para imagens de 3 canais. Um bloco de 3 registradores de W bytes
+// contém W pixels; o byte i do registrador t pertence ao canal (t*W + i) % 3.
+// masks[c][t] seleciona, no registrador t, os bytes do canal c. Para um mesmo
+// canal as três máscaras cobrem posições disjuntas, então
+// (x0 & m[c][0]) | (x1 & m[c][1]) | (x2 & m[c][2]) reúne W bytes do canal c
+// num único registrador, que é somado com uma só instrução SAD.
+template <int W>
+struct Rgb3Masks {
+    alignas(32) unsigned char bytes[3][3][W];
+
+    constexpr Rgb3Masks() : bytes() {
+        for (int c = 0; c < 3; ++c)
+            for (int t = 0; t < 3; ++t)
+                for (int i = 0; i < W; ++i)
+                    bytes[c][t][i] = ((t * W + i) % 3 == c) ? 0xFF : 0x00;
+    }
+};
+
+} // namespace channel_sum_detail
+
+#if defined(__AVX2__)
+
+/**
+ * @brief Soma de canais com AVX2: 32 pixels (96 bytes) por iteração em imagens RGB,
+ * 8 pixels (32 bytes) por iteração em imagens RGBA.
+ */
+inline ChannelTotals sumChannelsSimd(const unsigned char* data, size_t num_pixels, int channels) {
+    if (channels != 3 && channels != 4) return sumChannelsScalar(data, num_pixels, channels);
+
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc_r = zero, acc_g = zero, acc_b = zero;
+    size_t i = 0;
+
+    if (channels == 3) {
+        static constexpr channel_sum_detail::Rgb3Masks<32> M{};
+        __m256i m[3][3];
+        for (int c = 0; c < 3; ++c)
+            for (int t = 0; t < 3; ++t)
+                m[c][t] = _mm256_load_si256(reinterpret_cast<const __m256i*>(M.bytes[c][t]));
+
+        for (; i + 32 <= num_pixels; i += 32) {
+            const unsigned char* p = data + i * 3;
+            __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+            __m256i x2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 64));
+
+            __m256i r = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(x0, m[0][0]), _mm256_and_si256(x1, m[0][1])), _mm256_and_si256(x2, m[0][2]));
+            __m256i g = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(x0, m[1][0]), _mm256_and_si256(x1, m[1][1])), _mm256_and_si256(x2, m[1][2]));
+            __m256i b = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(x0, m[2][0]), _mm256_and_si256(x1, m[2][1])), _mm256_and_si256(x2, m[2][2]));
+
+            acc_r = _mm256_add_epi64(acc_r, _mm256_sad_epu8(r, zero));
+            acc_g = _mm256_add_epi64(acc_g, _mm256_sad_epu8(g, zero));
+            acc_b = _mm256_add_epi64(acc_b, _mm256_sad_epu8(b, zero));
+        }
+    } else {
+        const __m256i mr = _mm256_set1_epi32(0x000000FF);
+        const __m256i mg = _mm256_set1_epi32(0x0000FF00);
+        const __m256i mb = _mm256_set1_epi32(0x00FF0000);
+        for (; i + 8 <= num_pixels; i += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i * 4));
+            acc_r = _mm256_add_epi64(acc_r, _mm256_sad_epu8(_mm256_and_si256(x, mr), zero));
+            acc_g = _mm256_add_epi64(acc_g, _mm256_sad_epu8(_mm256_and_si256(x, mg), zero));
+            acc_b = _mm256_add_epi64(acc_b, _mm256_sad_epu8(_mm256_and_si256(x, mb), zero));
+        }
+    }
+
+    alignas(32) unsigned long long lanes[3][4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[0]), acc_r);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[1]), acc_g);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[2]), acc_b);
+
+    ChannelTotals t = sumChannelsScalar(data + i * channels, num_pixels - i, channels);
+    t.r += lanes[0][0] + lanes[0][1] + lanes[0][2] + lanes[0][3];
+    t.g += lanes[1][0] + lanes[1][1] + lanes[1][2] + lanes[1][3];
+    t.b += lanes[2][0] + lanes[2][1] + lanes[2][2] + lanes[2][3];
+    return t;
+}
+
+#elif defined(__SSE2__)
+
+/**
+ * @brief Soma de canais com SSE2: 16 pixels (48 bytes) por iteração em imagens RGB,
+ * 4 pixels (16 bytes) por iteração em imagens RGBA.
+ */
+inline ChannelTotals sumChannelsSimd(const unsigned char* data, size_t num_pixels, int channels) {
+    if (channels != 3 && channels != 4) return sumChannelsScalar(data, num_pixels, channels);
+
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc_r = zero, acc_g = zero, acc_b = zero;
+    size_t i = 0;
+
+    if (channels == 3) {
+        static constexpr channel_sum_detail::Rgb3Masks<16> M{};
+        __m128i m[3][3];
+        for (int c = 0; c < 3; ++c)
+            for (int t = 0; t < 3; ++t)
+                m[c][t] = _mm_load_si128(reinterpret_cast<const __m128i*>(M.bytes[c][t]));
+
+        for (; i + 16 <= num_pixels; i += 16) {
+            const unsigned char* p = data + i * 3;
+            __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+            __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+
+            __m128i r = _mm_or_si128(_mm_or_si128(_mm_and_si128(x0, m[0][0]), _mm_and_si128(x1, m[0][1])), _mm_and_si128(x2, m[0][2]));
+            __m128i g = _mm_or_si128(_mm_or_si128(_mm_and_si128(x0, m[1][0]), _mm_and_si128(x1, m[1][1])), _mm_and_si128(x2, m[1][2]));
+            __m128i b = _mm_or_si128(_mm_or_si128(_mm_and_si128(x0, m[2][0]), _mm_and_si128(x1, m[2][1])), _mm_and_si128(x2, m[2][2]));
+
+            acc_r = _mm_add_epi64(acc_r, _mm_sad_epu8(r, zero));
+            acc_g = _mm_add_epi64(acc_g, _mm_sad_epu8(g, zero));
+            acc_b = _mm_add_epi64(acc_b, _mm_sad_epu8(b, zero));
+        }
+    } else {
+        const __m128i mr = _mm_set1_epi32(0x000000FF);
+        const __m128i mg = _mm_set1_epi32(0x0000FF00);
+        const __m128i mb = _mm_set1_epi32(0x00FF0000);
+        for (; i + 4 <= num_pixels; i += 4) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 4));
+            acc_r = _mm_add_epi64(acc_r, _mm_sad_epu8(_mm_and_si128(x, mr), zero));
+            acc_g = _mm_add_epi64(acc_g, _mm_sad_epu8(_mm_and_si128(x, mg), zero));
+            acc_b = _mm_add_epi64(acc_b, _mm_sad_epu8(_mm_and_si128(x, mb), zero));
+        }
+    }
+
+    alignas(16) unsigned long long lanes[3][2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[0]), acc_r);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[1]), acc_g);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[2]), acc_b);
+
+    ChannelTotals t = sumChannelsScalar(data + i * channels, num_pixels - i, channels);
+    t.r += lanes[0][0] + lanes[0][1];
+    t.g += lanes[1][0] + lanes[1][1];
+    t.b += lanes[2][0] + lanes[2][1];
+    return t;
+}
+
+#else
+
+// Sem SIMD disponível: usa a versão escalar.
+inline ChannelTotals sumChannelsSimd(const unsigned char* data, size_t num_pixels, int channels) {
+    return sumChannelsScalar(data, num_pixels, channels);
+}
+
+#endif
+
+/**
+ * @brief Soma os canais R, G e B de uma imagem, escolhendo o melhor kernel disponível.
+ * @details A escolha é feita em tempo de compilação (-mavx2, SSE2 é padrão em x86-64).
+ * Imagens com 3 ou 4 canais usam o caminho vetorizado; as demais, o escalar.
+ */
+inline ChannelTotals sumChannels(const unsigned char* data, size_t num_pixels, int channels) {
+    return sumChannelsSimd(data, num_pixels, channels);
+}
+
+/**
+ * @struct ChannelSample
+ * @brief Resultado de uma amostragem (possivelmente subamostrada) dos pixels de uma imagem.
+ * * Além das somas por canal, guarda a soma dos quadrados, usada para estimar
+ * o erro da média amostral em relação à média da imagem completa.
+ */
+struct ChannelSample {
+    ChannelTotals sum;
+    ChannelTotals sum_sq;
+    size_t count = 0;       // pixels amostrados
+    size_t population = 0;  // pixels da imagem completa
+
+    double mean(unsigned long long total) const {
+        return count ? static_cast<double>(total) / count : 0.0;
+    }
+
+    /**
+     * @brief Limite de erro (intervalo de confiança de ~95%) da média de um canal.
+     * @details Usa o erro padrão da média amostral com correção de população finita:
+     * z * sqrt(var / n * (1 - n / N)). É zero quando todos os pixels foram lidos.
+     */
+    double errorBound(unsigned long long total, unsigned long long total_sq, double z = 1.96) const {
+        if (count == 0 || count >= population) return 0.0;
+        double n = static_cast<double>(count);
+        double m = static_cast<double>(total) / n;
+        double var = static_cast<double>(total_sq) / n - m * m;
+        if (var < 0.0) var = 0.0;
+        double fpc = 1.0 - n / static_cast<double>(population);
+        return z * std::sqrt(var / n * fpc);
+    }
+
+    // Maior limite de erro entre os três canais.
+    double maxErrorBound() const {
+        double er = errorBound(sum.r, sum_sq.r);
+        double eg = errorBound(sum.g, sum_sq.g);
+        double eb = errorBound(sum.b, sum_sq.b);
+        return std::fmax(er, std::fmax(eg, eb));
+    }
+};
+
+/**
+ * @brief Soma os canais de uma imagem lendo apenas um pixel a cada 'stride' linhas e colunas.
+ * @details Com stride 1 todos os pixels são lidos pelo kernel SIMD e o erro é nulo.
+ * Com stride > 1 a grade é percorrida de forma escalar (o custo já cai por stride^2)
+ * e a soma dos quadrados é acumulada para o cálculo do limite de erro.
+ */
+inline ChannelSample sampleChannels(const unsigned char* data, int width, int height,
+                                    int channels, int stride) {
+    ChannelSample s;
+    s.population = static_cast<size_t>(width) * static_cast<size_t>(height);
+    if (stride <= 1) {
+        s.sum = sumChannels(data, s.population, channels);
+        s.count = s.population;
+        return s;
+    }
+
+    const size_t row_bytes = static_cast<size_t>(width) * channels;
+    const size_t step = static_cast<size_t>(stride) * channels;
+    for (int y = 0; y < height; y += stride) {
+        const unsigned char* p = data + static_cast<size_t>(y) * row_bytes;
+        const unsigned char* end = p + row_bytes;
+        for (; p < end; p += step) {
+            unsigned r = p[0], g = p[1], b = p[2];
+            s.sum.r += r;        s.sum.g += g;        s.sum.b += b;
+            s.sum_sq.r += r * r; s.sum_sq.g += g * g; s.sum_sq.b += b * b;
+            s.count++;
+        }
+    }
+    return s;
+}
+
+/**
+ * @brief Soma os canais de pixels já subamostrados (um buffer compacto) de uma imagem com 'population' pixels.
+ * @details Acumula a soma dos quadrados como sampleChannels com stride > 1, para o limite de erro.
+ */
+inline ChannelSample sampleCompact(const unsigned char* data, size_t num_pixels, int channels, size_t population) {
+    ChannelSample s;
+    s.population = population;
+    const unsigned char* end = data + num_pixels * channels;
+    for (const unsigned char* p = data; p < end; p += channels) {
+        unsigned r = p[0], g = p[1], b = p[2];
+        s.sum.r += r;        s.sum.g += g;        s.sum.b += b;
+        s.sum_sq.r += r * r; s.sum_sq.g += g * g; s.sum_sq.b += b * b;
+    }
+    s.count = num_pixels;
+    return s;
+}
+
+#endif // CHANNEL_SUM_HPP
@@ -0,0 +1,58 @@
+// ColorHistogram.hpp
+
+#ifndef COLOR_HISTOGRAM_HPP
+#define COLOR_HISTOGRAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Número de bins por canal de um histograma RGB com 'total_bins' bins,
+ * ou 0 se o valor não for suportado.
+ * @details O histograma é conjunto (R x G x B) com o mesmo número de bins por canal,
+ * que precisa ser potência de 2 para que o bin seja obtido com um deslocamento.
+ * Valores aceitos: 8 (2^3), 64 (4^3), 512 (8^3) e 4096 (16^3).
+ */
+inline int histogramBinsPerChannel(int total_bins) {
+    for (int b = 2; b <= 16; b *= 2) {
+        if (b * b * b == total_bins) return b;
+    }
+    return 0;
+}
+
+/**
+ * @brief Calcula o histograma de cor normalizado de uma imagem.
+ * @details Cada pixel amostrado (1 a cada 'stride' linhas e colunas) incrementa o bin
+ * (r >> s, g >> s, b >> s), onde s = 8 - log2(bins_per_channel). O resultado é
+ * dividido pelo número de pixels amostrados, então seus componentes somam 1.
+ * @param out Recebe bins_per_channel^3 valores.
+ */
+inline void colorHistogram(const unsigned char* data, int width, int height, int channels,
+                           int stride, int bins_per_channel, std::vector<double>& out) {
+    int shift = 8;
+    for (int b = bins_per_channel; b > 1; b >>= 1) shift--;
+    const int bins = bins_per_channel;
+
+    std::vector<uint64_t> counts(static_cast<size_t>(bins) * bins * bins, 0);
+    const size_t row_bytes = static_cast<size_t>(width) * channels;
+    const size_t step = static_cast<size_t>(stride) * channels;
+    size_t sampled = 0;
+
+    for (int y = 0; y < height; y += stride) {
+        const unsigned char* p = data + static_cast<size_t>(y) * row_bytes;
+        const unsigned char* end = p + row_bytes;
+        for (; p < end; p += step) {
+            int idx = ((p[0] >> shift) * bins + (p[1] >> shift)) * bins + (p[2] >> shift);
+            counts[idx]++;
+            sampled++;
+        }
+    }
+
+    out.assign(counts.size(), 0.0);
+    if (sampled == 0) return;
+    const double inv = 1.0 / static_cast<double>(sampled);
+    for (size_t i = 0; i < counts.size(); ++i) out[i] = counts[i] * inv;
+}
+
+#endif // COLOR_HISTOGRAM_HPP
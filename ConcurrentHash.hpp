@@ -0,0 +1,329 @@
+#ifndef CONCURRENT_HASH_HPP
+#define CONCURRENT_HASH_HPP
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <functional>
+#include <unordered_set>
+#include <algorithm>
+#include <utility>
+
+#include "DataStructure.hpp"
+#include "EpochReclaimer.hpp"
+#include "Hash.hpp" // lshBucket: mesmas tabelas e buckets da HashTable
+
+/**
+ * @class ConcurrentHashTable
+ * @brief Índice LSH que aceita inserções e consultas ao mesmo tempo, sem locks.
+ * * Mesmo esquema da HashTable (numHashes tabelas com grades deslocadas), com
+ * três diferenças:
+ * - Cada vetor é guardado uma vez só, num nó que participa das listas de todas
+ *   as tabelas (um ponteiro 'next' por tabela), em vez de uma cópia por tabela.
+ * - A inserção publica o nó no início de cada bucket com compare_exchange
+ *   (release). O 'next' de uma tabela é escrito antes de o nó entrar nela, então
+ *   quem lê a lista vê sempre uma cadeia consistente.
+ * - A consulta só faz loads (acquire) e percorre cadeias finitas; a única
+ *   escrita compartilhada é o anúncio da sua época num slot próprio. A
+ *   consulta é lock-free, não wait-free: ocupar o slot nunca espera outra
+ *   operação terminar (acima de EpochReclaimer::MAX_READERS operações
+ *   simultâneas entra um slot extra), mas o CAS que acrescenta um slot extra
+ *   pode repetir se outra thread acrescentar um ao mesmo tempo.
+ *
+ * A remoção marca o nó como apagado (tombstone), também sem lock; o nó é achado
+ * por um índice de image_id com o mesmo esquema de publicação. Quando os apagados
+ * passam de MAX_DEAD_FRACTION, quem removeu desliga os apagados das cadeias (só
+ * uma compactação por vez; as inserções e consultas continuam rodando). Um nó
+ * desligado continua apontando para o resto da cadeia, então uma consulta que
+ * estava nele segue normalmente.
+ *
+ * Os nós desligados são liberados por épocas (EpochReclaimer, o mesmo da
+ * SnapshotQuadtree): cada consulta, remoção ou atualização anuncia num slot a
+ * época em que começou, e um lote desligado só é apagado, numa compactação
+ * seguinte, quando todas as operações ativas começaram depois de ele ser
+ * desligado. Assim a memória fica limitada sob remoções contínuas. Só a
+ * compactação (uma por vez) libera nós e ela nunca libera um nó do seu próprio
+ * lote ainda ligado, então o CAS no início das listas não sofre ABA. Uma consulta concorrente com inserções vê
+ * cada vetor em todas as suas tabelas ou em parte delas (ainda sendo publicado).
+ */
+class ConcurrentHashTable : public DataStructure {
+private:
+    struct Node {
+        FeatureVector data;
+        std::vector<std::atomic<Node*>> next; // next[h] = próximo nó no bucket da tabela h
+        std::atomic<Node*> idNext;            // próximo nó no bucket do índice de IDs
+        std::atomic<bool> dead;
+
+        Node(const FeatureVector& v, int hashes) : data(v), next(hashes), idNext(nullptr), dead(false) {}
+    };
+
+    using Bucket = std::atomic<Node*>;
+
+    int numBuckets;
+    int numHashes;
+    double binSize;
+    std::vector<std::unique_ptr<Bucket[]>> tables;
+    std::unique_ptr<Bucket[]> ids; // índice de image_id (publicado depois de todas as tabelas)
+    std::atomic<size_t> count;
+    std::atomic<size_t> deadCount;
+
+    EpochReclaimer<Node> epochs;    // retire() protegido por compactLock
+    mutable std::mutex compactLock; // uma compactação por vez
+
+    int idBucket(int image_id) const {
+        return static_cast<int>(static_cast<unsigned int>(image_id) % static_cast<unsigned int>(numBuckets));
+    }
+
+    // Coloca o nó no início da lista; 'link' é o ponteiro do nó para o próximo nessa lista.
+    // Lê o início com acquire: update() percorre a lista a partir do nó que acabou de publicar.
+    static void publish(Bucket& head, std::atomic<Node*>& link, Node* node) {
+        Node* expected = head.load(std::memory_order_acquire);
+        do {
+            link.store(expected, std::memory_order_relaxed);
+        } while (!head.compare_exchange_weak(expected, node, std::memory_order_acq_rel, std::memory_order_acquire));
+    }
+
+    // Nó vivo com o image_id dado, ou nullptr.
+    Node* findLive(int image_id) const {
+        Node* node = ids[idBucket(image_id)].load(std::memory_order_acquire);
+        for (; node; node = node->idNext.load(std::memory_order_acquire)) {
+            if (node->data.image_id == image_id && !node->dead.load(std::memory_order_acquire)) return node;
+        }
+        return nullptr;
+    }
+
+    // Publica um nó novo em todas as tabelas e, por último, no índice de IDs.
+    Node* insertNode(const FeatureVector& vec) {
+        Node* node = new Node(vec, numHashes);
+        for (int h = 0; h < numHashes; ++h) {
+            publish(tables[h][lshBucket(vec, h, binSize, numHashes, numBuckets)], node->next[h], node);
+        }
+        count.fetch_add(1, std::memory_order_relaxed);
+        // Por último no índice de IDs: remove() só acha nós presentes em todas as tabelas.
+        publish(ids[idBucket(vec.image_id)], node->idNext, node);
+        return node;
+    }
+
+    // Marca o nó como apagado; false se outra thread chegou antes. A compactação fica para quem chamou,
+    // depois de sair do slot (compactDue): o slot dele seguraria o lote que ela acabou de desligar.
+    bool kill(Node* node) {
+        bool expected = false;
+        if (!node->dead.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) return false;
+        count.fetch_sub(1, std::memory_order_relaxed);
+        deadCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool compactDue() const {
+        size_t d = deadCount.load(std::memory_order_relaxed);
+        return compactionDue(d, count.load(std::memory_order_relaxed) + d);
+    }
+
+    // Desliga de uma lista os nós de 'victims'. Só o início da lista disputa com as inserções;
+    // os ponteiros do meio só são alterados pela compactação.
+    template <typename Link>
+    static void unlinkFrom(Bucket& head, const std::unordered_set<Node*>& victims, Link link) {
+        Node* first = head.load(std::memory_order_acquire);
+        while (first && victims.count(first)) {
+            Node* after = link(first).load(std::memory_order_acquire);
+            // Se falhar, 'first' passa a ser o início atual (um nó recém-inserido ou o mesmo).
+            head.compare_exchange_strong(first, after, std::memory_order_acq_rel, std::memory_order_acquire);
+        }
+        for (Node* prev = first; prev;) {
+            Node* cur = link(prev).load(std::memory_order_acquire);
+            Node* keep = cur;
+            while (keep && victims.count(keep)) keep = link(keep).load(std::memory_order_acquire);
+            if (keep != cur) link(prev).store(keep, std::memory_order_release);
+            prev = keep;
+        }
+    }
+
+public:
+    ConcurrentHashTable(int buckets = 1013, int hashes = 5, double bin = 25)
+        : numBuckets(buckets), numHashes(hashes), binSize(bin), ids(new Bucket[buckets]), count(0), deadCount(0) {
+        for (int h = 0; h < numHashes; ++h) {
+            tables.emplace_back(new Bucket[numBuckets]);
+            for (int b = 0; b < numBuckets; ++b) tables[h][b].store(nullptr, std::memory_order_relaxed);
+        }
+        for (int b = 0; b < numBuckets; ++b) ids[b].store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~ConcurrentHashTable() override {
+        // Todo nó ainda ligado está na tabela 0, então percorrê-la libera cada um exatamente uma vez.
+        if (!tables.empty()) {
+            for (int b = 0; b < numBuckets; ++b) {
+                Node* node = tables[0][b].load(std::memory_order_relaxed);
+                while (node) {
+                    Node* tmp = node;
+                    node = node->next[0].load(std::memory_order_relaxed);
+                    delete tmp;
+                }
+            }
+        }
+        // Os lotes desligados são liberados por 'epochs'.
+    }
+
+    ConcurrentHashTable(const ConcurrentHashTable&) = delete;
+    ConcurrentHashTable& operator=(const ConcurrentHashTable&) = delete;
+
+    // Pode ser chamada por várias threads, junto com query() e remove().
+    void insert(const FeatureVector& vec) override { insertNode(vec); }
+
+    // Pode ser chamada por várias threads, junto com insert() e query().
+    bool remove(int image_id) override {
+        auto* slot = epochs.enterRead();
+        bool removed = false;
+        for (Node* node = findLive(image_id); node && !removed; node = findLive(image_id)) removed = kill(node);
+        epochs.exitRead(slot);
+        if (removed && compactDue()) compact();
+        return removed;
+    }
+
+    // O vetor novo é publicado antes de o antigo ser apagado: uma consulta concorrente vê ao menos um dos dois.
+    // Depois de publicar, apaga todo nó vivo com o mesmo ID publicado antes do novo (os que vêm depois dele no
+    // índice de IDs). Com duas atualizações simultâneas do mesmo ID, só a publicada por último fica viva, e as
+    // duas devolvem true se havia um vetor antes delas.
+    bool update(const FeatureVector& vec) override {
+        auto* slot = epochs.enterRead();
+        bool existed = findLive(vec.image_id) != nullptr;
+        Node* fresh = insertNode(vec);
+        for (Node* node = fresh->idNext.load(std::memory_order_acquire); node;
+             node = node->idNext.load(std::memory_order_acquire)) {
+            if (node->data.image_id == vec.image_id && kill(node)) existed = true;
+        }
+        epochs.exitRead(slot);
+        if (compactDue()) compact();
+        return existed;
+    }
+
+    /**
+     * @brief Desliga das cadeias todos os nós apagados até agora.
+     * @details Chamada automaticamente por remove(); pode rodar junto com inserções e consultas.
+     * Se outra compactação já está em andamento, retorna sem fazer nada.
+     */
+    void compact() {
+        std::unique_lock<std::mutex> guard(compactLock, std::try_to_lock);
+        if (!guard.owns_lock() || tables.empty()) return;
+        // Os apagados são nós completamente publicados (remove() os achou pelo índice de IDs).
+        std::unordered_set<Node*> victims;
+        for (int b = 0; b < numBuckets; ++b) {
+            for (Node* node = tables[0][b].load(std::memory_order_acquire); node;
+                 node = node->next[0].load(std::memory_order_acquire)) {
+                if (node->dead.load(std::memory_order_acquire)) victims.insert(node);
+            }
+        }
+        if (victims.empty()) return;
+        for (int h = 0; h < numHashes; ++h) {
+            for (int b = 0; b < numBuckets; ++b) {
+                unlinkFrom(tables[h][b], victims, [h](Node* n) -> std::atomic<Node*>& { return n->next[h]; });
+            }
+        }
+        for (int b = 0; b < numBuckets; ++b) {
+            unlinkFrom(ids[b], victims, [](Node* n) -> std::atomic<Node*>& { return n->idNext; });
+        }
+        deadCount.fetch_sub(victims.size(), std::memory_order_relaxed);
+        epochs.retire(std::vector<Node*>(victims.begin(), victims.end()));
+    }
+
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+    // true se o vetor (mesmo image_id) está vivo e já publicado no seu bucket de todas as tabelas.
+    bool contains(const FeatureVector& vec) const {
+        auto* slot = epochs.enterRead();
+        bool found = true;
+        for (int h = 0; h < numHashes && found; ++h) {
+            const Node* node = tables[h][lshBucket(vec, h, binSize, numHashes, numBuckets)].load(std::memory_order_acquire);
+            while (node && (node->data.image_id != vec.image_id || node->dead.load(std::memory_order_acquire))) {
+                node = node->next[h].load(std::memory_order_acquire);
+            }
+            found = node != nullptr;
+        }
+        epochs.exitRead(slot);
+        return found;
+    }
+
+    // Pode ser chamada por várias threads, junto com insert() e remove().
+    QueryResult query(const FeatureVector& q, int k) override {
+        QueryResult result;
+        if (k <= 0) return result;
+
+        // Como cada vetor tem um único nó, a deduplicação entre tabelas é pelo endereço.
+        // Os candidatos são lidos até copiar os vizinhos, então o slot fica ocupado até o fim.
+        auto* slot = epochs.enterRead();
+        std::vector<const Node*> candidates;
+        for (int h = 0; h < numHashes; ++h) {
+            const Node* node = tables[h][lshBucket(q, h, binSize, numHashes, numBuckets)].load(std::memory_order_acquire);
+            size_t chain = 0;
+            for (; node; node = node->next[h].load(std::memory_order_acquire)) {
+                ++chain;
+                if (node->dead.load(std::memory_order_acquire)) {
+                    result.stats.skipDead();
+                    continue;
+                }
+                candidates.push_back(node);
+            }
+            result.stats.probeBucket(chain);
+            result.stats.touch(sizeof(Bucket) + chain * sizeof(Node));
+        }
+        std::sort(candidates.begin(), candidates.end());
+        auto last = std::unique(candidates.begin(), candidates.end());
+        for (auto it = last; it != candidates.end(); ++it) result.stats.duplicateHit();
+        candidates.erase(last, candidates.end());
+
+        // Os k mais próximos com um max-heap.
+        using Pair = std::pair<double, const Node*>;
+        std::priority_queue<Pair> best;
+        for (const Node* c : candidates) {
+            double dist = q.distanceTo(c->data);
+            result.comparisons++;
+            if (best.size() < static_cast<size_t>(k)) {
+                best.emplace(dist, c);
+            } else if (dist < best.top().first) {
+                best.pop();
+                best.emplace(dist, c);
+            }
+        }
+        result.neighbors.resize(best.size());
+        for (size_t i = best.size(); i-- > 0; best.pop()) result.neighbors[i] = best.top().second->data;
+        epochs.exitRead(slot);
+        return result;
+    }
+
+    // Nós apagados ou desligados (ainda não liberados) contam como overhead.
+    MemoryUsage memoryUsage() const override {
+        MemoryUsage usage;
+        usage.addObject(sizeof(*this));
+        usage.addVector(tables);
+        for (const auto& t : tables) usage.addBlock(t.get(), numBuckets * sizeof(Bucket), numBuckets * sizeof(Bucket));
+        usage.addBlock(ids.get(), numBuckets * sizeof(Bucket), numBuckets * sizeof(Bucket));
+        auto addNode = [&usage](const Node* node) {
+            usage.addBlock(node, sizeof(Node), sizeof(Node));
+            usage.addVector(node->next);
+        };
+        auto* slot = epochs.enterRead();
+        size_t n = 0;
+        if (!tables.empty()) {
+            for (int b = 0; b < numBuckets; ++b) {
+                for (const Node* node = tables[0][b].load(std::memory_order_acquire); node;
+                     node = node->next[0].load(std::memory_order_acquire)) {
+                    addNode(node);
+                    if (!node->dead.load(std::memory_order_relaxed)) n++;
+                }
+            }
+        }
+        epochs.exitRead(slot);
+        {
+            std::lock_guard<std::mutex> guard(compactLock);
+            epochs.forEachRetired([&](const std::vector<Node*>& batch) {
+                usage.addVector(batch);
+                for (const Node* node : batch) addNode(node);
+            });
+        }
+        usage.countVectors(n);
+        return usage;
+    }
+};
+
+#endif // CONCURRENT_HASH_HPP
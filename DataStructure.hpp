@@ -5,6 +5,8 @@
 
 #include <vector>
 #include "Vector.hpp"
+#include "QueryStats.hpp"
+#include "MemoryUsage.hpp"
 
 /**
  * @struct QueryResult
@@ -17,15 +19,42 @@ struct QueryResult {
     std::vector<FeatureVector> neighbors;
     // Esta é uma métrica chave para a análise de custo prático.
     int comparisons = 0;
+    // Detalhes do percurso (nós, buckets, bytes); vazio se compilado com -DQUERY_STATS=0.
+    QueryStats stats;
 };
 
 
+// Fração máxima de vetores apagados (tombstones) antes de uma estrutura se compactar.
+// A compactação só acontece depois de ao menos MAX_DEAD_FRACTION * total remoções, então
+// o seu custo se divide entre elas: O(1) amortizado por remoção quando ela é linear
+// (Hash, IVF-PQ), O(M) no HNSW e O(log n) na VP-tree, que reconstrói a árvore na própria
+// remoção (a inserção na VP-tree custa O(log² n) amortizado, pelas árvores logarítmicas). Uma
+// consulta nunca percorre mais que 1 / (1 - MAX_DEAD_FRACTION) vezes os vetores vivos.
+constexpr double MAX_DEAD_FRACTION = 0.25;
+
+inline bool compactionDue(size_t dead, size_t total) {
+    return dead > 0 && static_cast<double>(dead) > MAX_DEAD_FRACTION * static_cast<double>(total);
+}
+
+// Pede ao processador a linha de cache de 'p' antes do uso, sem esperar por ela.
+// Usada nos percursos intercalados de queryBatch() para sobrepor as leituras de memória de várias consultas.
+inline void prefetchRead(const void* p) {
+#if defined(__GNUC__)
+    __builtin_prefetch(p, 0, 3);
+#else
+    (void)p;
+#endif
+}
+
 /**
  * @class DataStructure
  * @brief Classe base abstrata (interface) para todas as estruturas de dados.
  * * Define um "contrato" que todas as estruturas (Lista, Quadtree, Hash) devem seguir.
  * Isso garante que todas terão os mesmos métodos públicos, facilitando a comparação
  * entre elas no programa principal.
+ *
+ * O image_id identifica o vetor em remove() e update(), então cada ID deve ser
+ * inserido uma única vez; para trocar um vetor já inserido, use update().
  */
 class DataStructure {
 public:
@@ -45,6 +74,45 @@ public:
      * @return Um objeto QueryResult contendo os vizinhos e as estatísticas da busca.
      */
     virtual QueryResult query(const FeatureVector& query_vec, int k) = 0;
+
+    /**
+     * @brief Responde várias consultas de uma vez, com o mesmo k.
+     * @details A implementação padrão chama query() para cada uma; estruturas que
+     * varrem os vetores (Flat) sobrescrevem para ler cada bloco uma só vez para o
+     * lote inteiro, e as que seguem ponteiros (Hash, Quadtree) para intercalar os
+     * percursos de várias consultas. Usada pelo servidor para atender micro-lotes
+     * de requisições.
+     */
+    virtual std::vector<QueryResult> queryBatch(const std::vector<FeatureVector>& queries, int k) {
+        std::vector<QueryResult> results;
+        results.reserve(queries.size());
+        for (const auto& q : queries) results.push_back(query(q, k));
+        return results;
+    }
+
+    /**
+     * @brief (Virtual Pura) Remove o vetor com o image_id dado.
+     * @param image_id O ID do vetor a ser removido.
+     * @return false se nenhum vetor com esse ID estava na estrutura.
+     */
+    virtual bool remove(int image_id) = 0;
+
+    /**
+     * @brief Substitui o vetor de mesmo image_id, ou o insere se ele ainda não existir.
+     * @param vec O novo conteúdo do vetor.
+     * @return true se um vetor antigo foi substituído.
+     */
+    virtual bool update(const FeatureVector& vec) {
+        bool existed = remove(vec.image_id);
+        insert(vec);
+        return existed;
+    }
+
+    /**
+     * @brief (Virtual Pura) Memória ocupada pela estrutura: payload, overhead e folga do alocador.
+     * @details Não deve ser chamada durante inserções concorrentes.
+     */
+    virtual MemoryUsage memoryUsage() const = 0;
 };
 
 #endif // DATA_STRUCTURE_HPP
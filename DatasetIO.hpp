@@ -0,0 +1,190 @@
+#ifndef DATASET_IO_HPP
+#define DATASET_IO_HPP
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#include "Vector.hpp"
+
+/**
+ * Formato binário de datasets (.fvb), lido sem conversão de texto:
+ *   cabeçalho: "FVB1" (4 bytes), dimensão (uint32), número de vetores (uint64)
+ *   registros: image_id (int32) seguido de 'dimensão' componentes float32
+ * Todos os inteiros e floats em little-endian (ordem nativa de x86-64 e ARM).
+ */
+namespace fvb {
+constexpr char MAGIC[4] = {'F', 'V', 'B', '1'};
+constexpr size_t HEADER_SIZE = 4 + sizeof(uint32_t) + sizeof(uint64_t);
+}
+
+// Arquivos terminados em .fvb estão no formato binário; os demais são CSV.
+inline bool isBinaryDatasetPath(const std::string& filename) {
+    return filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".fvb") == 0;
+}
+
+/**
+ * @brief Carrega um dataset CSV (id, c0, c1, ...).
+ * @details Linhas com número de colunas diferente de FEATURE_DIM indicam um
+ * dataset de outra dimensão e abortam a leitura (retorna vetor vazio).
+ */
+inline std::vector<FeatureVector> loadDatasetCsv(const std::string& filename) {
+    std::vector<FeatureVector> dataset;
+    std::ifstream file(filename);
+
+    if (!file.is_open()) {
+        std::cerr << "ERRO FATAL: Nao foi possivel abrir o arquivo de dataset '" << filename << "'." << std::endl;
+        std::cerr << "Certifique-se de que o arquivo existe e esta na mesma pasta do executavel." << std::endl;
+        return dataset; // Retorna o vetor vazio para indicar o erro
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line.rfind("//", 0) == 0) continue;
+
+        std::stringstream ss(line);
+        std::string value;
+        FeatureVector vec;
+
+        std::getline(ss, value, ','); vec.image_id = std::stoi(value);
+        int d = 0;
+        while (d < FeatureVector::DIM && std::getline(ss, value, ',')) {
+            vec[d++] = static_cast<FeatureVector::ScalarType>(std::stod(value));
+        }
+        if (d != FeatureVector::DIM || std::getline(ss, value, ',')) {
+            std::cerr << "ERRO FATAL: A linha do ID " << vec.image_id << " nao tem " << FeatureVector::DIM
+                      << " caracteristicas. Recompile com -DFEATURE_DIM=<dimensao do dataset>." << std::endl;
+            return {};
+        }
+
+        dataset.push_back(vec);
+    }
+
+    file.close();
+    return dataset;
+}
+
+/**
+ * @brief Carrega um dataset no formato binário .fvb.
+ */
+inline std::vector<FeatureVector> loadDatasetBinary(const std::string& filename) {
+    std::vector<FeatureVector> dataset;
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "ERRO FATAL: Nao foi possivel abrir o arquivo de dataset '" << filename << "'." << std::endl;
+        return dataset;
+    }
+
+    char magic[4];
+    uint32_t dim = 0;
+    uint64_t count = 0;
+    file.read(magic, 4);
+    file.read(reinterpret_cast<char*>(&dim), sizeof(dim));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file || std::memcmp(magic, fvb::MAGIC, 4) != 0) {
+        std::cerr << "ERRO FATAL: '" << filename << "' nao e um arquivo .fvb valido." << std::endl;
+        return dataset;
+    }
+    if (dim != static_cast<uint32_t>(FeatureVector::DIM)) {
+        std::cerr << "ERRO FATAL: '" << filename << "' tem dimensao " << dim
+                  << ". Recompile com -DFEATURE_DIM=" << dim << "." << std::endl;
+        return dataset;
+    }
+
+    dataset.resize(count);
+    std::vector<char> record(sizeof(int32_t) + dim * sizeof(float));
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!file.read(record.data(), record.size())) {
+            std::cerr << "ERRO FATAL: '" << filename << "' terminou antes do registro " << i << "." << std::endl;
+            return {};
+        }
+        int32_t id;
+        std::memcpy(&id, record.data(), sizeof(id));
+        dataset[i].image_id = id;
+        for (uint32_t d = 0; d < dim; ++d) {
+            float x;
+            std::memcpy(&x, record.data() + sizeof(int32_t) + d * sizeof(float), sizeof(float));
+            dataset[i][d] = static_cast<FeatureVector::ScalarType>(x);
+        }
+    }
+    return dataset;
+}
+
+/**
+ * @brief Carrega um dataset escolhendo o formato pela extensão (.fvb = binário, senão CSV).
+ */
+inline std::vector<FeatureVector> loadDataset(const std::string& filename) {
+    return isBinaryDatasetPath(filename) ? loadDatasetBinary(filename) : loadDatasetCsv(filename);
+}
+
+/**
+ * @class DatasetWriter
+ * @brief Grava um dataset registro a registro (CSV, ou .fvb pela extensão).
+ * @details Nada fica em memória além do registro atual, então serve para
+ * conjuntos maiores que a RAM. A dimensão é dada em tempo de execução, sem
+ * depender de FEATURE_DIM. No .fvb o número de registros é gravado no
+ * cabeçalho ao fechar.
+ */
+class DatasetWriter {
+public:
+    DatasetWriter(const std::string& filename, uint32_t dim)
+        : binary(isBinaryDatasetPath(filename)), dim(dim), count(0) {
+        file.open(filename, binary ? std::ios::binary : std::ios::out);
+        if (binary && file.is_open()) {
+            file.write(fvb::MAGIC, 4);
+            file.write(reinterpret_cast<const char*>(&dim), sizeof(dim));
+            file.write(reinterpret_cast<const char*>(&count), sizeof(count)); // corrigido em close()
+            record.resize(sizeof(int32_t) + dim * sizeof(float));
+        }
+    }
+
+    ~DatasetWriter() { close(); }
+
+    DatasetWriter(const DatasetWriter&) = delete;
+    DatasetWriter& operator=(const DatasetWriter&) = delete;
+
+    bool ok() const { return file.is_open() && file.good(); }
+    uint64_t written() const { return count; }
+
+    // Grava um registro: o id e 'dim' componentes.
+    void write(int32_t id, const double* values) {
+        if (binary) {
+            std::memcpy(record.data(), &id, sizeof(id));
+            for (uint32_t d = 0; d < dim; ++d) {
+                float x = static_cast<float>(values[d]);
+                std::memcpy(record.data() + sizeof(int32_t) + d * sizeof(float), &x, sizeof(float));
+            }
+            file.write(record.data(), record.size());
+        } else {
+            file << id;
+            for (uint32_t d = 0; d < dim; ++d) file << "," << values[d];
+            file << "\n";
+        }
+        ++count;
+    }
+
+    // Fecha o arquivo; retorna false se alguma escrita falhou.
+    bool close() {
+        if (!file.is_open()) return true;
+        if (binary) {
+            file.seekp(4 + sizeof(uint32_t));
+            file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        }
+        bool good = file.good();
+        file.close();
+        return good;
+    }
+
+private:
+    std::ofstream file;
+    bool binary;
+    uint32_t dim;
+    uint64_t count;
+    std::vector<char> record;
+};
+
+#endif // DATASET_IO_HPP
@@ -0,0 +1,354 @@
+#ifndef DISK_IVF_HPP
+#define DISK_IVF_HPP
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "DataStructure.hpp" // QueryResult
+#include "KMeans.hpp"
+#include "Quantization.hpp"  // CandidateHeap
+
+/**
+ * Formato do índice IVF em disco (.fvi), lido por mmap sem carregar na memória:
+ *   cabeçalho: "FVI1" (4 bytes), dimensão (uint32), nlist (uint32), número de vetores (uint64)
+ *   centróides: nlist * dimensão float32 (vetores normalizados)
+ *   limites: nlist + 1 uint64 com a posição (em bytes, no arquivo) do início de cada lista
+ *   listas: cada uma começa numa fronteira de 4 KiB; registros de image_id (int32),
+ *           1 / norma (float32) e 'dimensão' componentes float32
+ * Como cada lista é um trecho contíguo de páginas, uma consulta lê do disco só
+ * as páginas das 'nprobe' listas que visita.
+ */
+namespace fvi {
+constexpr char MAGIC[4] = {'F', 'V', 'I', '1'};
+constexpr size_t HEADER_SIZE = 4 + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+constexpr size_t LIST_ALIGN = 4096; // alinhamento das listas no arquivo; fixo, faz parte do formato
+
+// Página real do sistema, para alinhar os endereços de madvise/mincore (pode ser maior que LIST_ALIGN).
+inline size_t pageSize() {
+    static const size_t page = [] {
+        long p = ::sysconf(_SC_PAGESIZE);
+        return p > 0 ? static_cast<size_t>(p) : LIST_ALIGN;
+    }();
+    return page;
+}
+constexpr size_t RECORD_SIZE = sizeof(int32_t) + sizeof(float) + FeatureVector::DIM * sizeof(float);
+}
+
+// Vetor normalizado em float (zero se o vetor for nulo); devolve 1 / norma (ou 0).
+inline float normalizeToFloat(const FeatureVector& vec, float* out) {
+    double sq = 0.0;
+    for (int d = 0; d < FeatureVector::DIM; ++d) sq += static_cast<double>(vec[d]) * static_cast<double>(vec[d]);
+    double inv = sq > 0.0 ? 1.0 / std::sqrt(sq) : 0.0;
+    for (int d = 0; d < FeatureVector::DIM; ++d) out[d] = static_cast<float>(static_cast<double>(vec[d]) * inv);
+    return static_cast<float>(inv);
+}
+
+/**
+ * @brief Agrupa os vetores por k-means e grava o índice .fvi.
+ * @param nlist Número de listas (0 = ~sqrt(N)).
+ * @return false se o arquivo não pôde ser gravado.
+ */
+inline bool writeDiskIVF(const std::string& filename, const std::vector<FeatureVector>& data, int nlist = 0) {
+    const int DIM = FeatureVector::DIM;
+    const size_t MAX_TRAIN = 50000;
+    if (data.empty()) return false;
+    if (nlist <= 0) nlist = std::max(1, static_cast<int>(std::sqrt(static_cast<double>(data.size()))));
+
+    std::vector<float> normalized(data.size() * DIM);
+    std::vector<float> inv_norm(data.size());
+    for (size_t i = 0; i < data.size(); ++i) inv_norm[i] = normalizeToFloat(data[i], &normalized[i * DIM]);
+
+    // Centróides treinados numa amostra de no máximo MAX_TRAIN vetores.
+    std::vector<size_t> idx(data.size());
+    std::iota(idx.begin(), idx.end(), 0);
+    if (idx.size() > MAX_TRAIN) {
+        std::mt19937 rng(7);
+        std::shuffle(idx.begin(), idx.end(), rng);
+        idx.resize(MAX_TRAIN);
+    }
+    std::vector<float> sample(idx.size() * DIM);
+    for (size_t i = 0; i < idx.size(); ++i) std::copy_n(&normalized[idx[i] * DIM], DIM, &sample[i * DIM]);
+    std::vector<float> centroids = kmeans(sample, idx.size(), DIM, nlist);
+    nlist = static_cast<int>(centroids.size() / DIM);
+
+    std::vector<std::vector<uint32_t>> members(nlist);
+    for (size_t i = 0; i < data.size(); ++i) {
+        members[nearestCentroid(&normalized[i * DIM], centroids, nlist, DIM)].push_back(static_cast<uint32_t>(i));
+    }
+
+    auto alignUp = [](uint64_t x) { return (x + fvi::LIST_ALIGN - 1) / fvi::LIST_ALIGN * fvi::LIST_ALIGN; };
+    std::vector<uint64_t> bounds(nlist + 1);
+    uint64_t pos = alignUp(fvi::HEADER_SIZE + centroids.size() * sizeof(float) + bounds.size() * sizeof(uint64_t));
+    for (int c = 0; c < nlist; ++c) {
+        bounds[c] = pos;
+        pos = alignUp(pos + members[c].size() * fvi::RECORD_SIZE);
+    }
+    bounds[nlist] = pos;
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "!! Nao foi possivel criar '" << filename << "'." << std::endl;
+        return false;
+    }
+    uint32_t dim = DIM, lists = static_cast<uint32_t>(nlist);
+    uint64_t count = data.size();
+    file.write(fvi::MAGIC, 4);
+    file.write(reinterpret_cast<const char*>(&dim), sizeof(dim));
+    file.write(reinterpret_cast<const char*>(&lists), sizeof(lists));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(centroids.data()), centroids.size() * sizeof(float));
+    file.write(reinterpret_cast<const char*>(bounds.data()), bounds.size() * sizeof(uint64_t));
+
+    std::vector<char> record(fvi::RECORD_SIZE);
+    for (int c = 0; c < nlist; ++c) {
+        file.seekp(static_cast<std::streamoff>(bounds[c]));
+        for (uint32_t i : members[c]) {
+            int32_t id = data[i].image_id;
+            std::memcpy(record.data(), &id, sizeof(id));
+            std::memcpy(record.data() + sizeof(int32_t), &inv_norm[i], sizeof(float));
+            for (int d = 0; d < DIM; ++d) {
+                float x = static_cast<float>(data[i][d]);
+                std::memcpy(record.data() + sizeof(int32_t) + (1 + d) * sizeof(float), &x, sizeof(float));
+            }
+            file.write(record.data(), record.size());
+        }
+    }
+    // O arquivo vai até o fim da última página, para que o mmap cubra todas as listas.
+    if (pos > 0) {
+        file.seekp(static_cast<std::streamoff>(pos - 1));
+        file.put('\0');
+    }
+    return file.good();
+}
+
+/**
+ * @class DiskIVF
+ * @brief Índice IVF (listas de vetores exatos) lido de um arquivo .fvi por mmap.
+ * * Só os centróides ficam na memória do processo. As listas são páginas do
+ * arquivo mapeado: a primeira leitura de uma lista fora do page cache é uma
+ * falta de página que bloqueia a thread até o disco responder. query() é a
+ * versão síncrona, que sofre essas faltas; AsyncQuery.hpp usa as mesmas
+ * etapas (probe, listRange, scanList, collect) numa corrotina que espera as
+ * páginas de cada lista sem bloquear a thread.
+ *
+ * A busca visita as 'nprobe' listas mais próximas e calcula a distância do
+ * cosseno exata a cada vetor delas. É somente leitura: para mudar o conjunto,
+ * grave outro arquivo com writeDiskIVF().
+ */
+class DiskIVF {
+public:
+    static constexpr int DIM = FeatureVector::DIM;
+
+    explicit DiskIVF(const std::string& filename, int nprobe = 8) : filename(filename), nprobe(std::max(1, nprobe)) {
+        fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "!! Nao foi possivel abrir o indice '" << filename << "'." << std::endl;
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < fvi::HEADER_SIZE) {
+            std::cerr << "!! '" << filename << "' nao e um indice .fvi valido." << std::endl;
+            return;
+        }
+        length = static_cast<size_t>(st.st_size);
+        if (!map()) return;
+
+        uint32_t dim = 0, lists = 0;
+        std::memcpy(&dim, base + 4, sizeof(dim));
+        std::memcpy(&lists, base + 4 + sizeof(uint32_t), sizeof(lists));
+        std::memcpy(&count, base + 4 + 2 * sizeof(uint32_t), sizeof(count));
+        size_t tables = fvi::HEADER_SIZE + static_cast<size_t>(lists) * (DIM * sizeof(float) + sizeof(uint64_t)) +
+                        sizeof(uint64_t);
+        if (std::memcmp(base, fvi::MAGIC, 4) != 0 || lists == 0 || tables > length) {
+            std::cerr << "!! '" << filename << "' nao e um indice .fvi valido." << std::endl;
+            unmap();
+            return;
+        }
+        if (dim != static_cast<uint32_t>(DIM)) {
+            std::cerr << "!! '" << filename << "' tem dimensao " << dim << ". Recompile com -DFEATURE_DIM=" << dim
+                      << "." << std::endl;
+            unmap();
+            return;
+        }
+        nlist = static_cast<int>(lists);
+        centroids.resize(static_cast<size_t>(nlist) * DIM);
+        bounds.resize(nlist + 1);
+        std::memcpy(centroids.data(), base + fvi::HEADER_SIZE, centroids.size() * sizeof(float));
+        std::memcpy(bounds.data(), base + fvi::HEADER_SIZE + centroids.size() * sizeof(float),
+                    bounds.size() * sizeof(uint64_t));
+        if (bounds[nlist] > length) {
+            std::cerr << "!! '" << filename << "' esta truncado." << std::endl;
+            unmap();
+        }
+    }
+
+    ~DiskIVF() {
+        unmap();
+        if (fd >= 0) ::close(fd);
+    }
+
+    DiskIVF(const DiskIVF&) = delete;
+    DiskIVF& operator=(const DiskIVF&) = delete;
+
+    bool ok() const { return base != nullptr; }
+    size_t size() const { return count; }
+    size_t fileBytes() const { return length; }
+    int getNlist() const { return nlist; }
+    void setNprobe(int n) { nprobe = std::max(1, n); }
+    int getNprobe() const { return nprobe; }
+
+    // As 'nprobe' listas mais próximas da consulta normalizada 'qn', da mais próxima para a mais distante.
+    std::vector<int> probe(const float* qn, QueryResult& result) const {
+        std::vector<std::pair<float, int>> dist(nlist);
+        for (int c = 0; c < nlist; ++c) dist[c] = {squaredL2(qn, &centroids[static_cast<size_t>(c) * DIM], DIM), c};
+        result.comparisons += nlist;
+        int probes = std::min(nprobe, nlist);
+        std::partial_sort(dist.begin(), dist.begin() + probes, dist.end());
+        std::vector<int> lists(probes);
+        for (int p = 0; p < probes; ++p) lists[p] = dist[p].second;
+        return lists;
+    }
+
+    // Trecho do arquivo mapeado ocupado pela lista (vazio se a lista não tem vetores).
+    const char* listData(int list) const { return base + bounds[list]; }
+    size_t listBytes(int list) const {
+        size_t n = (bounds[list + 1] - bounds[list]) / fvi::RECORD_SIZE;
+        return n * fvi::RECORD_SIZE;
+    }
+
+    // Compara 'qn' com todos os vetores da lista (as páginas já devem estar em memória para não bloquear).
+    void scanList(int list, const float* qn, CandidateHeap<const char*>& heap, QueryResult& result) const {
+        const char* rec = listData(list);
+        const char* end = rec + listBytes(list);
+        result.stats.scanLeaf();
+        result.stats.touch(end - rec);
+        for (; rec < end; rec += fvi::RECORD_SIZE) {
+            const float* x = reinterpret_cast<const float*>(rec + sizeof(int32_t));
+            float dot = 0.0f;
+            for (int d = 0; d < DIM; ++d) dot += qn[d] * x[1 + d];
+            heap.push(dot * x[0], rec);
+            result.comparisons++;
+        }
+    }
+
+    // Os k melhores candidatos, do mais próximo para o mais distante.
+    std::vector<FeatureVector> collect(const CandidateHeap<const char*>& heap, int k) const {
+        std::vector<CandidateHeap<const char*>::Candidate> best = heap.candidates();
+        std::sort(best.begin(), best.end(), [](const auto& a, const auto& b) { return a.score > b.score; });
+        if (best.size() > static_cast<size_t>(k)) best.resize(k);
+        std::vector<FeatureVector> neighbors(best.size());
+        for (size_t i = 0; i < best.size(); ++i) {
+            int32_t id;
+            std::memcpy(&id, best[i].item, sizeof(id));
+            neighbors[i].image_id = id;
+            const float* x = reinterpret_cast<const float*>(best[i].item + sizeof(int32_t));
+            for (int d = 0; d < DIM; ++d) neighbors[i][d] = static_cast<FeatureVector::ScalarType>(x[1 + d]);
+        }
+        return neighbors;
+    }
+
+    // Busca síncrona: cada lista fora do page cache bloqueia a thread nas faltas de página.
+    QueryResult query(const FeatureVector& query_vec, int k) const {
+        QueryResult result;
+        if (k <= 0 || !ok()) return result;
+        float qn[DIM];
+        normalizeToFloat(query_vec, qn);
+        CandidateHeap<const char*> heap(static_cast<size_t>(k));
+        for (int list : probe(qn, result)) scanList(list, qn, heap, result);
+        result.neighbors = collect(heap, k);
+        return result;
+    }
+
+    // Pede ao kernel a leitura antecipada das páginas da lista (não bloqueia).
+    void prefetch(int list) const {
+        if (listBytes(list) > 0) adviseRange(listData(list), listBytes(list), MADV_WILLNEED);
+    }
+
+    // true se todas as páginas do trecho já estão no page cache e mapeadas (mincore).
+    static bool resident(const char* addr, size_t bytes) {
+        if (bytes == 0) return true;
+        const size_t page = fvi::pageSize();
+        uintptr_t first = reinterpret_cast<uintptr_t>(addr) / page * page;
+        size_t pages = (reinterpret_cast<uintptr_t>(addr) + bytes - first + page - 1) / page;
+        unsigned char vec[64];
+        for (size_t done = 0; done < pages; done += sizeof(vec)) {
+            size_t n = std::min(pages - done, sizeof(vec));
+            if (::mincore(reinterpret_cast<void*>(first + done * page), n * page, vec) != 0) return false;
+            for (size_t i = 0; i < n; ++i) {
+                if (!(vec[i] & 1)) return false;
+            }
+        }
+        return true;
+    }
+
+    // Fração das páginas do arquivo que estão no page cache.
+    double residentFraction() const {
+        if (!ok()) return 0.0;
+        size_t pages = (length + fvi::pageSize() - 1) / fvi::pageSize(), in_cache = 0;
+        std::vector<unsigned char> vec(pages);
+        if (::mincore(const_cast<char*>(base), length, vec.data()) != 0) return 0.0;
+        for (unsigned char v : vec) in_cache += v & 1;
+        return static_cast<double>(in_cache) / pages;
+    }
+
+    /**
+     * @brief Tira o arquivo do page cache, como se o índice fosse maior que a memória.
+     * @details O mapeamento é desfeito (páginas mapeadas não saem do cache) e
+     * refeito depois do posix_fadvise(DONTNEED). Não chamar durante consultas.
+     */
+    bool dropCache() {
+        if (!ok()) return false;
+        unmap();
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        return map();
+    }
+
+private:
+    std::string filename;
+    int fd = -1;
+    const char* base = nullptr;
+    size_t length = 0;
+    uint64_t count = 0;
+    int nlist = 0;
+    int nprobe;
+    std::vector<float> centroids;
+    std::vector<uint64_t> bounds;
+
+    bool map() {
+        void* addr = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            std::cerr << "!! mmap de '" << filename << "' falhou." << std::endl;
+            return false;
+        }
+        base = static_cast<const char*>(addr);
+        // O acesso às listas é aleatório: sem leitura antecipada além das páginas pedidas.
+        ::madvise(addr, length, MADV_RANDOM);
+        return true;
+    }
+
+    void unmap() {
+        if (base) ::munmap(const_cast<char*>(base), length);
+        base = nullptr;
+    }
+
+    static void adviseRange(const char* addr, size_t bytes, int advice) {
+        uintptr_t first = reinterpret_cast<uintptr_t>(addr) / fvi::pageSize() * fvi::pageSize();
+        ::madvise(reinterpret_cast<void*>(first), reinterpret_cast<uintptr_t>(addr) + bytes - first, advice);
+    }
+};
+
+#endif // DISK_IVF_HPP
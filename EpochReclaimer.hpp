@@ -0,0 +1,145 @@
+// EpochReclaimer.hpp
+
+#ifndef EPOCH_RECLAIMER_HPP
+#define EPOCH_RECLAIMER_HPP
+
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <limits>
+#include <cstdint>
+#include <utility>
+
+/**
+ * @class EpochReclaimer
+ * @brief Reclamação por épocas dos nós que as estruturas sem lock de leitura desligam.
+ * * Cada operação que lê nós compartilhados anuncia, num slot, a época global em
+ * que começou (enterRead) e o libera ao terminar (exitRead). Quem desliga nós os
+ * entrega em lote a retire(), que marca o lote com a época corrente, avança a
+ * época e libera os lotes retirados antes da época mais antiga ainda anunciada.
+ *
+ * Ordenação: a leitora grava a época no slot e, depois de um fence seq_cst, lê a
+ * estrutura; quem retira já desligou os nós, avança a época e, depois de um fence
+ * seq_cst, lê os slots. Pelos dois fences, ou retire() vê o slot (e segura o lote),
+ * ou a leitora vê a estrutura já sem os nós.
+ *
+ * Um slot extra entra na lista já ocupado, antes de a leitora anunciar a época,
+ * e nunca sai dela: a ordenação acima vale para ele como para os fixos, e
+ * retire() nunca lê um slot já liberado.
+ *
+ * Progresso: enterRead() é lock-free, não wait-free. Nenhuma leitora espera outra
+ * terminar: com os MAX_READERS slots fixos ocupados ela usa um slot extra livre
+ * ou acrescenta um (então há tantos slots quanto o pico de operações simultâneas).
+ * Só o CAS que acrescenta um slot pode repetir, e apenas quando outra leitora
+ * acrescentou um ao mesmo tempo. exitRead() é wait-free.
+ *
+ * retire() e forEachRetired() não são reentrantes: o dono as serializa (com o mesmo
+ * mutex que já serializa suas escritoras ou compactações). enterRead/exitRead podem
+ * ser chamadas por qualquer thread, a qualquer momento.
+ *
+ * @tparam T Tipo do nó (pode ser const); os nós são liberados com delete.
+ */
+template <typename T>
+class EpochReclaimer {
+public:
+    // Um slot por operação em andamento; alinhado para cada um ficar na sua linha de cache.
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{0}; // 0 = nenhuma operação neste slot
+        std::atomic<bool> busy{false};
+        ReaderSlot* next = nullptr;     // só nos slots extras: o próximo da lista
+    };
+    static constexpr int MAX_READERS = 64; // slots fixos; além deles, slots extras
+
+    EpochReclaimer() = default;
+
+    // Ninguém mais lê a estrutura: libera tudo o que ainda esperava.
+    ~EpochReclaimer() {
+        for (const auto& batch : retired) {
+            for (T* n : batch.nodes) delete n;
+        }
+        for (ReaderSlot* s = extra.load(std::memory_order_relaxed); s;) {
+            ReaderSlot* tmp = s;
+            s = s->next;
+            delete tmp;
+        }
+    }
+
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+    // Anuncia a operação: ocupa um slot livre e grava a época corrente. Nunca espera outra operação
+    // terminar: com todos os slots ocupados, acrescenta um slot extra, que fica para as próximas.
+    ReaderSlot* enterRead() const {
+        static thread_local unsigned hint = static_cast<unsigned>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        for (unsigned tries = 0; tries < MAX_READERS; ++tries) {
+            ReaderSlot& s = slots[(hint + tries) % MAX_READERS];
+            if (claim(s)) {
+                hint = (hint + tries) % MAX_READERS;
+                return announce(s);
+            }
+        }
+        for (ReaderSlot* s = extra.load(std::memory_order_acquire); s; s = s->next) {
+            if (claim(*s)) return announce(*s);
+        }
+        ReaderSlot* s = new ReaderSlot;
+        s->busy.store(true, std::memory_order_relaxed);
+        s->next = extra.load(std::memory_order_relaxed);
+        while (!extra.compare_exchange_weak(s->next, s, std::memory_order_release, std::memory_order_relaxed)) {}
+        return announce(*s);
+    }
+
+    static void exitRead(ReaderSlot* s) {
+        s->epoch.store(0, std::memory_order_release);
+        s->busy.store(false, std::memory_order_release);
+    }
+
+    // Recebe um lote já inalcançável para operações que comecem agora e libera os que ninguém mais lê.
+    void retire(std::vector<T*> nodes) {
+        retired.push_back({globalEpoch.fetch_add(1), std::move(nodes)});
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t oldest = std::numeric_limits<uint64_t>::max();
+        auto visitSlot = [&oldest](const ReaderSlot& s) {
+            uint64_t e = s.epoch.load();
+            if (e != 0 && e < oldest) oldest = e;
+        };
+        for (const auto& s : slots) visitSlot(s);
+        for (const ReaderSlot* s = extra.load(std::memory_order_acquire); s; s = s->next) visitSlot(*s);
+        while (!retired.empty() && retired.front().epoch < oldest) {
+            for (T* n : retired.front().nodes) delete n;
+            retired.pop_front();
+        }
+    }
+
+    // Visita cada lote ainda não liberado (para a contagem de memória).
+    template <typename F>
+    void forEachRetired(F&& visit) const {
+        for (const auto& batch : retired) visit(batch.nodes);
+    }
+
+private:
+    struct Retired {
+        uint64_t epoch;
+        std::vector<T*> nodes;
+    };
+
+    std::atomic<uint64_t> globalEpoch{1};
+    mutable ReaderSlot slots[MAX_READERS];
+    mutable std::atomic<ReaderSlot*> extra{nullptr}; // slots extras; só crescem, liberados no destrutor
+    std::deque<Retired> retired;
+
+    static bool claim(ReaderSlot& s) {
+        bool expected = false;
+        return !s.busy.load(std::memory_order_relaxed) &&
+               s.busy.compare_exchange_strong(expected, true, std::memory_order_acquire);
+    }
+
+    ReaderSlot* announce(ReaderSlot& s) const {
+        s.epoch.store(globalEpoch.load());
+        std::atomic_thread_fence(std::memory_order_seq_cst); // ver a ordenação na descrição da classe
+        return &s;
+    }
+};
+
+#endif // EPOCH_RECLAIMER_HPP
@@ -0,0 +1,165 @@
+#ifndef EVALUATION_HPP
+#define EVALUATION_HPP
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <thread>
+#include <unordered_set>
+
+#include "Vector.hpp"
+
+/**
+ * @struct GroundTruth
+ * @brief Vizinhos exatos (e suas distâncias, em ordem crescente) de cada consulta.
+ */
+struct GroundTruth {
+    std::vector<std::vector<FeatureVector>> neighbors;
+    std::vector<std::vector<double>> distances;
+
+    size_t size() const { return neighbors.size(); }
+};
+
+/**
+ * @brief Calcula os k vizinhos exatos de cada consulta por força bruta.
+ * @details Os vetores do conjunto são normalizados uma vez para um bloco
+ * contíguo de doubles; cada distância passa a ser 1 - produto escalar, sem
+ * raízes nem normas por comparação e sem percorrer ponteiros como a Lista.
+ * As distâncias finais dos k escolhidos são recalculadas com distanceTo, para
+ * serem comparáveis com as das estruturas avaliadas.
+ * @param threads As consultas são divididas entre 'threads' threads.
+ */
+inline GroundTruth computeGroundTruth(const std::vector<FeatureVector>& dataset,
+                                      const std::vector<FeatureVector>& queries, int k, int threads = 1) {
+    constexpr int DIM = FeatureVector::DIM;
+    const size_t n = dataset.size();
+
+    // Vetores unitários; vetores nulos ficam com norma zero (distanceTo = 1 para eles).
+    std::vector<double> unit(n * DIM);
+    std::vector<char> is_null(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        double sq = 0.0;
+        for (int d = 0; d < DIM; ++d) sq += static_cast<double>(dataset[i][d]) * static_cast<double>(dataset[i][d]);
+        double inv = sq > 0.0 ? 1.0 / std::sqrt(sq) : 0.0;
+        is_null[i] = (sq == 0.0);
+        for (int d = 0; d < DIM; ++d) unit[i * DIM + d] = static_cast<double>(dataset[i][d]) * inv;
+    }
+
+    GroundTruth truth;
+    truth.neighbors.resize(queries.size());
+    truth.distances.resize(queries.size());
+    size_t kk = std::min(static_cast<size_t>(std::max(0, k)), n);
+
+    // Cada thread processa as consultas [begin, end) com o seu próprio buffer de distâncias.
+    auto worker = [&](size_t begin, size_t end) {
+        std::vector<std::pair<double, size_t>> dist(n);
+        double q[DIM];
+        for (size_t qi = begin; qi < end; ++qi) {
+            double sq = 0.0;
+            for (int d = 0; d < DIM; ++d) sq += static_cast<double>(queries[qi][d]) * static_cast<double>(queries[qi][d]);
+            double inv = sq > 0.0 ? 1.0 / std::sqrt(sq) : 0.0;
+            for (int d = 0; d < DIM; ++d) q[d] = static_cast<double>(queries[qi][d]) * inv;
+
+            for (size_t i = 0; i < n; ++i) {
+                const double* x = &unit[i * DIM];
+                double dot = 0.0;
+                for (int d = 0; d < DIM; ++d) dot += q[d] * x[d];
+                dist[i] = {(inv == 0.0 || is_null[i]) ? 1.0 : 1.0 - dot, i};
+            }
+            std::partial_sort(dist.begin(), dist.begin() + kk, dist.end());
+
+            for (size_t j = 0; j < kk; ++j) {
+                const FeatureVector& vec = dataset[dist[j].second];
+                truth.neighbors[qi].push_back(vec);
+                truth.distances[qi].push_back(queries[qi].distanceTo(vec));
+            }
+        }
+    };
+
+    size_t nt = std::max<size_t>(1, std::min<size_t>(static_cast<size_t>(std::max(1, threads)), queries.size()));
+    size_t chunk = (queries.size() + nt - 1) / nt;
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < nt; ++t) {
+        pool.emplace_back(worker, std::min(queries.size(), t * chunk), std::min(queries.size(), (t + 1) * chunk));
+    }
+    worker(0, std::min(queries.size(), chunk));
+    for (auto& th : pool) th.join();
+    return truth;
+}
+
+/**
+ * @brief Mantém só os k primeiros vizinhos exatos de cada consulta.
+ * @details Permite calcular os vizinhos uma vez, para o maior k pedido, e avaliar todos os k menores.
+ */
+inline GroundTruth truncateGroundTruth(const GroundTruth& truth, int k) {
+    GroundTruth out = truth;
+    size_t kk = static_cast<size_t>(std::max(0, k));
+    for (size_t i = 0; i < out.size(); ++i) {
+        if (out.neighbors[i].size() > kk) {
+            out.neighbors[i].resize(kk);
+            out.distances[i].resize(kk);
+        }
+    }
+    return out;
+}
+
+/**
+ * @struct AccuracyMetrics
+ * @brief Qualidade de um resultado em relação aos vizinhos exatos.
+ */
+struct AccuracyMetrics {
+    double recall = 1.0;         // fração dos k vizinhos exatos encontrados
+    double precision = 1.0;      // fração dos vizinhos devolvidos que estão entre os k exatos
+    double distance_ratio = 1.0; // média de d(i-ésimo devolvido) / d(i-ésimo exato), com d exato > 1e-6; 1 = ótimo
+};
+
+/**
+ * @brief Compara os vizinhos devolvidos por uma estrutura com os exatos.
+ * @details Um vizinho devolvido conta como acerto se a sua distância não é
+ * maior que a do k-ésimo vizinho exato: empates na fronteira (vetores
+ * duplicados ou equidistantes) não são penalizados só por terem outro ID.
+ * A razão de distâncias só usa as posições com vizinho devolvido (os que
+ * faltam já pesam no recall) e cuja distância exata passa de 1e-6: uma
+ * consulta que está no próprio conjunto (distância 0 ao primeiro vizinho)
+ * não divide por zero nem por um resíduo de arredondamento. Sem nenhuma
+ * posição assim, a razão é 1.
+ */
+inline AccuracyMetrics evaluateQuery(const FeatureVector& query_vec, const std::vector<FeatureVector>& found,
+                                     const std::vector<FeatureVector>& truth,
+                                     const std::vector<double>& truth_distances) {
+    AccuracyMetrics m;
+    if (truth.empty()) return m;
+
+    const double tolerance = 1e-9;
+    double kth = truth_distances.back();
+
+    std::vector<double> found_dist;
+    found_dist.reserve(found.size());
+    for (const auto& v : found) found_dist.push_back(query_vec.distanceTo(v));
+    std::sort(found_dist.begin(), found_dist.end());
+
+    // Acertos: IDs distintos dentro do raio do k-ésimo vizinho exato.
+    std::unordered_set<int> seen;
+    int hits = 0;
+    for (const auto& v : found) {
+        if (!seen.insert(v.image_id).second) continue;
+        if (query_vec.distanceTo(v) <= kth + tolerance) hits++;
+    }
+    hits = std::min(hits, static_cast<int>(truth.size()));
+    m.recall = static_cast<double>(hits) / truth.size();
+    m.precision = found.empty() ? 0.0 : static_cast<double>(hits) / found.size();
+
+    const double min_distance = 1e-6;
+    double ratio_sum = 0.0;
+    size_t positions = 0;
+    for (size_t i = 0; i < truth.size() && i < found_dist.size(); ++i) {
+        if (truth_distances[i] <= min_distance) continue;
+        ratio_sum += found_dist[i] / truth_distances[i];
+        positions++;
+    }
+    if (positions > 0) m.distance_ratio = ratio_sum / positions;
+    return m;
+}
+
+#endif // EVALUATION_HPP
@@ -0,0 +1,271 @@
+#ifndef EXPERIMENT_HPP
+#define EXPERIMENT_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "DataStructure.hpp"
+#include "Lista.hpp"
+#include "Hash.hpp"
+#include "ConcurrentHash.hpp"
+#include "Quadtree.hpp"
+#include "SnapshotQuadtree.hpp"
+#include "ShardedIndex.hpp"
+#include "FlatIndex.hpp"
+#include "IVFIndex.hpp"
+#include "HNSW.hpp"
+#include "VPTree.hpp"
+#include "SpaceFillingCurve.hpp"
+
+// Valores de um parâmetro a experimentar (ex.: {"ef", {16, 32, 64}}).
+using ParamAxis = std::pair<std::string, std::vector<double>>;
+using ParamGrid = std::vector<ParamAxis>;
+// Uma combinação concreta de parâmetros (ex.: {"M": 16, "ef": 32}).
+using ParamSet = std::map<std::string, double>;
+
+/**
+ * @brief Produto cartesiano dos valores de cada parâmetro da grade.
+ * @details Uma grade vazia produz uma única combinação vazia.
+ */
+inline std::vector<ParamSet> expandGrid(const ParamGrid& grid) {
+    std::vector<ParamSet> sets(1);
+    for (const auto& axis : grid) {
+        std::vector<ParamSet> next;
+        for (const auto& base : sets) {
+            for (double value : axis.second) {
+                ParamSet s = base;
+                s[axis.first] = value;
+                next.push_back(s);
+            }
+        }
+        sets.swap(next);
+    }
+    return sets;
+}
+
+/**
+ * @brief Representação textual de uma combinação ("M=16;ef=32"), sem vírgulas para não quebrar o CSV.
+ */
+inline std::string formatParams(const ParamSet& params) {
+    std::ostringstream ss;
+    bool first = true;
+    for (const auto& p : params) {
+        ss << (first ? "" : ";") << p.first << "=" << p.second;
+        first = false;
+    }
+    return ss.str();
+}
+
+/**
+ * @struct StructureSpec
+ * @brief Descreve uma estrutura que o executor de experimentos sabe construir.
+ * * Parâmetros de construção exigem reconstruir a estrutura a cada combinação;
+ * parâmetros de consulta (ex.: nprobe, efSearch) são aplicados por 'configure'
+ * sobre a estrutura já construída.
+ */
+struct StructureSpec {
+    std::string key;          // nome usado na linha de comando (minúsculas)
+    std::string label;        // nome usado nos relatórios
+    ParamGrid build_params;   // valores padrão dos parâmetros de construção
+    ParamGrid query_params;   // valores padrão dos parâmetros de consulta
+    std::function<std::unique_ptr<DataStructure>(const std::vector<FeatureVector>&, const ParamSet&)> build;
+    std::function<void(DataStructure&, const ParamSet&)> configure; // pode ser vazio
+};
+
+// Parâmetro 'curve' do catálogo: 0 = ordem de inserção, 1 = Morton, 2 = Hilbert.
+inline CurveOrder curveParam(const ParamSet& p) {
+    int c = static_cast<int>(p.at("curve"));
+    return (c == 1 || c == 2) ? static_cast<CurveOrder>(c) : CurveOrder::None;
+}
+
+/**
+ * @brief Todas as estruturas do projeto, com os parâmetros padrão usados até aqui.
+ * @param value_max Maior valor de um componente (255 para RGB, 1 para histogramas).
+ * @param threads Threads padrão da construção paralela (HNSW).
+ */
+inline std::vector<StructureSpec> structureCatalog(double value_max, int threads) {
+    std::vector<StructureSpec> catalog;
+    // Bin de 25 níveis para cores médias (0-255); para histogramas (0-1) usamos 0.05.
+    const double hash_bin = (FeatureVector::DIM == 3) ? 25.0 : 0.05;
+
+    // curve: ordem dos vetores na memória (SpaceFillingCurve.hpp). Na Lista e no Flat é a ordem de
+    // inserção; na Hash e na Quadtree, a da compactação depois da carga (pack).
+    catalog.push_back({"lista", "Lista", {{"curve", {0}}}, {},
+        [](const std::vector<FeatureVector>& data, const ParamSet& p) {
+            auto s = std::make_unique<Lista>();
+            std::vector<FeatureVector> sorted;
+            for (const auto& vec : curveOrdered(data, curveParam(p), sorted)) s->insert(vec);
+            return std::unique_ptr<DataStructure>(std::move(s));
+        }, nullptr});
+
+    catalog.push_back({"hash", "Hash", {{"buckets", {1013}}, {"hashes", {5}}, {"bin", {hash_bin}}, {"curve", {0}}}, {},
+        [](const std::vector<FeatureVector>& data, const ParamSet& p) {
+            auto s = std::make_unique<HashTable>(static_cast<int>(p.at("buckets")), static_cast<int>(p.at("hashes")),
+                                                 p.at("bin"));
+            for (const auto& vec : data) s->insert(vec);
+            if (curveParam(p) != CurveOrder::None) s->pack(curveParam(p));
+            return std::unique_ptr<DataStructure>(std::move(s));
+        }, nullptr});
+
+    catalog.push_back({"hash-concurrent", "Hash-Concurrent", {{"buckets", {1013}}, {"hashes", {5}}, {"bin", {hash_bin}}}, {},
+        [](const std::vector<FeatureVector>& data, const ParamSet& p) {
+            auto s = std::make_unique<ConcurrentHashTable>(static_cast<int>(p.at("buckets")),
+                                                           static_cast<int>(p.at("hashes")), p.at("bin"));
+            for (const auto& vec : data) s->insert(vec);
+            return std::unique_ptr<DataStructure>(std::move(s));
+        }, nullptr});
+
+    catalog.push_back({"quadtree", "Quadtree", {{"curve", {0}}}, {},
+        [value_max](const std::vector<FeatureVector>& data, const ParamSet& p) {
+            auto s = std::make_unique<Quadtree>(0.0, value_max, 0.0, value_max);
+            for (const auto& vec : data) s->insert(vec);
+            if (curveParam(p) != CurveOrder::None) s->pack(curveParam(p));
+            return std::unique_ptr<DataStructure>(std::move(s));
+        }, nullptr});
+
+    catalog.push_back({"quadtree-snapshot", "Quadtree-Snapshot", {}, {},
+        [value_max](const std::vector<FeatureVector>& data, const ParamSet&) {
+            auto s = std::make_unique<SnapshotQuadtree>(0.0, value_max, 0.0, value_max);
+            for (const auto& vec : data) s->insert(vec);
+            return std::unique_ptr<DataStructure>(std::move(s));
+        }, nullptr});
+
+    // Índices distribuídos em processos shard; spatial = 0 divide por hash do ID, 1 por região angular.
+    catalog.push_back({"hash-sharded", "Hash-Sharded",
+                       {{"shards", {4}}, {"spatial", {0, 1}}, {"buckets", {1013}}, {"hashes", {5}}, {"bin", {hash_bin}}}, {},
+        [](const std::vector<FeatureVector>& data, const ParamSet& p) {
+            int buckets = static_cast<int>(p.at("buckets")), hashes = static_cast<int>(p.at("hashes"));
+            double bin = p.at("bin");
+            auto s = std::make_unique<ShardedIndex>(static_cast<int>(p.at("shards")),
+                p.at("spatial") != 0.0 ? ShardPolicy::Spatial : ShardPolicy::Hash,
+                [buckets, hashes, bin](const std::vector<FeatureVector>& part) {
+                    auto shard = std::make_unique<HashTable>(buckets, hashes, bin);
+                    for (const auto& vec : part) shard->insert(vec);
+                    return std::unique_ptr<DataStructure>(std::move(shard));
+                });
+            s->build(data);
+            return std::unique_ptr<DataStructure>(std::move(s));
+        }, nullptr});
+
+    catalog.push_back({"quadtree-sharded", "Quadtree-Sharded", {{"shards", {4}}, {"spatial", {0, 1}}}, {},
+        [value_max](const std::vector<FeatureVector>& data, const ParamSet& p) {
+            auto s = std::make_unique<ShardedIndex>(static_cast<int>(p.at("shards")),
+                p.at("spatial") != 0.0 ? ShardPolicy::Spatial : ShardPolicy::Hash,
+                [value_max](const std::vector<FeatureVector>& part) {
+                    auto shard = std::make_unique<Quadtree>(0.0, value_max, 0.0, value_max);
+                    for (const auto& vec : part) shard->insert(vec);
+                    return std::unique_ptr<DataStructure>(std::move(shard));
+                });
+            s->build(data);
+            return std::unique_ptr<DataStructure>(std::move(s));
+        }, nullptr});
+
+    catalog.push_back({"flat", "Flat", {{"curve", {0}}}, {},
+        [](const std::vector<FeatureVector>& data, const ParamSet& p) {
+            auto s = std::make_unique<FlatIndex>();
+            std::vector<FeatureVector> sorted;
+            for (const auto& vec : curveOrdered(data, curveParam(p), sorted)) s->insert(vec);
+            return std::unique_ptr<DataStructure>(std::move(s));
+        }, nullptr});
+
+    catalog.push_back({"flat-sq8", "Flat-SQ8", {{"rerank", {4}}}, {},
+        [](const std::vector<FeatureVector>& data, const ParamSet& p) {
+            auto s = std::make_unique<FlatIndex>();
+            s->enableQuantization(ScalarQuantizer::fit(data), static_cast<int>(p.at("rerank")));
+            for (const auto& vec : data) s->insert(vec);
+            return std::unique_ptr<DataStructure>(std::move(s));
+        }, nullptr});
+
+    catalog.push_back({"quadtree-sq8", "Quadtree-SQ8", {{"rerank", {4}}}, {},
+        [value_max](const std::vector<FeatureVector>& data, const ParamSet& p) {
+            auto s = std::make_unique<Quadtree>(0.0, value_max, 0.0, value_max);
+            s->enableQuantization(ScalarQuantizer::fit(data), static_cast<int>(p.at("rerank")));
+            for (const auto& vec : data) s->insert(vec);
+            return std::unique_ptr<DataStructure>(std::move(s));
+        }, nullptr});
+
+    // nlist = 0: regra usual de ~sqrt(N) listas. O treino entra no tempo de construção.
+    catalog.push_back({"ivf-pq", "IVF-PQ", {{"nlist", {0}}, {"m", {0}}, {"refine", {4}}}, {{"nprobe", {1, 4, 8, 16, 64}}},
+        [](const std::vector<FeatureVector>& data, const ParamSet& p) {
+            int nlist = static_cast<int>(p.at("nlist"));
+            if (nlist <= 0) nlist = std::max(1, static_cast<int>(std::sqrt(static_cast<double>(data.size()))));
+            auto s = std::make_unique<IVFIndex>(nlist, 8, static_cast<int>(p.at("m")), static_cast<int>(p.at("refine")));
+            s->train(data);
+            for (const auto& vec : data) s->insert(vec);
+            return std::unique_ptr<DataStructure>(std::move(s));
+        },
+        [](DataStructure& s, const ParamSet& p) {
+            static_cast<IVFIndex&>(s).setNprobe(static_cast<int>(p.at("nprobe")));
+        }});
+
+    catalog.push_back({"hnsw", "HNSW", {{"M", {16}}, {"efc", {200}}, {"threads", {static_cast<double>(threads)}}},
+                       {{"ef", {8, 16, 32, 64, 128}}},
+        [](const std::vector<FeatureVector>& data, const ParamSet& p) {
+            auto s = std::make_unique<HNSW>(static_cast<int>(p.at("M")), static_cast<int>(p.at("efc")));
+            int t = static_cast<int>(p.at("threads"));
+            if (t > 1) {
+                s->insertParallel(data, t);
+            } else {
+                for (const auto& vec : data) s->insert(vec);
+            }
+            return std::unique_ptr<DataStructure>(std::move(s));
+        },
+        [](DataStructure& s, const ParamSet& p) {
+            static_cast<HNSW&>(s).setEfSearch(static_cast<int>(p.at("ef")));
+        }});
+
+    catalog.push_back({"vp-tree", "VP-tree", {}, {},
+        [](const std::vector<FeatureVector>& data, const ParamSet&) {
+            auto s = std::make_unique<VPTree>();
+            s->build(data);
+            return std::unique_ptr<DataStructure>(std::move(s));
+        }, nullptr});
+
+    return catalog;
+}
+
+/**
+ * @brief Substitui os valores de um parâmetro da grade; retorna false se a estrutura não o tiver.
+ */
+inline bool overrideParam(StructureSpec& spec, const std::string& name, const std::vector<double>& values) {
+    for (ParamGrid* grid : {&spec.build_params, &spec.query_params}) {
+        for (auto& axis : *grid) {
+            if (axis.first == name) {
+                axis.second = values;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Uma única combinação, para quem atende consultas em vez de varrer a grade (server).
+ * @details Construção: o primeiro valor de cada parâmetro. Consulta: as grades começam pelo valor
+ * mais barato, bom para a curva recall x latência mas não para atender (ef=8 no HNSW, nprobe=1 no
+ * IVF-PQ), então essas estruturas têm aqui um valor de serviço: o menor da grade com recall@10
+ * perto do máximo em sintetico:50000:50 (HNSW 0.999 com ef=64; o IVF-PQ estabiliza em nprobe=8).
+ */
+inline ParamSet servingParams(const StructureSpec& spec) {
+    static const std::map<std::string, ParamSet> serving = {
+        {"hnsw", {{"ef", 64}}},
+        {"ivf-pq", {{"nprobe", 8}}},
+    };
+    ParamSet params = expandGrid(spec.build_params)[0];
+    ParamSet query_params = expandGrid(spec.query_params)[0];
+    auto it = serving.find(spec.key);
+    if (it != serving.end()) {
+        for (const auto& p : it->second) query_params[p.first] = p.second;
+    }
+    params.insert(query_params.begin(), query_params.end());
+    return params;
+}
+
+#endif // EXPERIMENT_HPP
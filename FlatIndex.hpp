@@ -0,0 +1,187 @@
+#ifndef FLAT_INDEX_HPP
+#define FLAT_INDEX_HPP
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <utility>
+#include <unordered_map>
+
+#include "DataStructure.hpp"
+#include "Quantization.hpp"
+
+/**
+ * @class FlatIndex
+ * @brief Busca exaustiva sobre um vetor contíguo de FeatureVectors.
+ * * Ao contrário da Lista (um nó alocado por vetor), os vetores ficam lado a lado
+ * na memória, então a varredura é sequencial. Opcionalmente guarda também
+ * códigos de 8 bits (ScalarQuantizer): a varredura lê apenas os códigos,
+ * seleciona os k * rerankFactor melhores candidatos e só eles são
+ * reordenados com a distância exata.
+ *
+ * A remoção move o último vetor (e o seu código) para a posição liberada: O(1),
+ * sem tombstones, e o vetor continua contíguo.
+ */
+class FlatIndex : public DataStructure {
+private:
+    std::vector<FeatureVector> vectors;
+
+    bool quantized;
+    ScalarQuantizer quantizer;
+    int rerankFactor;
+    std::vector<uint8_t> codes; // vectors.size() * CODE_DIM bytes
+    std::unordered_map<int, size_t> slotOf; // image_id -> posição em 'vectors'
+
+    // Tamanho do bloco de pontuações calculado de uma vez (cabe na L1).
+    static constexpr size_t SCORE_BLOCK = 1024;
+
+public:
+    FlatIndex() : quantized(false), rerankFactor(4) {}
+
+    ~FlatIndex() override = default;
+
+    /**
+     * @brief Ativa o modo quantizado; os vetores já inseridos são codificados.
+     * @param q Quantizador (ex.: ScalarQuantizer::fit(dataset)).
+     * @param rerank_factor Quantos candidatos por vizinho pedido passam pela reordenação exata.
+     */
+    void enableQuantization(const ScalarQuantizer& q, int rerank_factor = 4) {
+        quantized = true;
+        quantizer = q;
+        rerankFactor = std::max(1, rerank_factor);
+        codes.assign(vectors.size() * ScalarQuantizer::CODE_DIM, 0);
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            quantizer.encode(vectors[i], &codes[i * ScalarQuantizer::CODE_DIM]);
+        }
+    }
+
+    void insert(const FeatureVector& vec) override {
+        slotOf[vec.image_id] = vectors.size();
+        vectors.push_back(vec);
+        if (quantized) {
+            codes.resize(codes.size() + ScalarQuantizer::CODE_DIM);
+            quantizer.encode(vec, &codes[codes.size() - ScalarQuantizer::CODE_DIM]);
+        }
+    }
+
+    bool remove(int image_id) override {
+        auto it = slotOf.find(image_id);
+        if (it == slotOf.end()) return false;
+        size_t slot = it->second;
+        size_t last = vectors.size() - 1;
+        slotOf.erase(it);
+        if (slot != last) {
+            vectors[slot] = vectors[last];
+            slotOf[vectors[slot].image_id] = slot;
+            if (quantized) {
+                std::copy_n(&codes[last * ScalarQuantizer::CODE_DIM], ScalarQuantizer::CODE_DIM,
+                            &codes[slot * ScalarQuantizer::CODE_DIM]);
+            }
+        }
+        vectors.pop_back();
+        if (quantized) codes.resize(codes.size() - ScalarQuantizer::CODE_DIM);
+        return true;
+    }
+
+    QueryResult query(const FeatureVector& query_vec, int k) override {
+        if (k <= 0 || vectors.empty()) return QueryResult();
+        return quantized ? queryQuantized(query_vec, k) : queryExact(query_vec, k);
+    }
+
+    /**
+     * @details No modo exato, varre os vetores em blocos de SCORE_BLOCK e compara
+     * cada bloco com todas as consultas do lote enquanto ele ainda está na cache:
+     * o índice é lido da memória uma vez por lote, e não uma vez por consulta.
+     */
+    std::vector<QueryResult> queryBatch(const std::vector<FeatureVector>& queries, int k) override {
+        if (quantized || queries.size() < 2) return DataStructure::queryBatch(queries, k);
+        std::vector<QueryResult> results(queries.size());
+        if (k <= 0 || vectors.empty()) return results;
+
+        using Pair = std::pair<double, size_t>;
+        std::vector<std::priority_queue<Pair>> best(queries.size());
+        const size_t n = vectors.size();
+        for (size_t start = 0; start < n; start += SCORE_BLOCK) {
+            size_t end = std::min(n, start + SCORE_BLOCK);
+            for (size_t q = 0; q < queries.size(); ++q) {
+                std::priority_queue<Pair>& heap = best[q];
+                for (size_t i = start; i < end; ++i) {
+                    double dist = queries[q].distanceTo(vectors[i]);
+                    if (heap.size() < static_cast<size_t>(k)) {
+                        heap.emplace(dist, i);
+                    } else if (dist < heap.top().first) {
+                        heap.pop();
+                        heap.emplace(dist, i);
+                    }
+                }
+            }
+        }
+
+        for (size_t q = 0; q < queries.size(); ++q) {
+            QueryResult& result = results[q];
+            result.comparisons = static_cast<int>(n);
+            result.neighbors.resize(best[q].size());
+            for (size_t i = best[q].size(); i-- > 0; best[q].pop()) {
+                result.neighbors[i] = vectors[best[q].top().second];
+            }
+        }
+        return results;
+    }
+
+    MemoryUsage memoryUsage() const override {
+        MemoryUsage usage;
+        usage.addObject(sizeof(*this));
+        usage.addVector(vectors);
+        usage.addVector(codes);
+        usage.addMap(slotOf);
+        usage.countVectors(vectors.size());
+        return usage;
+    }
+
+private:
+    QueryResult queryExact(const FeatureVector& query_vec, int k) {
+        QueryResult result;
+
+        // Max-heap com os k melhores encontrados até agora.
+        using Pair = std::pair<double, size_t>;
+        std::priority_queue<Pair> best;
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            double dist = query_vec.distanceTo(vectors[i]);
+            result.comparisons++;
+            if (best.size() < static_cast<size_t>(k)) {
+                best.emplace(dist, i);
+            } else if (dist < best.top().first) {
+                best.pop();
+                best.emplace(dist, i);
+            }
+        }
+
+        result.neighbors.resize(best.size());
+        for (size_t i = best.size(); i-- > 0; best.pop()) {
+            result.neighbors[i] = vectors[best.top().second];
+        }
+        return result;
+    }
+
+    QueryResult queryQuantized(const FeatureVector& query_vec, int k) {
+        QueryResult result;
+        QuantizedQuery qq(quantizer, query_vec);
+        CandidateHeap<size_t> heap(static_cast<size_t>(k) * rerankFactor);
+
+        float scores[SCORE_BLOCK];
+        const size_t n = vectors.size();
+        for (size_t start = 0; start < n; start += SCORE_BLOCK) {
+            size_t count = std::min(SCORE_BLOCK, n - start);
+            scoreCodes(qq, &codes[start * ScalarQuantizer::CODE_DIM], count, scores);
+            for (size_t j = 0; j < count; ++j) heap.push(scores[j], start + j);
+        }
+        result.comparisons += static_cast<int>(n);
+
+        result.neighbors = rerankExact(query_vec, heap, k,
+                                       [this](size_t i) -> const FeatureVector& { return vectors[i]; },
+                                       result.comparisons);
+        return result;
+    }
+};
+
+#endif // FLAT_INDEX_HPP
@@ -0,0 +1,465 @@
+#ifndef HNSW_HPP
+#define HNSW_HPP
+
+#include <vector>
+#include <queue>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+
+#include "DataStructure.hpp"
+
+/**
+ * @class HNSW
+ * @brief Grafo hierárquico navegável de mundo pequeno (Hierarchical Navigable Small World).
+ * * Cada vetor é um nó presente nas camadas 0..level, com level sorteado de uma
+ * distribuição geométrica (a maioria só existe na camada 0). Nas camadas altas
+ * poucos nós e arestas longas permitem "pular" rapidamente para a região da
+ * consulta; a camada 0 contém todos os nós e é onde a busca fina acontece.
+ *
+ * Parâmetros:
+ * - M: vizinhos por nó nas camadas superiores (2*M na camada 0).
+ * - efConstruction: tamanho da lista de candidatos durante a inserção (qualidade do grafo).
+ * - efSearch: tamanho da lista de candidatos na consulta (controle recall x latência).
+ *
+ * insert() é sequencial; insertParallel() insere um lote com várias threads,
+ * usando um mutex por nó para as listas de vizinhos e um mutex global apenas
+ * quando o ponto de entrada muda. Consultas não devem rodar junto com inserções.
+ *
+ * Remoção por tombstone: o nó continua no grafo servindo de caminho, mas não
+ * entra nos resultados. Os vizinhos que apontavam para ele trocam essa aresta
+ * pelos vizinhos dele (repairLinks), então o grafo continua navegável sem o
+ * nó; isso custa O(M^2) distâncias por camada do nó, independente de n.
+ * Quando os apagados passam de MAX_DEAD_FRACTION, compact() repara as arestas
+ * de mão única que restaram e descarta os nós apagados, renumerando os vivos:
+ * O(n * M) sem nenhuma busca no grafo, O(M) amortizado por remoção.
+ */
+class HNSW : public DataStructure {
+private:
+    struct Node {
+        FeatureVector vec;
+        int level;
+        std::vector<std::vector<int>> links; // links[l] = vizinhos na camada l
+        std::mutex lock;
+        bool dead = false;                   // removido: só serve de caminho na busca
+
+        Node(const FeatureVector& v, int lvl) : vec(v), level(lvl), links(lvl + 1) {}
+    };
+
+    // Lista de "visitados" reutilizável: marcar com a geração atual evita limpar o vetor a cada busca.
+    struct VisitedList {
+        std::vector<uint32_t> tags;
+        uint32_t generation = 0;
+
+        void reset(size_t n) {
+            if (tags.size() < n) tags.resize(n, 0);
+            if (++generation == 0) {
+                std::fill(tags.begin(), tags.end(), 0);
+                generation = 1;
+            }
+        }
+        bool visit(int i) {
+            if (tags[i] == generation) return false;
+            tags[i] = generation;
+            return true;
+        }
+    };
+
+    using Candidate = std::pair<double, int>; // (distância, nó)
+    struct CloserFirst {
+        bool operator()(const Candidate& a, const Candidate& b) const { return a.first > b.first; }
+    };
+    using MinHeap = std::priority_queue<Candidate, std::vector<Candidate>, CloserFirst>;
+    using MaxHeap = std::priority_queue<Candidate>;
+
+    int M;
+    int maxM0;
+    int efConstruction;
+    int efSearch;
+    double levelMult;
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::atomic<int> entryPoint;
+    std::atomic<int> maxLevel;
+    std::mutex globalLock;
+
+    std::mutex visitedPoolLock;
+    std::vector<std::unique_ptr<VisitedList>> visitedPool;
+
+    std::mt19937 levelRng;
+    std::mutex levelRngLock;
+
+    std::unordered_map<int, int> nodeById; // image_id -> índice em 'nodes'
+    size_t deadCount = 0;
+
+    int randomLevel() {
+        std::lock_guard<std::mutex> guard(levelRngLock);
+        double u = std::uniform_real_distribution<double>(std::numeric_limits<double>::min(), 1.0)(levelRng);
+        return static_cast<int>(-std::log(u) * levelMult);
+    }
+
+    std::unique_ptr<VisitedList> acquireVisited() {
+        std::lock_guard<std::mutex> guard(visitedPoolLock);
+        if (visitedPool.empty()) return std::make_unique<VisitedList>();
+        auto v = std::move(visitedPool.back());
+        visitedPool.pop_back();
+        return v;
+    }
+
+    void releaseVisited(std::unique_ptr<VisitedList> v) {
+        std::lock_guard<std::mutex> guard(visitedPoolLock);
+        visitedPool.push_back(std::move(v));
+    }
+
+    // Cópia dos vizinhos de um nó numa camada (protegida pelo mutex do nó).
+    void neighborsOf(int id, int layer, std::vector<int>& out) {
+        Node& n = *nodes[id];
+        std::lock_guard<std::mutex> guard(n.lock);
+        out = n.links[layer];
+    }
+
+    // Descida gulosa numa camada: move para o vizinho mais próximo enquanto houver melhora.
+    int greedyClosest(const FeatureVector& q, int start, int layer, int& comparisons) {
+        int cur = start;
+        double cur_dist = q.distanceTo(nodes[cur]->vec);
+        comparisons++;
+        std::vector<int> neigh;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            neighborsOf(cur, layer, neigh);
+            for (int nb : neigh) {
+                double d = q.distanceTo(nodes[nb]->vec);
+                comparisons++;
+                if (d < cur_dist) {
+                    cur_dist = d;
+                    cur = nb;
+                    changed = true;
+                }
+            }
+        }
+        return cur;
+    }
+
+    /**
+     * @brief Busca em largura guiada numa camada (Algoritmo 2 do artigo do HNSW).
+     * @param live_only Se true, nós apagados são percorridos mas não entram no resultado
+     * (contados em 'stats', se houver). A construção usa false: eles ainda servem de vizinhos.
+     * @return Max-heap com os 'ef' nós mais próximos encontrados.
+     */
+    MaxHeap searchLayer(const FeatureVector& q, int entry, int ef, int layer, int& comparisons,
+                        bool live_only = false, QueryStats* stats = nullptr) {
+        auto visited = acquireVisited();
+        visited->reset(nodes.size());
+
+        MinHeap candidates;
+        MaxHeap found;
+        double d0 = q.distanceTo(nodes[entry]->vec);
+        comparisons++;
+        visited->visit(entry);
+        candidates.emplace(d0, entry);
+        auto accept = [&](double d, int id) {
+            if (live_only && nodes[id]->dead) {
+                if (stats) stats->skipDead();
+                return;
+            }
+            found.emplace(d, id);
+            if (static_cast<int>(found.size()) > ef) found.pop();
+        };
+        accept(d0, entry);
+
+        std::vector<int> neigh;
+        while (!candidates.empty()) {
+            Candidate cur = candidates.top();
+            if (static_cast<int>(found.size()) >= ef && cur.first > found.top().first) break;
+            candidates.pop();
+
+            neighborsOf(cur.second, layer, neigh);
+            for (int nb : neigh) {
+                if (!visited->visit(nb)) continue;
+                double d = q.distanceTo(nodes[nb]->vec);
+                comparisons++;
+                if (static_cast<int>(found.size()) < ef || d < found.top().first) {
+                    candidates.emplace(d, nb);
+                    accept(d, nb);
+                }
+            }
+        }
+
+        releaseVisited(std::move(visited));
+        return found;
+    }
+
+    /**
+     * @brief Heurística de seleção de vizinhos (Algoritmo 4): prefere candidatos que
+     * estão mais perto do nó do que de qualquer vizinho já escolhido, o que mantém
+     * arestas em várias direções e a navegabilidade em dados agrupados.
+     */
+    std::vector<int> selectNeighbors(MaxHeap found, int max_links) {
+        std::vector<Candidate> sorted;
+        while (!found.empty()) {
+            sorted.push_back(found.top());
+            found.pop();
+        }
+        std::reverse(sorted.begin(), sorted.end()); // mais próximos primeiro
+
+        std::vector<int> chosen;
+        for (const auto& c : sorted) {
+            if (static_cast<int>(chosen.size()) >= max_links) break;
+            bool good = true;
+            for (int s : chosen) {
+                if (nodes[c.second]->vec.distanceTo(nodes[s]->vec) < c.first) {
+                    good = false;
+                    break;
+                }
+            }
+            if (good) chosen.push_back(c.second);
+        }
+        return chosen;
+    }
+
+    // Adiciona 'id' aos vizinhos de 'nb' na camada, podando pela heurística se exceder o limite.
+    void linkBack(int nb, int id, int layer) {
+        int max_links = layer == 0 ? maxM0 : M;
+        Node& n = *nodes[nb];
+        std::lock_guard<std::mutex> guard(n.lock);
+        auto& links = n.links[layer];
+        if (std::find(links.begin(), links.end(), id) != links.end()) return;
+        if (static_cast<int>(links.size()) < max_links) {
+            links.push_back(id);
+            return;
+        }
+        MaxHeap cand;
+        cand.emplace(n.vec.distanceTo(nodes[id]->vec), id);
+        for (int other : links) cand.emplace(n.vec.distanceTo(nodes[other]->vec), other);
+        links = selectNeighbors(std::move(cand), max_links);
+    }
+
+    /**
+     * @brief Troca as arestas de 'id' para nós apagados, na camada, pelos vizinhos vivos desses nós.
+     * @details Os candidatos (vizinhos vivos atuais mais os vizinhos dos apagados)
+     * passam pela mesma heurística da inserção. Não faz nada se nenhum vizinho está apagado.
+     */
+    void repairLinks(int id, int layer) {
+        Node& n = *nodes[id];
+        std::vector<int> links, via;
+        neighborsOf(id, layer, links);
+        std::vector<int> seen{id};
+        MaxHeap cand;
+        auto add = [&](int c) {
+            if (nodes[c]->dead || std::find(seen.begin(), seen.end(), c) != seen.end()) return;
+            seen.push_back(c);
+            cand.emplace(n.vec.distanceTo(nodes[c]->vec), c);
+        };
+        bool repaired = false;
+        for (int c : links) {
+            if (!nodes[c]->dead) {
+                add(c);
+                continue;
+            }
+            repaired = true;
+            neighborsOf(c, layer, via);
+            for (int v : via) add(v);
+        }
+        if (!repaired) return;
+        std::vector<int> chosen = selectNeighbors(std::move(cand), layer == 0 ? maxM0 : M);
+        std::lock_guard<std::mutex> guard(n.lock);
+        n.links[layer] = std::move(chosen);
+    }
+
+    // Insere o nó já alocado em nodes[id].
+    void insertNode(int id) {
+        Node& node = *nodes[id];
+        int level = node.level;
+        int comparisons = 0;
+
+        std::unique_lock<std::mutex> global(globalLock);
+        int ep = entryPoint.load();
+        if (ep < 0) {
+            entryPoint = id;
+            maxLevel = level;
+            return;
+        }
+        int top = maxLevel.load();
+        // Só quem pode virar o novo ponto de entrada segura o mutex global durante a inserção.
+        if (level <= top) global.unlock();
+
+        for (int l = top; l > level; --l) ep = greedyClosest(node.vec, ep, l, comparisons);
+
+        for (int l = std::min(level, top); l >= 0; --l) {
+            MaxHeap found = searchLayer(node.vec, ep, efConstruction, l, comparisons);
+            // O candidato mais próximo é o ponto de partida da camada de baixo.
+            {
+                MaxHeap copy = found;
+                while (copy.size() > 1) copy.pop();
+                ep = copy.top().second;
+            }
+            std::vector<int> neighbors = selectNeighbors(std::move(found), M);
+            {
+                std::lock_guard<std::mutex> guard(node.lock);
+                node.links[l] = neighbors;
+            }
+            for (int nb : neighbors) linkBack(nb, id, l);
+        }
+
+        if (level > top) {
+            entryPoint = id;
+            maxLevel = level;
+        }
+    }
+
+public:
+    /**
+     * @param m Vizinhos por nó nas camadas superiores (2*m na camada 0).
+     * @param ef_construction Largura da busca durante a inserção.
+     * @param ef_search Largura da busca durante a consulta (ao menos k).
+     */
+    HNSW(int m = 16, int ef_construction = 200, int ef_search = 64)
+        : M(std::max(2, m)), maxM0(2 * std::max(2, m)),
+          efConstruction(std::max(1, ef_construction)), efSearch(std::max(1, ef_search)),
+          levelMult(1.0 / std::log(static_cast<double>(std::max(2, m)))),
+          entryPoint(-1), maxLevel(-1), levelRng(42) {}
+
+    ~HNSW() override = default;
+
+    void setEfSearch(int ef) { efSearch = std::max(1, ef); }
+    int getEfSearch() const { return efSearch; }
+
+    void insert(const FeatureVector& vec) override {
+        nodeById[vec.image_id] = static_cast<int>(nodes.size());
+        nodes.push_back(std::make_unique<Node>(vec, randomLevel()));
+        insertNode(static_cast<int>(nodes.size()) - 1);
+    }
+
+    bool remove(int image_id) override {
+        auto it = nodeById.find(image_id);
+        if (it == nodeById.end()) return false;
+        int id = it->second;
+        Node& node = *nodes[id];
+        node.dead = true;
+        nodeById.erase(it);
+        deadCount++;
+        std::vector<int> neigh;
+        for (int l = 0; l <= node.level; ++l) {
+            neighborsOf(id, l, neigh);
+            for (int nb : neigh) {
+                if (!nodes[nb]->dead) repairLinks(nb, l);
+            }
+        }
+        if (compactionDue(deadCount, nodes.size())) compact();
+        return true;
+    }
+
+    /**
+     * @brief Descarta os nós apagados e renumera os vivos, sem reinserir nenhum.
+     * @details Antes, cada vivo que ainda aponta para um apagado (aresta de mão
+     * única, que o apagado não conhecia) troca essa aresta pelos vizinhos dele.
+     * Se o ponto de entrada foi apagado, o vivo de camada mais alta o substitui.
+     */
+    void compact() {
+        if (deadCount == 0) return;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i]->dead) continue;
+            for (int l = 0; l <= nodes[i]->level; ++l) repairLinks(static_cast<int>(i), l);
+        }
+
+        std::vector<int> renumber(nodes.size(), -1);
+        size_t kept = 0;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (!nodes[i]->dead) renumber[i] = static_cast<int>(kept++);
+        }
+        int ep = entryPoint.load();
+        int new_ep = ep >= 0 ? renumber[ep] : -1;
+        int new_top = new_ep >= 0 ? nodes[ep]->level : -1;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i]->dead) continue;
+            for (auto& links : nodes[i]->links) {
+                size_t out = 0;
+                for (int nb : links) {
+                    if (renumber[nb] >= 0) links[out++] = renumber[nb];
+                }
+                links.resize(out);
+            }
+            if (new_ep < 0 || nodes[i]->level > new_top) {
+                new_ep = renumber[i];
+                new_top = nodes[i]->level;
+            }
+            nodes[renumber[i]] = std::move(nodes[i]);
+        }
+        nodes.resize(kept);
+
+        nodeById.clear();
+        for (size_t i = 0; i < nodes.size(); ++i) nodeById[nodes[i]->vec.image_id] = static_cast<int>(i);
+        deadCount = 0;
+        entryPoint = new_ep;
+        maxLevel = new_top;
+    }
+
+    /**
+     * @brief Insere um lote de vetores usando 'threads' threads.
+     * @details Os nós são alocados antes (o vetor 'nodes' não cresce durante a
+     * inserção concorrente) e cada thread pega o próximo índice de um contador atômico.
+     */
+    void insertParallel(const std::vector<FeatureVector>& batch, int threads) {
+        size_t base = nodes.size();
+        nodes.resize(base + batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            nodes[base + i] = std::make_unique<Node>(batch[i], randomLevel());
+            nodeById[batch[i].image_id] = static_cast<int>(base + i);
+        }
+
+        threads = std::max(1, threads);
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t i = next++; i < batch.size(); i = next++) insertNode(static_cast<int>(base + i));
+        };
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& th : pool) th.join();
+    }
+
+    QueryResult query(const FeatureVector& query_vec, int k) override {
+        QueryResult result;
+        int ep = entryPoint.load();
+        if (k <= 0 || ep < 0) return result;
+
+        for (int l = maxLevel.load(); l > 0; --l) ep = greedyClosest(query_vec, ep, l, result.comparisons);
+        MaxHeap found = searchLayer(query_vec, ep, std::max(efSearch, k), 0, result.comparisons, true, &result.stats);
+
+        while (static_cast<int>(found.size()) > k) found.pop();
+        result.neighbors.resize(found.size());
+        for (size_t i = found.size(); i-- > 0; found.pop()) {
+            result.neighbors[i] = nodes[found.top().second]->vec;
+        }
+        return result;
+    }
+
+    MemoryUsage memoryUsage() const override {
+        MemoryUsage usage;
+        usage.addObject(sizeof(*this));
+        usage.addVector(nodes);
+        for (const auto& node : nodes) {
+            usage.addBlock(node.get(), sizeof(Node), sizeof(Node));
+            usage.addVector(node->links);
+            for (const auto& layer : node->links) usage.addVector(layer);
+        }
+        usage.addMap(nodeById);
+        usage.addVector(visitedPool);
+        for (const auto& v : visitedPool) {
+            usage.addBlock(v.get(), sizeof(VisitedList), sizeof(VisitedList));
+            usage.addVector(v->tags);
+        }
+        usage.countVectors(nodes.size() - deadCount);
+        return usage;
+    }
+};
+
+#endif // HNSW_HPP
@@ -3,99 +3,377 @@
 
 #include <vector>
 #include <unordered_set>
+#include <unordered_map>
 #include <algorithm>
+#include <cmath>
 
 #include "DataStructure.hpp"
 #include "Vector.hpp"
+#include "SpaceFillingCurve.hpp"
+
+// Função hash que mapeia um vetor de características para um bucket da tabela 'seed'.
+// Cada tabela usa uma grade deslocada por uma fração (seed / numHashes) do tamanho do bin,
+// o que funciona tanto para cores médias (0-255) quanto para histogramas (0-1).
+inline int lshBucket(const FeatureVector& vec, int seed, double binSize, int numHashes, int numBuckets) {
+    double offset = seed * binSize / numHashes;
+    unsigned int hash_value = 2166136261u ^ static_cast<unsigned int>(seed);
+    for (int d = 0; d < FeatureVector::DIM; ++d) {
+        int bin = static_cast<int>(std::floor((vec[d] + offset) / binSize));
+        hash_value = (hash_value ^ static_cast<unsigned int>(bin)) * 16777619u; //Espalhar e reduzir colisões
+    }
+    return static_cast<int>(hash_value % static_cast<unsigned int>(numBuckets));
+}
+
 // Estrutura que representa cada nó da tabela hash
 struct HashNode {
     FeatureVector data;
     HashNode* next;
+    HashNode* sibling; // cópia do mesmo vetor na tabela seguinte (nullptr na última)
+    bool dead;         // removido: ignorado nas consultas até a compactação
 
     HashNode() {
         next = nullptr;
+        sibling = nullptr;
+        dead = false;
     }
 
     HashNode(const FeatureVector& v) {
         data = v;
         next = nullptr;
+        sibling = nullptr;
+        dead = false;
     }
 };
 // Classe que implementa a tabela hash
+// Remoção por tombstone: as cópias do vetor são marcadas e puladas nas consultas,
+// e as cadeias são limpas de uma vez quando os apagados passam de MAX_DEAD_FRACTION.
 class HashTable : public DataStructure {
 private:
     int numBuckets;
     int numHashes;
-    int binSize;
+    double binSize;
     std::vector<std::vector<HashNode*>> tables;
-    int comparisons;
-    // Função hash que mapeia um vetor de características para um índice
+    std::unordered_map<int, HashNode*> byId; // image_id -> cópia na tabela 0 (as outras seguem por 'sibling')
+    size_t live = 0;
+    size_t dead = 0;
+    int interleave = 8; // consultas percorridas juntas em queryBatch() (1 = uma de cada vez)
+    // Tabela compactada (pack): cada vetor uma vez em 'store', e cada tabela h guarda os buckets
+    // em sequência, o bucket b em entries[h][bucketStart[h][b] .. bucketStart[h][b + 1]).
+    bool packed = false;
+    std::vector<FeatureVector> store;
+    std::vector<std::vector<uint32_t>> bucketStart;
+    std::vector<std::vector<uint32_t>> entries;
+    // Função hash que mapeia um vetor de características para um índice.
     int hashFunction(const FeatureVector& vec, int seed) const {
-        int r_bin = static_cast<int>((vec.r + seed) / binSize);
-        int g_bin = static_cast<int>((vec.g + seed) / binSize);
-        int b_bin = static_cast<int>((vec.b + seed) / binSize);
-        int hash_value = (r_bin * 73856093) ^ (g_bin * 19349663) ^ (b_bin * 83492791) ^ seed; //Espalhar e reduzir colisões
-        return (hash_value % numBuckets + numBuckets) % numBuckets; //garantir que seja positivo
+        return lshBucket(vec, seed, binSize, numHashes, numBuckets);
+    }
+
+    // Visita um nó da cadeia: candidato novo, duplicata de outra tabela ou apagado.
+    static void visit(const HashNode* node, std::unordered_set<int>& seen, std::vector<FeatureVector>& candidates,
+                      QueryResult& result) {
+        if (node->dead) {
+            result.stats.skipDead();
+        } else if (seen.insert(node->data.image_id).second) {
+            candidates.push_back(node->data);
+        } else {
+            result.stats.duplicateHit();
+        }
+    }
+
+    static void endChain(size_t chain, QueryResult& result) {
+        result.stats.probeBucket(chain);
+        result.stats.touch(sizeof(HashNode*) + chain * sizeof(HashNode));
+    }
+
+    // Ordena os candidatos pelo grau de similaridade (maior primeiro) e guarda os k primeiros.
+    static void finish(const FeatureVector& q, int k, std::vector<FeatureVector>& candidates, QueryResult& result) {
+        std::sort(candidates.begin(), candidates.end(), [&](const FeatureVector& a, const FeatureVector& b){
+            return q.similarityTo(a) > q.similarityTo(b);
+        });
+
+        // Adiciona os k mais semelhantes ao resultado
+        for (int i = 0; i < std::min(k, (int)candidates.size()); i++) {
+            result.neighbors.push_back(candidates[i]);
+        }
+
+        result.comparisons = static_cast<int>(candidates.size()); // registra o número de comparações
+    }
+
+    // Pede as linhas do nó que a visita lê: o início do vetor e o ponteiro 'next' depois dele.
+    static void prefetchNode(const HashNode* node) {
+        prefetchRead(node);
+        prefetchRead(&node->next);
     }
 
 public:
     // Construtor da tabela hash
-    HashTable(int buckets = 1013, int hashes = 5, int bin = 25)
-        : numBuckets(buckets), numHashes(hashes), binSize(bin), comparisons(0){
+    HashTable(int buckets = 1013, int hashes = 5, double bin = 25)
+        : numBuckets(buckets), numHashes(hashes), binSize(bin) {
         tables.resize(numHashes, std::vector<HashNode*>(numBuckets, nullptr));
     }
     // Destrutor da tabela hash
     ~HashTable() {
-        for (int h = 0; h < numHashes; h++) {
-            for (auto head : tables[h]) {
-                while (head) {
-                    HashNode* tmp = head;
-                    head = head->next;
-                    delete tmp;
-                }
-            }
-        }
+        freeChains();
     }
     // Insere um vetor de características em todas as tabelas hash
     void insert(const FeatureVector& vec) override {
+        unpack();
+        HashNode* prev = nullptr;
         for (int h = 0; h < numHashes; h++) {
             int idx = hashFunction(vec, h);
             HashNode* node = new HashNode(vec);
             node->next = tables[h][idx];
             tables[h][idx] = node;
+            if (prev) prev->sibling = node;
+            else byId[vec.image_id] = node;
+            prev = node;
+        }
+        live++;
+    }
+
+    // Marca as cópias do vetor como apagadas; O(numHashes) mais a compactação amortizada.
+    bool remove(int image_id) override {
+        unpack();
+        auto it = byId.find(image_id);
+        if (it == byId.end()) return false;
+        for (HashNode* node = it->second; node; node = node->sibling) node->dead = true;
+        byId.erase(it);
+        live--;
+        dead++;
+        if (compactionDue(dead, live + dead)) compact();
+        return true;
+    }
+
+    // Tira das cadeias e libera todos os nós apagados.
+    void compact() {
+        for (int h = 0; h < numHashes; h++) {
+            for (auto& head : tables[h]) {
+                HashNode** link = &head;
+                while (*link) {
+                    HashNode* node = *link;
+                    if (node->dead) {
+                        *link = node->next;
+                        delete node;
+                    } else {
+                        link = &node->next;
+                    }
+                }
+            }
         }
+        dead = 0;
     }
+
+    // Memória: cada vetor aparece em todas as tabelas, as cópias além da primeira contam como overhead
+    MemoryUsage memoryUsage() const override {
+        MemoryUsage usage;
+        usage.addObject(sizeof(*this));
+        usage.addVector(tables);
+        usage.addMap(byId);
+        usage.addVector(store);
+        usage.addVector(bucketStart);
+        usage.addVector(entries);
+        for (int h = 0; h < (int)entries.size(); h++) {
+            usage.addVector(bucketStart[h]);
+            usage.addVector(entries[h]);
+        }
+        size_t n = store.size();
+        for (int h = 0; h < numHashes; h++) {
+            usage.addVector(tables[h]);
+            for (HashNode* node : tables[h]) {
+                for (; node; node = node->next) {
+                    usage.addBlock(node, sizeof(HashNode), sizeof(HashNode));
+                    if (h == 0 && !node->dead) n++;
+                }
+            }
+        }
+        usage.countVectors(n);
+        return usage;
+    }
+
     // Consulta os k vizinhos mais semelhantes de um vetor q
     QueryResult query(const FeatureVector& q, int k) override {
         QueryResult result;
         std::vector<FeatureVector> candidates;
-        std::unordered_set<FeatureVector*> seen;
+        // Cada tabela guarda sua própria cópia do vetor, então a deduplicação é pelo image_id.
+        std::unordered_set<int> seen;
+
+        if (packed) {
+            for (int h = 0; h < numHashes; h++) {
+                int idx = hashFunction(q, h);
+                uint32_t begin = bucketStart[h][idx], end = bucketStart[h][idx + 1];
+                for (uint32_t e = begin; e < end; ++e) {
+                    const FeatureVector& vec = store[entries[h][e]];
+                    if (seen.insert(vec.image_id).second) candidates.push_back(vec);
+                    else result.stats.duplicateHit();
+                }
+                result.stats.probeBucket(end - begin);
+                result.stats.touch(2 * sizeof(uint32_t) + (end - begin) * (sizeof(uint32_t) + sizeof(FeatureVector)));
+            }
+            finish(q, k, candidates, result);
+            return result;
+        }
 
         for (int h = 0; h < numHashes; h++) {
             int idx = hashFunction(q, h);
             HashNode* node = tables[h][idx];
+            size_t chain = 0;
             while (node) {
-                if (seen.find(&node->data) == seen.end()) {
-                    candidates.push_back(node->data);
-                    seen.insert(&node->data);
-                }
+                ++chain;
+                visit(node, seen, candidates, result);
                 node = node->next;
             }
+            endChain(chain, result);
         }
-        comparisons = candidates.size();
 
-        // Ordena os candidatos pelo grau de similaridade (maior primeiro)
-        std::sort(candidates.begin(), candidates.end(), [&](const FeatureVector& a, const FeatureVector& b){
-            return q.similarityTo(a) > q.similarityTo(b);
-        });
+        finish(q, k, candidates, result);
+        return result;
+    }
 
-        // Adiciona os k mais semelhantes ao resultado
-        for (int i = 0; i < std::min(k, (int)candidates.size()); i++) {
-            result.neighbors.push_back(candidates[i]);
+    void setInterleave(int width) { interleave = std::max(1, width); }
+    int getInterleave() const { return interleave; }
+
+    /**
+     * @brief Consultas em lote com as cadeias de 'interleave' consultas percorridas juntas.
+     * @details Em query() cada passo da cadeia espera a leitura do nó anterior
+     * para saber o endereço do próximo. Aqui, a cada rodada, cada consulta do
+     * grupo visita um nó e pede (prefetch) o seguinte, que tem as rodadas das
+     * outras consultas para chegar da memória. Os buckets de todas as tabelas
+     * são calculados e pedidos antes do percurso. Os resultados e estatísticas
+     * são os mesmos de query(); com interleave = 1 é o laço sobre query().
+     */
+    std::vector<QueryResult> queryBatch(const std::vector<FeatureVector>& queries, int k) override {
+        if (interleave <= 1 || packed) return DataStructure::queryBatch(queries, k);
+        std::vector<QueryResult> results(queries.size());
+
+        struct Cursor {
+            const HashNode* node = nullptr;
+            int table = 0;
+            size_t chain = 0;
+            std::unordered_set<int> seen;
+            std::vector<FeatureVector> candidates;
+        };
+        std::vector<Cursor> cursors(interleave);
+        std::vector<int> buckets(static_cast<size_t>(interleave) * numHashes);
+
+        for (size_t base = 0; base < queries.size(); base += interleave) {
+            size_t n = std::min(static_cast<size_t>(interleave), queries.size() - base);
+            for (size_t i = 0; i < n; ++i) {
+                for (int h = 0; h < numHashes; h++) {
+                    int idx = hashFunction(queries[base + i], h);
+                    buckets[i * numHashes + h] = idx;
+                    prefetchRead(&tables[h][idx]);
+                }
+            }
+            for (size_t i = 0; i < n; ++i) {
+                Cursor& c = cursors[i];
+                c.table = 0;
+                c.chain = 0;
+                c.seen.clear();
+                c.candidates.clear();
+                c.node = tables[0][buckets[i * numHashes]];
+                if (c.node) prefetchNode(c.node);
+            }
+
+            size_t active = n;
+            while (active > 0) {
+                for (size_t i = 0; i < n; ++i) {
+                    Cursor& c = cursors[i];
+                    if (c.table == numHashes) continue;
+                    if (c.node) {
+                        ++c.chain;
+                        visit(c.node, c.seen, c.candidates, results[base + i]);
+                        c.node = c.node->next;
+                    } else {
+                        // Fim da cadeia desta tabela: passa ao bucket da próxima.
+                        endChain(c.chain, results[base + i]);
+                        c.chain = 0;
+                        if (++c.table == numHashes) {
+                            active--;
+                            continue;
+                        }
+                        c.node = tables[c.table][buckets[i * numHashes + c.table]];
+                    }
+                    if (c.node) prefetchNode(c.node);
+                }
+            }
+            for (size_t i = 0; i < n; ++i) finish(queries[base + i], k, cursors[i].candidates, results[base + i]);
         }
+        return results;
+    }
 
-        result.comparisons = comparisons;    // registra o número de comparações
-        return result;
+    /**
+     * @brief Compacta a tabela: troca as cadeias de nós por vetores contíguos.
+     * @details Cada vetor vivo passa a existir uma vez só, em 'store', na ordem
+     * da curva escolhida (ou na ordem dos image_id, com CurveOrder::None),
+     * e cada tabela guarda os seus buckets em sequência como índices em 'store',
+     * crescentes dentro do bucket. Um bucket vira um trecho contíguo de índices
+     * em vez de uma cadeia de ponteiros, e os vetores de um bucket, próximos no
+     * espaço, ficam próximos também em 'store'. Os apagados são descartados. Use
+     * depois de uma carga: a próxima inserção ou remoção refaz as cadeias (unpack).
+     */
+    void pack(CurveOrder order) {
+        unpack();
+        // Os nós da tabela 0 trazem cada vetor vivo uma vez; as cadeias têm os mais novos na frente.
+        std::vector<FeatureVector> items;
+        items.reserve(live);
+        for (HashNode* head : tables[0]) {
+            for (HashNode* node = head; node; node = node->next) {
+                if (!node->dead) items.push_back(node->data);
+            }
+        }
+        std::sort(items.begin(), items.end(),
+                  [](const FeatureVector& a, const FeatureVector& b) { return a.image_id < b.image_id; });
+        freeChains();
+        byId.clear();
+        dead = 0;
+
+        std::vector<size_t> perm = curvePermutation(items, order);
+        store.clear();
+        store.reserve(items.size());
+        for (size_t i : perm) store.push_back(items[i]);
+
+        bucketStart.assign(numHashes, std::vector<uint32_t>(numBuckets + 1, 0));
+        entries.assign(numHashes, std::vector<uint32_t>(store.size()));
+        std::vector<int> bucketOf(store.size());
+        for (int h = 0; h < numHashes; h++) {
+            std::vector<uint32_t>& start = bucketStart[h];
+            for (size_t i = 0; i < store.size(); ++i) {
+                bucketOf[i] = hashFunction(store[i], h);
+                start[bucketOf[i] + 1]++;
+            }
+            for (int b = 0; b < numBuckets; b++) start[b + 1] += start[b];
+            std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+            for (size_t i = 0; i < store.size(); ++i) entries[h][fill[bucketOf[i]]++] = static_cast<uint32_t>(i);
+        }
+        live = store.size();
+        packed = true;
+    }
+
+    // Refaz as cadeias a partir de 'store' (a tabela volta a aceitar inserções e remoções).
+    void unpack() {
+        if (!packed) return;
+        packed = false;
+        std::vector<FeatureVector> items;
+        items.swap(store);
+        std::vector<std::vector<uint32_t>>().swap(bucketStart);
+        std::vector<std::vector<uint32_t>>().swap(entries);
+        live = 0;
+        for (const auto& vec : items) insert(vec);
+    }
+
+    bool isPacked() const { return packed; }
+
+private:
+    void freeChains() {
+        for (int h = 0; h < numHashes; h++) {
+            for (auto& head : tables[h]) {
+                while (head) {
+                    HashNode* tmp = head;
+                    head = head->next;
+                    delete tmp;
+                }
+            }
+        }
     }
 };
 
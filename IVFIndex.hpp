@@ -0,0 +1,329 @@
+#ifndef IVF_INDEX_HPP
+#define IVF_INDEX_HPP
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+
+#include "DataStructure.hpp"
+#include "KMeans.hpp"
+#include "Quantization.hpp" // CandidateHeap e rerankExact
+
+/**
+ * @class IVFIndex
+ * @brief Índice de arquivo invertido (IVF) com quantização por produto (PQ).
+ * * Os vetores são normalizados (norma 1), de modo que a distância do cosseno
+ * vira metade da distância euclidiana ao quadrado e o k-means euclidiano serve
+ * para agrupá-los.
+ *
+ * - Nível grosso: 'nlist' centróides (k-means); cada vetor vai para a lista
+ *   invertida do centróide mais próximo.
+ * - Nível fino: o resíduo (vetor - centróide) é dividido em M subvetores e cada
+ *   um é trocado pelo índice (1 byte) do centróide mais próximo de um dicionário
+ *   de 256 palavras treinado para aquele subespaço.
+ * - Consulta: visita as 'nprobe' listas mais próximas. Para cada lista monta uma
+ *   tabela M x 256 com as distâncias do resíduo da consulta a cada palavra, e a
+ *   distância a um código é a soma de M consultas à tabela (ADC). Os
+ *   k * refineFactor melhores candidatos são reordenados com distanceTo.
+ *
+ * 'nprobe' é o controle de recall/latência: 1 visita só a lista mais próxima e
+ * 'nlist' equivale a uma varredura completa dos códigos.
+ *
+ * Vetores inseridos antes do treino ficam pendentes e são usados como amostra
+ * de treino na primeira consulta (ou chame train() explicitamente).
+ *
+ * Remoção por tombstone: o vetor é marcado e pulado na varredura das listas;
+ * quando os apagados passam de MAX_DEAD_FRACTION, 'vectors' e as listas são
+ * compactados de uma vez (sem recalcular os códigos).
+ */
+class IVFIndex : public DataStructure {
+private:
+    static constexpr int DIM = FeatureVector::DIM;
+    static constexpr int KSUB = 256;             // palavras por subquantizador (1 byte)
+    static constexpr size_t MAX_TRAIN = 65536;   // limite da amostra de treino
+
+    struct InvertedList {
+        std::vector<int> ids;         // posições em 'vectors'
+        std::vector<uint8_t> codes;   // ids.size() * M bytes
+    };
+
+    int nlist;
+    int nprobe;
+    int M;
+    int refineFactor;
+    bool trained;
+
+    std::vector<float> coarse;                 // nlist * DIM
+    std::vector<int> subStart;                 // M + 1 limites dos subespaços
+    std::vector<std::vector<float>> codebooks; // M x (KSUB * tamanho do subespaço)
+    std::vector<InvertedList> lists;
+    std::vector<FeatureVector> vectors;        // vetores originais, para reordenação
+    std::vector<FeatureVector> pending;        // inseridos antes do treino
+    std::vector<uint8_t> dead;                 // dead[i] = 1 se vectors[i] foi removido
+    size_t deadCount = 0;
+    std::unordered_map<int, int> slotById;     // image_id -> posição em 'vectors' (ou em 'pending' antes do treino)
+
+    // Número de subquantizadores padrão: subespaços de ~8 dimensões (1 por dimensão no RGB).
+    static int defaultM() {
+        return DIM <= 8 ? DIM : (DIM + 7) / 8;
+    }
+
+    static void normalize(const FeatureVector& vec, float* out) {
+        double sq = 0.0;
+        for (int d = 0; d < DIM; ++d) sq += static_cast<double>(vec[d]) * static_cast<double>(vec[d]);
+        double inv = sq > 0.0 ? 1.0 / std::sqrt(sq) : 0.0;
+        for (int d = 0; d < DIM; ++d) out[d] = static_cast<float>(static_cast<double>(vec[d]) * inv);
+    }
+
+    int subLen(int m) const { return subStart[m + 1] - subStart[m]; }
+
+    // Codifica o resíduo 'r' (DIM floats) em M bytes.
+    void encodeResidual(const float* r, uint8_t* code) const {
+        for (int m = 0; m < M; ++m) {
+            int len = subLen(m);
+            int ksub = static_cast<int>(codebooks[m].size() / len);
+            code[m] = static_cast<uint8_t>(nearestCentroid(r + subStart[m], codebooks[m], ksub, len));
+        }
+    }
+
+    void addToList(const FeatureVector& vec) {
+        float x[DIM], r[DIM];
+        normalize(vec, x);
+        int list = nearestCentroid(x, coarse, nlist, DIM);
+        for (int d = 0; d < DIM; ++d) r[d] = x[d] - coarse[static_cast<size_t>(list) * DIM + d];
+
+        InvertedList& inv = lists[list];
+        inv.ids.push_back(static_cast<int>(vectors.size()));
+        inv.codes.resize(inv.codes.size() + M);
+        encodeResidual(r, &inv.codes[inv.codes.size() - M]);
+        slotById[vec.image_id] = static_cast<int>(vectors.size());
+        vectors.push_back(vec);
+        dead.push_back(0);
+    }
+
+    // Tira os apagados de 'vectors' e das listas, renumerando as posições.
+    void compact() {
+        std::vector<int> newPos(vectors.size(), -1);
+        size_t kept = 0;
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            if (dead[i]) continue;
+            newPos[i] = static_cast<int>(kept);
+            if (kept != i) vectors[kept] = vectors[i];
+            slotById[vectors[kept].image_id] = static_cast<int>(kept);
+            kept++;
+        }
+        vectors.resize(kept);
+        dead.assign(kept, 0);
+        deadCount = 0;
+        for (auto& inv : lists) {
+            size_t out = 0;
+            for (size_t i = 0; i < inv.ids.size(); ++i) {
+                int pos = newPos[inv.ids[i]];
+                if (pos < 0) continue;
+                inv.ids[out] = pos;
+                std::copy_n(&inv.codes[i * M], M, &inv.codes[out * M]);
+                out++;
+            }
+            inv.ids.resize(out);
+            inv.codes.resize(out * M);
+        }
+    }
+
+public:
+    /**
+     * @param nlist Número de listas invertidas (centróides grossos).
+     * @param nprobe Listas visitadas por consulta.
+     * @param m Número de subquantizadores (0 = automático).
+     * @param refine_factor Candidatos por vizinho pedido que passam pela reordenação exata.
+     */
+    IVFIndex(int nlist = 64, int nprobe = 8, int m = 0, int refine_factor = 4)
+        : nlist(std::max(1, nlist)), nprobe(std::max(1, nprobe)),
+          M(m > 0 ? std::min(m, DIM) : defaultM()),
+          refineFactor(std::max(1, refine_factor)), trained(false) {}
+
+    ~IVFIndex() override = default;
+
+    void setNprobe(int n) { nprobe = std::max(1, n); }
+    int getNprobe() const { return nprobe; }
+    int getNlist() const { return nlist; }
+    bool isTrained() const { return trained; }
+
+    /**
+     * @brief Treina os centróides grossos e os dicionários PQ a partir de uma amostra.
+     * @details Vetores que estavam pendentes são codificados logo após o treino.
+     */
+    void train(const std::vector<FeatureVector>& sample) {
+        if (sample.empty()) return;
+
+        // Amostra (no máximo MAX_TRAIN vetores, sorteados com semente fixa), normalizada.
+        std::vector<size_t> idx(sample.size());
+        std::iota(idx.begin(), idx.end(), 0);
+        if (idx.size() > MAX_TRAIN) {
+            std::mt19937 rng(7);
+            std::shuffle(idx.begin(), idx.end(), rng);
+            idx.resize(MAX_TRAIN);
+        }
+        size_t n = idx.size();
+        std::vector<float> data(n * DIM);
+        for (size_t i = 0; i < n; ++i) normalize(sample[idx[i]], &data[i * DIM]);
+
+        // Nível grosso.
+        coarse = kmeans(data, n, DIM, nlist);
+        nlist = static_cast<int>(coarse.size() / DIM);
+        lists.assign(nlist, InvertedList());
+
+        // Resíduos da amostra em relação aos seus centróides.
+        std::vector<float> residuals(n * DIM);
+        for (size_t i = 0; i < n; ++i) {
+            int c = nearestCentroid(&data[i * DIM], coarse, nlist, DIM);
+            for (int d = 0; d < DIM; ++d) {
+                residuals[i * DIM + d] = data[i * DIM + d] - coarse[static_cast<size_t>(c) * DIM + d];
+            }
+        }
+
+        // Um dicionário por subespaço; os subespaços dividem as DIM dimensões o mais igualmente possível.
+        subStart.assign(M + 1, 0);
+        for (int m = 0; m <= M; ++m) subStart[m] = m * DIM / M;
+        codebooks.assign(M, std::vector<float>());
+        std::vector<float> sub;
+        for (int m = 0; m < M; ++m) {
+            int len = subLen(m);
+            sub.assign(n * len, 0.0f);
+            for (size_t i = 0; i < n; ++i) {
+                std::copy_n(&residuals[i * DIM + subStart[m]], len, &sub[i * len]);
+            }
+            codebooks[m] = kmeans(sub, n, len, KSUB, 15, 100 + m);
+        }
+
+        trained = true;
+
+        // Vetores já inseridos (pendentes ou de um treino anterior) são recodificados; os apagados ficam de fora.
+        std::vector<FeatureVector> to_add;
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            if (!dead[i]) to_add.push_back(vectors[i]);
+        }
+        to_add.insert(to_add.end(), pending.begin(), pending.end());
+        vectors.clear();
+        dead.clear();
+        deadCount = 0;
+        pending.clear();
+        for (const auto& vec : to_add) addToList(vec);
+    }
+
+    void insert(const FeatureVector& vec) override {
+        if (!trained) {
+            slotById[vec.image_id] = static_cast<int>(pending.size());
+            pending.push_back(vec);
+            return;
+        }
+        addToList(vec);
+    }
+
+    bool remove(int image_id) override {
+        auto it = slotById.find(image_id);
+        if (it == slotById.end()) return false;
+        int slot = it->second;
+        slotById.erase(it);
+        if (!trained) {
+            // Antes do treino não há listas: o último pendente ocupa a posição liberada.
+            if (static_cast<size_t>(slot) + 1 != pending.size()) {
+                pending[slot] = pending.back();
+                slotById[pending[slot].image_id] = slot;
+            }
+            pending.pop_back();
+            return true;
+        }
+        dead[slot] = 1;
+        deadCount++;
+        if (compactionDue(deadCount, vectors.size())) compact();
+        return true;
+    }
+
+    QueryResult query(const FeatureVector& query_vec, int k) override {
+        QueryResult result;
+        if (k <= 0) return result;
+        if (!trained) {
+            if (pending.empty()) return result;
+            std::vector<FeatureVector> sample = pending;
+            train(sample);
+        }
+
+        float q[DIM];
+        normalize(query_vec, q);
+
+        // 1. Listas mais próximas da consulta.
+        std::vector<std::pair<float, int>> coarse_dist(nlist);
+        for (int c = 0; c < nlist; ++c) {
+            coarse_dist[c] = {squaredL2(q, &coarse[static_cast<size_t>(c) * DIM], DIM), c};
+        }
+        result.comparisons += nlist;
+        int probes = std::min(nprobe, nlist);
+        std::partial_sort(coarse_dist.begin(), coarse_dist.begin() + probes, coarse_dist.end());
+
+        // 2. Varredura dos códigos com tabelas de distância (ADC).
+        CandidateHeap<int> heap(static_cast<size_t>(k) * refineFactor);
+        std::vector<float> table(static_cast<size_t>(M) * KSUB);
+        float r[DIM];
+        for (int p = 0; p < probes; ++p) {
+            int list = coarse_dist[p].second;
+            const InvertedList& inv = lists[list];
+            if (inv.ids.empty()) continue;
+
+            for (int d = 0; d < DIM; ++d) r[d] = q[d] - coarse[static_cast<size_t>(list) * DIM + d];
+            for (int m = 0; m < M; ++m) {
+                int len = subLen(m);
+                int ksub = static_cast<int>(codebooks[m].size() / len);
+                for (int j = 0; j < ksub; ++j) {
+                    table[static_cast<size_t>(m) * KSUB + j] =
+                        squaredL2(r + subStart[m], &codebooks[m][static_cast<size_t>(j) * len], len);
+                }
+            }
+
+            const uint8_t* code = inv.codes.data();
+            for (size_t i = 0; i < inv.ids.size(); ++i, code += M) {
+                if (dead[inv.ids[i]]) {
+                    result.stats.skipDead();
+                    continue;
+                }
+                float dist = 0.0f;
+                for (int m = 0; m < M; ++m) dist += table[static_cast<size_t>(m) * KSUB + code[m]];
+                heap.push(-dist, inv.ids[i]); // o heap guarda as maiores pontuações
+            }
+            result.comparisons += static_cast<int>(inv.ids.size());
+        }
+
+        // 3. Reordenação exata dos melhores candidatos.
+        result.neighbors = rerankExact(query_vec, heap, k,
+                                       [this](int i) -> const FeatureVector& { return vectors[i]; },
+                                       result.comparisons);
+        return result;
+    }
+
+    // Os vetores originais são o payload; centróides, códigos PQ e listas são overhead.
+    MemoryUsage memoryUsage() const override {
+        MemoryUsage usage;
+        usage.addObject(sizeof(*this));
+        usage.addVector(coarse);
+        usage.addVector(subStart);
+        usage.addVector(codebooks);
+        for (const auto& cb : codebooks) usage.addVector(cb);
+        usage.addVector(lists);
+        for (const auto& inv : lists) {
+            usage.addVector(inv.ids);
+            usage.addVector(inv.codes);
+        }
+        usage.addVector(vectors);
+        usage.addVector(pending);
+        usage.addVector(dead);
+        usage.addMap(slotById);
+        usage.countVectors(vectors.size() - deadCount + pending.size());
+        return usage;
+    }
+};
+
+#endif // IVF_INDEX_HPP
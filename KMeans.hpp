@@ -0,0 +1,118 @@
+#ifndef KMEANS_HPP
+#define KMEANS_HPP
+
+#include <vector>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
+
+/**
+ * @brief Distância euclidiana ao quadrado entre dois vetores de 'dim' floats.
+ */
+inline float squaredL2(const float* a, const float* b, int dim) {
+    float s = 0.0f;
+    for (int d = 0; d < dim; ++d) {
+        float diff = a[d] - b[d];
+        s += diff * diff;
+    }
+    return s;
+}
+
+/**
+ * @brief Índice do centróide mais próximo de 'x' (distância euclidiana).
+ */
+inline int nearestCentroid(const float* x, const std::vector<float>& centroids, int k, int dim) {
+    int best = 0;
+    float best_dist = std::numeric_limits<float>::infinity();
+    for (int c = 0; c < k; ++c) {
+        float dist = squaredL2(x, &centroids[static_cast<size_t>(c) * dim], dim);
+        if (dist < best_dist) {
+            best_dist = dist;
+            best = c;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief k-means (algoritmo de Lloyd) com inicialização k-means++.
+ * @param data n vetores de 'dim' floats, armazenados em sequência.
+ * @param k Número de centróides (reduzido para n se houver menos pontos).
+ * @param iterations Número máximo de iterações de Lloyd.
+ * @param seed Semente, para que o treino seja reprodutível.
+ * @return k * dim floats com os centróides.
+ */
+inline std::vector<float> kmeans(const std::vector<float>& data, size_t n, int dim, int k,
+                                 int iterations = 20, unsigned seed = 42) {
+    std::vector<float> centroids;
+    if (n == 0 || k <= 0) return centroids;
+    k = static_cast<int>(std::min<size_t>(static_cast<size_t>(k), n));
+    centroids.resize(static_cast<size_t>(k) * dim);
+
+    std::mt19937 rng(seed);
+
+    // k-means++: cada novo centróide é sorteado com probabilidade proporcional
+    // à distância ao quadrado até o centróide mais próximo já escolhido.
+    std::vector<float> min_dist(n, std::numeric_limits<float>::infinity());
+    size_t first = std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+    std::copy_n(&data[first * dim], dim, &centroids[0]);
+    for (int c = 1; c < k; ++c) {
+        const float* prev = &centroids[static_cast<size_t>(c - 1) * dim];
+        double total = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            min_dist[i] = std::min(min_dist[i], squaredL2(&data[i * dim], prev, dim));
+            total += min_dist[i];
+        }
+        size_t chosen = std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+        if (total > 0.0) {
+            double r = std::uniform_real_distribution<double>(0.0, total)(rng);
+            for (size_t i = 0; i < n; ++i) {
+                r -= min_dist[i];
+                if (r <= 0.0) {
+                    chosen = i;
+                    break;
+                }
+            }
+        }
+        std::copy_n(&data[chosen * dim], dim, &centroids[static_cast<size_t>(c) * dim]);
+    }
+
+    // Iterações de Lloyd.
+    std::vector<int> assign(n, -1);
+    std::vector<double> sums(static_cast<size_t>(k) * dim);
+    std::vector<size_t> counts(k);
+    for (int it = 0; it < iterations; ++it) {
+        bool changed = false;
+        for (size_t i = 0; i < n; ++i) {
+            int c = nearestCentroid(&data[i * dim], centroids, k, dim);
+            if (c != assign[i]) {
+                assign[i] = c;
+                changed = true;
+            }
+        }
+        if (!changed) break;
+
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (size_t i = 0; i < n; ++i) {
+            counts[assign[i]]++;
+            for (int d = 0; d < dim; ++d) sums[static_cast<size_t>(assign[i]) * dim + d] += data[i * dim + d];
+        }
+        for (int c = 0; c < k; ++c) {
+            float* centroid = &centroids[static_cast<size_t>(c) * dim];
+            if (counts[c] == 0) {
+                // Cluster vazio: recomeça a partir de um ponto qualquer.
+                size_t i = std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+                std::copy_n(&data[i * dim], dim, centroid);
+                continue;
+            }
+            for (int d = 0; d < dim; ++d) {
+                centroid[d] = static_cast<float>(sums[static_cast<size_t>(c) * dim + d] / counts[c]);
+            }
+        }
+    }
+    return centroids;
+}
+
+#endif // KMEANS_HPP
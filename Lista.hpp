@@ -5,6 +5,7 @@
 #include <vector>
 #include <algorithm>
 #include <utility>
+#include <unordered_map>
 
 #include "DataStructure.hpp" // Inclui a interface que precisamos seguir
 
@@ -35,6 +36,27 @@ class Lista : public DataStructure
 private:
     No *primeiro; // nó cabeça
     No *ultimo;
+    std::unordered_map<int, No *> indice; // image_id -> nó, para remover pelo ID em O(1)
+
+    // Desliga o nó da lista e o libera (a lista é duplamente encadeada, então não há busca).
+    void removerNo(No *removido)
+    {
+        auto it = indice.find(removido->imagem.image_id);
+        if (it != indice.end() && it->second == removido)
+        {
+            indice.erase(it);
+        }
+        removido->ant->prox = removido->prox;
+        if (removido == ultimo)
+        {
+            ultimo = removido->ant;
+        }
+        else
+        {
+            removido->prox->ant = removido->ant;
+        }
+        delete removido;
+    }
 
 public:
     // Construtor
@@ -96,8 +118,35 @@ public:
         return result;
     }
 
+    bool remove(int image_id) override
+    {
+        auto it = indice.find(image_id);
+        if (it == indice.end())
+        {
+            return false;
+        }
+        removerNo(it->second);
+        return true;
+    }
+
+    MemoryUsage memoryUsage() const override
+    {
+        MemoryUsage usage;
+        usage.addObject(sizeof(*this));
+        usage.addMap(indice);
+        size_t n = 0;
+        for (No *atual = primeiro; atual != nullptr; atual = atual->prox)
+        {
+            usage.addBlock(atual, sizeof(No), sizeof(No)); // inclui o nó cabeça
+            if (atual != primeiro)
+                n++;
+        }
+        usage.countVectors(n);
+        return usage;
+    }
+
     // inserir no inicio da lista, configurando os ponteiros
-    void inserirInicio(FeatureVector i)
+    void inserirInicio(const FeatureVector &i)
     {
         No *novo = new No(i);
         novo->prox = primeiro->prox;
@@ -111,6 +160,7 @@ public:
             primeiro->prox->ant = novo;
         }
         primeiro->prox = novo;
+        indice[i.image_id] = novo;
     }
 
     // Inserir no fim da lista
@@ -127,6 +177,7 @@ public:
             novo->prox = nullptr;
             ultimo->prox = novo;
             ultimo = novo;
+            indice[i.image_id] = novo;
         }
     }
 
@@ -139,21 +190,7 @@ public:
         }
         else
         {
-            No *removido = primeiro->prox;
-            if (removido == ultimo)
-            {
-                // caso de apenas um elemento
-                primeiro->prox = nullptr;
-                ultimo = primeiro;
-                delete removido;
-            }
-            else
-            {
-                // caso genérico
-                primeiro->prox = removido->prox;
-                primeiro->prox->ant = primeiro;
-                delete removido;
-            }
+            removerNo(primeiro->prox);
         }
     }
 
@@ -163,20 +200,9 @@ public:
         {
             std::cout << "Lista vazia, não é possível realizar a remoção" << std::endl;
         }
-        else if (primeiro->prox == ultimo)
-        {
-            // tratando caso de lista com elemento único
-            delete ultimo;
-            ultimo = primeiro;
-            primeiro->prox = nullptr;
-        }
         else
         {
-            // caso genérico
-            No *removido = ultimo;
-            ultimo = removido->ant;
-            ultimo->prox = nullptr;
-            delete removido;
+            removerNo(ultimo);
         }
     }
 
@@ -0,0 +1,192 @@
+// Manifest.hpp
+
+#ifndef MANIFEST_HPP
+#define MANIFEST_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <filesystem>
+
+/**
+ * @brief Hash FNV-1a de 64 bits, usado para identificar o conteúdo de um arquivo.
+ * @param h Valor inicial; permite calcular o hash de um arquivo em blocos.
+ */
+inline uint64_t fnv1a64(const unsigned char* data, size_t len, uint64_t h = 1469598103934665603ULL) {
+    for (size_t i = 0; i < len; ++i) {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ * @struct ManifestEntry
+ * @brief Uma imagem conhecida pelo manifesto: metadados do arquivo, ID estável e características.
+ */
+struct ManifestEntry {
+    std::string path;              // caminho relativo à pasta raiz
+    uint64_t size = 0;             // tamanho do arquivo em bytes
+    int64_t mtime = 0;             // data de modificação (unidades do file_time_type)
+    uint64_t hash = 0;             // hash FNV-1a do conteúdo
+    int image_id = 0;
+    bool deleted = false;          // tombstone: o arquivo não existe mais
+    bool skipped = false;          // a extração falhou (ilegível, tons de cinza, acima do limite): sem características
+    std::vector<double> features;
+};
+
+/**
+ * @class Manifest
+ * @brief Registro persistente das imagens já processadas por create_dataset.
+ * * Permite a atualização incremental do dataset: arquivos cujo tamanho e data de
+ * modificação não mudaram são reaproveitados sem decodificação, novos arquivos
+ * recebem IDs a partir de 'next_id' e arquivos removidos viram tombstones, de modo
+ * que um ID nunca é reutilizado. Arquivos cuja extração falhou também ficam
+ * registrados (skipped), para não serem lidos de novo enquanto não mudarem; eles
+ * recebem um ID como os outros, mas não entram no dataset.
+ *
+ * Formato binário (little-endian), lido de uma vez só para carregar rápido:
+ *   "FVMF" | versão u32 | dim u32 | assinatura u32 | next_id i32 | n u64
+ *   n x { len u32 | path | size u64 | mtime i64 | hash u64 | id i32 | flags u8 | dim x f64 }
+ * flags: bit 0 = deleted, bit 1 = skipped (a versão 1 só tinha o bit 0).
+ */
+class Manifest {
+public:
+    static constexpr uint32_t VERSION = 2;
+
+    uint32_t dim = 3;          // número de características por imagem
+    uint32_t signature = 0;    // parâmetros da extração; se mudar, as características são recalculadas
+    int next_id = 1;
+    std::vector<ManifestEntry> entries;
+
+    // Carrega o manifesto; retorna false se o arquivo não existir ou for inválido.
+    bool load(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) return false;
+        std::vector<char> buf(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        if (!in.read(buf.data(), buf.size())) return false;
+
+        Reader r{buf.data(), buf.data() + buf.size()};
+        char magic[4];
+        uint32_t version = 0;
+        uint64_t count = 0;
+        if (!r.get(magic, 4) || std::memcmp(magic, "FVMF", 4) != 0) return false;
+        if (!r.pod(version) || version < 1 || version > VERSION) return false;
+        if (!r.pod(dim) || !r.pod(signature) || !r.pod(next_id) || !r.pod(count)) return false;
+
+        entries.clear();
+        entries.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            ManifestEntry e;
+            uint32_t len = 0;
+            uint8_t flags = 0;
+            if (!r.pod(len) || r.end - r.cur < static_cast<ptrdiff_t>(len)) return false;
+            e.path.assign(r.cur, len);
+            r.cur += len;
+            if (!r.pod(e.size) || !r.pod(e.mtime) || !r.pod(e.hash) || !r.pod(e.image_id) || !r.pod(flags)) return false;
+            e.deleted = (flags & 1) != 0;
+            e.skipped = (flags & 2) != 0;
+            e.features.resize(dim);
+            if (!r.get(e.features.data(), dim * sizeof(double))) return false;
+            entries.push_back(std::move(e));
+        }
+        rebuildIndex();
+        return true;
+    }
+
+    // Grava em um arquivo temporário e renomeia, para nunca deixar um manifesto pela metade.
+    bool save(const std::string& filename) const {
+        std::string tmp = filename + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) return false;
+            uint64_t count = entries.size();
+            out.write("FVMF", 4);
+            writePod(out, VERSION);
+            writePod(out, dim);
+            writePod(out, signature);
+            writePod(out, next_id);
+            writePod(out, count);
+            for (const auto& e : entries) {
+                uint32_t len = static_cast<uint32_t>(e.path.size());
+                uint8_t flags = (e.deleted ? 1 : 0) | (e.skipped ? 2 : 0);
+                writePod(out, len);
+                out.write(e.path.data(), len);
+                writePod(out, e.size);
+                writePod(out, e.mtime);
+                writePod(out, e.hash);
+                writePod(out, e.image_id);
+                writePod(out, flags);
+                out.write(reinterpret_cast<const char*>(e.features.data()), dim * sizeof(double));
+            }
+            if (!out) return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, filename, ec);
+        return !ec;
+    }
+
+    // Retorna a entrada associada ao caminho (viva ou tombstone), ou nullptr.
+    ManifestEntry* find(const std::string& path) {
+        auto it = by_path.find(path);
+        return it == by_path.end() ? nullptr : &entries[it->second];
+    }
+
+    // Acrescenta uma nova entrada com o próximo ID livre.
+    ManifestEntry& add(ManifestEntry e) {
+        e.image_id = next_id++;
+        by_path[e.path] = entries.size();
+        entries.push_back(std::move(e));
+        return entries.back();
+    }
+
+    // Atualiza o caminho de uma entrada (arquivo movido/renomeado).
+    void rename(ManifestEntry& e, const std::string& new_path) {
+        by_path.erase(e.path);
+        auto stale = by_path.find(new_path);
+        if (stale != by_path.end()) {
+            // O caminho novo já era de outra entrada: uma tombstone ou, numa troca de nomes ou num arquivo
+            // movido por cima de outro, uma entrada viva. Ela deixa de ser indexada por caminho; se for viva,
+            // ainda é achada pelo hash se o seu conteúdo aparecer em outro caminho, senão vira tombstone.
+            entries[stale->second].path.clear();
+        }
+        e.path = new_path;
+        by_path[new_path] = static_cast<size_t>(&e - entries.data());
+    }
+
+private:
+    std::unordered_map<std::string, size_t> by_path;
+
+    struct Reader {
+        const char* cur;
+        const char* end;
+        bool get(void* dst, size_t n) {
+            if (static_cast<size_t>(end - cur) < n) return false;
+            std::memcpy(dst, cur, n);
+            cur += n;
+            return true;
+        }
+        template <typename T>
+        bool pod(T& v) { return get(&v, sizeof(T)); }
+    };
+
+    template <typename T>
+    static void writePod(std::ofstream& out, const T& v) {
+        out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    void rebuildIndex() {
+        by_path.clear();
+        by_path.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (!entries[i].path.empty()) by_path[entries[i].path] = i;
+        }
+    }
+};
+
+#endif // MANIFEST_HPP
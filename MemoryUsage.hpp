@@ -0,0 +1,135 @@
+// MemoryUsage.hpp
+
+#ifndef MEMORY_USAGE_HPP
+#define MEMORY_USAGE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+#include <unordered_map>
+
+#include "Vector.hpp"
+
+#if defined(__GLIBC__)
+#include <malloc.h> // malloc_usable_size
+#endif
+
+/**
+ * @struct MemoryUsage
+ * @brief Memória ocupada por uma estrutura, separada em três partes (em bytes).
+ * - payload: a informação dos vetores indexados (image_id + DIM componentes), uma vez por vetor.
+ * - overhead: o restante do que a estrutura pediu ao alocador (ponteiros, nós,
+ *   cabeçalhos de std::vector, cópias extras dos vetores, preenchimento do FeatureVector).
+ * - slack: bytes reservados e não usados (capacidade sobrando nos std::vector e
+ *   arredondamento de cada bloco pelo malloc).
+ *
+ * Uso, dentro de memoryUsage(): registre cada bloco alocado com addBlock/addVector
+ * e, no fim, chame countVectors(n) para mover o payload de 'overhead' para 'payload'.
+ */
+struct MemoryUsage {
+    size_t payload = 0;
+    size_t overhead = 0;
+    size_t slack = 0;
+
+    size_t total() const { return payload + overhead + slack; }
+
+    // Bytes úteis de um vetor indexado.
+    static constexpr size_t VECTOR_PAYLOAD = sizeof(int) + FeatureVector::DIM * sizeof(FeatureVector::ScalarType);
+
+    // Tamanho real de um bloco do heap (o malloc arredonda o pedido).
+    static size_t blockSize(const void* p, size_t requested) {
+#if defined(__GLIBC__)
+        if (p) return malloc_usable_size(const_cast<void*>(p));
+#endif
+        (void)p;
+        return requested;
+    }
+
+    // Bloco do heap em 'p' com 'capacity' bytes pedidos, dos quais 'used' estão em uso.
+    void addBlock(const void* p, size_t used, size_t capacity) {
+        if (!p || capacity == 0) return;
+        overhead += used;
+        slack += blockSize(p, capacity) - used;
+    }
+
+    // Objeto guardado dentro de outro (ex.: a própria estrutura): sem bloco próprio no heap.
+    void addObject(size_t size) { overhead += size; }
+
+    // Área de dados de um std::vector (o cabeçalho já foi contado em quem o contém).
+    template <typename T>
+    void addVector(const std::vector<T>& v) {
+        addBlock(v.data(), v.size() * sizeof(T), v.capacity() * sizeof(T));
+    }
+
+    // std::unordered_map: o array de buckets e um nó por elemento (próximo + par). Os nós não
+    // são acessíveis, então o arredondamento do malloc é estimado a partir do tamanho pedido.
+    template <typename K, typename V, typename H, typename E, typename A>
+    void addMap(const std::unordered_map<K, V, H, E, A>& m) {
+        const size_t node = sizeof(void*) + sizeof(std::pair<const K, V>);
+        overhead += m.bucket_count() * sizeof(void*) + m.size() * node;
+#if defined(__GLIBC__)
+        // Bloco da glibc: pedido + 8 bytes de cabeçalho, múltiplo de 16, no mínimo 32.
+        size_t chunk = std::max<size_t>(32, (node + sizeof(size_t) + 15) & ~static_cast<size_t>(15));
+        slack += m.size() * (chunk - sizeof(size_t) - node);
+#endif
+    }
+
+    // Reclassifica como payload a informação de 'n' vetores já contados em 'overhead'.
+    void countVectors(size_t n) {
+        size_t bytes = n * VECTOR_PAYLOAD;
+        payload += bytes;
+        overhead -= bytes;
+    }
+};
+
+/**
+ * Contador de bytes vivos no heap, para conferir memoryUsage() contra o alocador.
+ * Um único arquivo do programa deve definir MEMORY_COUNTER_IMPLEMENTATION antes de
+ * incluir este cabeçalho (como o STB_IMAGE_IMPLEMENTATION): isso substitui o
+ * operator new/delete globais. Sem ele (ou fora da glibc), heapBytesInUse() é -1.
+ */
+namespace memcount {
+inline std::atomic<long long> live_bytes{0};
+inline std::atomic<bool> installed{false};
+}
+
+inline long long heapBytesInUse() {
+    return memcount::installed.load() ? memcount::live_bytes.load() : -1;
+}
+
+#endif // MEMORY_USAGE_HPP
+
+#if defined(MEMORY_COUNTER_IMPLEMENTATION) && defined(__GLIBC__) && !defined(MEMORY_COUNTER_IMPLEMENTED)
+#define MEMORY_COUNTER_IMPLEMENTED
+
+#include <cstdlib>
+#include <new>
+
+// new[], as versões nothrow e as sized delete da biblioteca padrão chamam estas três.
+void* operator new(std::size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    memcount::live_bytes.fetch_add(static_cast<long long>(malloc_usable_size(p)), std::memory_order_relaxed);
+    return p;
+}
+
+// noinline: se o free() for visto junto do new substituído, o GCC acusa falsamente -Wmismatched-new-delete.
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    if (!p) return;
+    memcount::live_bytes.fetch_sub(static_cast<long long>(malloc_usable_size(p)), std::memory_order_relaxed);
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+namespace memcount {
+struct Installer {
+    Installer() { installed.store(true); }
+};
+static Installer installer;
+}
+
+#endif // MEMORY_COUNTER_IMPLEMENTATION
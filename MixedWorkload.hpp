@@ -0,0 +1,111 @@
+#ifndef MIXED_WORKLOAD_HPP
+#define MIXED_WORKLOAD_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+
+#include "DataStructure.hpp"
+#include "Benchmark.hpp" // percentile
+
+/**
+ * @struct MixedReport
+ * @brief Resultado de uma rodada de inserções concorrentes com consultas.
+ */
+struct MixedReport {
+    double insert_seconds = 0.0;
+    double query_seconds = 0.0; // até a última leitora terminar
+    size_t queries = 0;
+    size_t invalid_results = 0;
+    std::vector<double> latencies_ms;
+};
+
+// Confere um resultado: no máximo k vizinhos, em ordem de distância, todos com IDs existentes.
+inline bool validResult(const FeatureVector& q, const QueryResult& r, int k, size_t total) {
+    if (r.neighbors.size() > static_cast<size_t>(k)) return false;
+    double prev = -1.0;
+    for (const auto& n : r.neighbors) {
+        if (n.image_id < 0 || static_cast<size_t>(n.image_id) >= total) return false;
+        double d = q.distanceTo(n);
+        if (d < prev - 1e-12) return false;
+        prev = d;
+    }
+    return true;
+}
+
+/**
+ * @brief Insere data[initial, end) com 'writers' threads enquanto 'readers' threads consultam.
+ * @details Os IDs de 'data' devem ser 0..N-1. As leitoras consultam só vetores
+ * já presentes (os 'initial' primeiros) e fazem, juntas, no máximo uma consulta
+ * por inserção: com um std::shared_mutex (que prioriza leitores na glibc),
+ * leitoras sem limite podem impedir as escritoras de entrar por tempo
+ * indefinido. Latências e erros ficam em variáveis locais de cada leitora e só
+ * são juntados ao final, para não criar contenção fora da estrutura medida.
+ */
+inline MixedReport runMixed(const std::function<void(const FeatureVector&)>& insert,
+                            const std::function<QueryResult(const FeatureVector&, int)>& query,
+                            const std::vector<FeatureVector>& data, size_t initial, int readers, int writers, int k) {
+    using Clock = std::chrono::steady_clock;
+    MixedReport report;
+    for (size_t i = 0; i < initial; ++i) insert(data[i]);
+
+    std::atomic<bool> done(false);
+    std::atomic<size_t> next(initial);
+    std::atomic<long long> budget(static_cast<long long>(data.size() - initial));
+    std::mutex merge_lock;
+
+    std::vector<std::thread> reader_threads;
+    for (int r = 0; r < readers; ++r) {
+        reader_threads.emplace_back([&, r]() {
+            std::vector<double> local_ms;
+            size_t local_invalid = 0;
+            size_t qi = static_cast<size_t>(r) * 7919;
+            auto reader_start = Clock::now();
+            while (!done.load(std::memory_order_relaxed) && budget.fetch_sub(1, std::memory_order_relaxed) > 0) {
+                const FeatureVector& q = data[(qi += 104729) % initial]; // só vetores já presentes
+                auto t0 = Clock::now();
+                QueryResult result = query(q, k);
+                auto t1 = Clock::now();
+                local_ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+                if (!validResult(q, result, k, data.size())) local_invalid++;
+            }
+            double seconds = std::chrono::duration<double>(Clock::now() - reader_start).count();
+            std::lock_guard<std::mutex> guard(merge_lock);
+            report.query_seconds = std::max(report.query_seconds, seconds);
+            report.queries += local_ms.size();
+            report.invalid_results += local_invalid;
+            report.latencies_ms.insert(report.latencies_ms.end(), local_ms.begin(), local_ms.end());
+        });
+    }
+
+    auto start = Clock::now();
+    std::vector<std::thread> writer_threads;
+    for (int w = 0; w < writers; ++w) {
+        writer_threads.emplace_back([&]() {
+            for (size_t i = next++; i < data.size(); i = next++) insert(data[i]);
+        });
+    }
+    for (auto& t : writer_threads) t.join();
+    report.insert_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    done = true;
+    for (auto& t : reader_threads) t.join();
+    return report;
+}
+
+inline void printMixedReport(const std::string& name, const MixedReport& r, size_t inserts) {
+    std::vector<double> sorted = r.latencies_ms;
+    std::sort(sorted.begin(), sorted.end());
+    std::cout << "   " << name << ": " << inserts / r.insert_seconds << " insercoes/s, "
+              << (r.query_seconds > 0.0 ? r.queries / r.query_seconds : 0.0) << " consultas/s durante a ingestao"
+              << " (p50 " << percentile(sorted, 50.0) << " ms, p99 " << percentile(sorted, 99.0)
+              << " ms, p99.9 " << percentile(sorted, 99.9) << " ms), resultados invalidos: " << r.invalid_results
+              << std::endl;
+}
+
+#endif // MIXED_WORKLOAD_HPP
@@ -0,0 +1,137 @@
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @struct PerfSample
+ * @brief Valores dos contadores de hardware de um trecho medido.
+ * @details Contadores indisponíveis ficam como NaN (não como zero, para não
+ * serem confundidos com uma medição real).
+ */
+struct PerfSample {
+    static constexpr int NUM_EVENTS = 4;
+    // Ordem: ciclos, instruções, falhas na LLC (último nível de cache), desvios mal previstos.
+    std::array<double, NUM_EVENTS> values = {NAN, NAN, NAN, NAN};
+
+    double cycles() const { return values[0]; }
+    double instructions() const { return values[1]; }
+    double llcMisses() const { return values[2]; }
+    double branchMisses() const { return values[3]; }
+
+    bool any() const {
+        for (double v : values) {
+            if (!std::isnan(v)) return true;
+        }
+        return false;
+    }
+
+    // Divide todos os contadores por 'n' (ex.: valores por consulta).
+    PerfSample per(double n) const {
+        PerfSample s = *this;
+        for (double& v : s.values) v = n > 0 ? v / n : NAN;
+        return s;
+    }
+};
+
+/**
+ * @class PerfCounters
+ * @brief Contadores de hardware (perf_event_open) do processo, só em modo usuário.
+ * * Cada evento é aberto separadamente: se a CPU, a máquina virtual ou a
+ * configuração do kernel (perf_event_paranoid) não oferecer um deles, só esse
+ * fica indisponível. Fora do Linux, ou sem nenhum contador, available() é
+ * false e as medições devolvem NaN; o programa continua normalmente.
+ *
+ * Se o kernel multiplexar os contadores, os valores são extrapolados pela
+ * fração do tempo em que cada um esteve ativo.
+ *
+ * Uso:
+ *   PerfCounters pc;
+ *   pc.start();
+ *   ... trecho medido ...
+ *   PerfSample s = pc.stop();
+ */
+class PerfCounters {
+public:
+    PerfCounters() {
+        fds.fill(-1);
+#if defined(__linux__)
+        const uint64_t configs[PerfSample::NUM_EVENTS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int i = 0; i < PerfSample::NUM_EVENTS; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.inherit = 1; // inclui threads criadas durante a medição (ex.: HNSW::insertParallel)
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    ~PerfCounters() {
+#if defined(__linux__)
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const {
+        for (int fd : fds) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+
+    void start() {
+#if defined(__linux__)
+        for (int fd : fds) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    PerfSample stop() {
+        PerfSample s;
+#if defined(__linux__)
+        for (int fd : fds) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+        for (int i = 0; i < PerfSample::NUM_EVENTS; ++i) {
+            if (fds[i] < 0) continue;
+            uint64_t data[3] = {0, 0, 0}; // valor, tempo habilitado, tempo em execução
+            if (read(fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) continue;
+            s.values[i] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+        }
+#endif
+        return s;
+    }
+
+private:
+    std::array<int, PerfSample::NUM_EVENTS> fds;
+};
+
+#endif // PERF_COUNTERS_HPP
@@ -0,0 +1,209 @@
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <algorithm>
+#include <type_traits>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "DataStructure.hpp"
+
+/**
+ * Protocolo binário entre processos da mesma máquina (shards, servidor de consultas).
+ *
+ * Cada mensagem é um quadro: [uint32 tamanho do conteúdo][uint8 operação][conteúdo].
+ * Os números vão na ordem de bytes nativa (os dois lados rodam na mesma máquina)
+ * e um vetor é o image_id (int32) seguido dos DIM componentes no ScalarType do
+ * build; os dois lados precisam ser compilados com o mesmo FEATURE_DIM e
+ * FEATURE_SCALAR. Toda requisição recebe exatamente uma resposta, com a mesma
+ * operação, na ordem em que chegou.
+ */
+enum class WireOp : uint8_t {
+    Insert = 1,   // vetor                      -> (vazio)
+    Remove = 2,   // int32 image_id             -> uint8 removido
+    Query = 3,    // int32 k, vetor             -> int32 comparações, uint32 n, n vetores
+    Stats = 4,    // (vazio)                    -> uint64 payload, overhead, folga (MemoryUsage)
+    Shutdown = 5, // (vazio)                    -> (vazio); o outro lado encerra
+    Ping = 6,     // (vazio)                    -> (vazio); espera o outro lado ficar pronto
+    Counters = 7, // uint8 zerar                -> ServerCounters (QueryServer.hpp)
+    Error = 255   // resposta a uma requisição inválida
+};
+
+// Bytes de um vetor no protocolo.
+constexpr size_t WIRE_VECTOR_BYTES = sizeof(int32_t) + FeatureVector::DIM * sizeof(FeatureVector::ScalarType);
+// Limite do conteúdo de um quadro: protege contra um tamanho corrompido.
+constexpr uint32_t MAX_FRAME_BYTES = 64u << 20;
+// Maior k aceito numa consulta (a resposta precisa caber num quadro).
+constexpr int32_t MAX_WIRE_K = 65536;
+
+/**
+ * @class WireBuffer
+ * @brief Conteúdo de um quadro: escrita sequencial (put*) e leitura sequencial (get*).
+ * @details Os get* devolvem false se o conteúdo acabar antes do esperado.
+ */
+class WireBuffer {
+public:
+    std::vector<char> bytes;
+    size_t pos = 0;
+
+    void clear() {
+        bytes.clear();
+        pos = 0;
+    }
+
+    template <typename T>
+    void put(T value) {
+        static_assert(std::is_trivially_copyable<T>::value, "tipo sem representação binária direta");
+        size_t at = bytes.size();
+        bytes.resize(at + sizeof(T));
+        std::memcpy(&bytes[at], &value, sizeof(T));
+    }
+
+    void putVector(const FeatureVector& vec) {
+        put<int32_t>(vec.image_id);
+        size_t at = bytes.size();
+        bytes.resize(at + FeatureVector::DIM * sizeof(FeatureVector::ScalarType));
+        for (int d = 0; d < FeatureVector::DIM; ++d) {
+            FeatureVector::ScalarType x = vec[d];
+            std::memcpy(&bytes[at + d * sizeof(x)], &x, sizeof(x));
+        }
+    }
+
+    template <typename T>
+    bool get(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "tipo sem representação binária direta");
+        if (bytes.size() - pos < sizeof(T)) return false;
+        std::memcpy(&value, &bytes[pos], sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool getVector(FeatureVector& vec) {
+        if (bytes.size() - pos < WIRE_VECTOR_BYTES) return false;
+        int32_t id;
+        get(id);
+        vec.image_id = id;
+        for (int d = 0; d < FeatureVector::DIM; ++d) {
+            FeatureVector::ScalarType x;
+            get(x);
+            vec[d] = x;
+        }
+        return true;
+    }
+};
+
+// Escreve todos os bytes (repete em escritas parciais). MSG_NOSIGNAL: o outro lado fechado vira erro, não SIGPIPE.
+inline bool writeAll(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Lê exatamente 'size' bytes; false se a conexão fechar antes.
+inline bool readAll(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = ::recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+inline bool sendFrame(int fd, WireOp op, const WireBuffer& body) {
+    char header[5];
+    uint32_t size = static_cast<uint32_t>(body.bytes.size());
+    std::memcpy(header, &size, sizeof(size));
+    header[4] = static_cast<char>(op);
+    return writeAll(fd, header, sizeof(header)) && (size == 0 || writeAll(fd, body.bytes.data(), size));
+}
+
+// Recebe um quadro; o conteúdo fica em 'body' (pos = 0).
+inline bool recvFrame(int fd, WireOp& op, WireBuffer& body) {
+    char header[5];
+    if (!readAll(fd, header, sizeof(header))) return false;
+    uint32_t size;
+    std::memcpy(&size, header, sizeof(size));
+    if (size > MAX_FRAME_BYTES) return false;
+    op = static_cast<WireOp>(static_cast<uint8_t>(header[4]));
+    body.bytes.resize(size);
+    body.pos = 0;
+    return size == 0 || readAll(fd, body.bytes.data(), size);
+}
+
+// Resposta de uma consulta: comparações, número de vizinhos e os (no máximo 'k') primeiros vizinhos.
+inline void putQueryReply(WireBuffer& reply, const QueryResult& r, size_t k) {
+    size_t n = std::min(k, r.neighbors.size());
+    reply.put<int32_t>(r.comparisons);
+    reply.put<uint32_t>(static_cast<uint32_t>(n));
+    for (size_t i = 0; i < n; ++i) reply.putVector(r.neighbors[i]);
+}
+
+// Lê a resposta de uma consulta; false se o conteúdo estiver incompleto.
+inline bool getQueryReply(WireBuffer& reply, QueryResult& r) {
+    int32_t comparisons;
+    uint32_t n;
+    if (!reply.get(comparisons) || !reply.get(n)) return false;
+    if (n > static_cast<uint32_t>(MAX_WIRE_K)) return false;
+    r.comparisons = comparisons;
+    r.neighbors.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (!reply.getVector(r.neighbors[i])) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Executa sobre 'ds' uma requisição de dados (Insert, Remove, Query, Stats ou Ping).
+ * @param reply Recebe o conteúdo da resposta (mesma operação).
+ * @return false se a operação não for de dados ou o conteúdo for inválido; a resposta deve ser Error.
+ */
+inline bool applyRequest(DataStructure& ds, WireOp op, WireBuffer& request, WireBuffer& reply) {
+    switch (op) {
+    case WireOp::Insert: {
+        FeatureVector vec;
+        if (!request.getVector(vec)) return false;
+        ds.insert(vec);
+        return true;
+    }
+    case WireOp::Remove: {
+        int32_t id;
+        if (!request.get(id)) return false;
+        reply.put<uint8_t>(ds.remove(id) ? 1 : 0);
+        return true;
+    }
+    case WireOp::Query: {
+        int32_t k;
+        FeatureVector q;
+        if (!request.get(k) || !request.getVector(q) || k < 0 || k > MAX_WIRE_K) return false;
+        putQueryReply(reply, ds.query(q, k), static_cast<size_t>(k));
+        return true;
+    }
+    case WireOp::Stats: {
+        MemoryUsage usage = ds.memoryUsage();
+        reply.put<uint64_t>(usage.payload);
+        reply.put<uint64_t>(usage.overhead);
+        reply.put<uint64_t>(usage.slack);
+        return true;
+    }
+    case WireOp::Ping:
+        return true;
+    default:
+        return false;
+    }
+}
+
+#endif // PROTOCOL_HPP
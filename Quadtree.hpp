@@ -8,10 +8,14 @@
 #include <queue>
 #include <limits>
 #include <cmath>
+#include <utility>
+#include <unordered_map>
 
 #include "DataStructure.hpp"
+#include "Quantization.hpp"
+#include "SpaceFillingCurve.hpp"
 
-// Região 2D delimitada por (R,G)
+// Região 2D delimitada por (R,G): os dois primeiros componentes do vetor
 struct AABB2D {
     double minR, maxR;
     double minG, maxG;
@@ -44,11 +48,18 @@ struct AABB2D {
 class QuadNode {
 public:
     static constexpr int CAPACITY = 8;
+    // Profundidade máxima: abaixo dela as folhas não se dividem mais. Sem esse limite,
+    // mais de CAPACITY pontos com o mesmo (R,G) causariam subdivisão infinita.
+    static constexpr int MAX_DEPTH = 32;
 
     AABB2D bbox;
     std::vector<FeatureVector> pts;
+    std::vector<uint8_t> codes; // códigos de 8 bits de 'pts' (apenas no modo quantizado)
     std::array<std::unique_ptr<QuadNode>, 4> child;
     bool isLeaf;
+    // Árvore compactada (Quadtree::pack): os pontos da folha são store[first, first + count) e 'pts' fica vazio.
+    uint32_t first = 0;
+    uint32_t count = 0;
 
     QuadNode(const AABB2D& box) : bbox(box), isLeaf(true) {}
 
@@ -78,102 +89,506 @@ class Quadtree : public DataStructure {
 private:
     std::unique_ptr<QuadNode> root;
 
+    // Modo quantizado: as folhas guardam também os códigos de 8 bits dos pontos,
+    // a varredura das folhas lê só os códigos e os melhores candidatos são reordenados.
+    bool quantized;
+    ScalarQuantizer quantizer;
+    int rerankFactor;
+
+    // image_id -> (R,G) do vetor: leva a remoção direto à folha.
+    std::unordered_map<int, std::pair<double, double>> rgById;
+
+    // Árvore compactada: os pontos de todas as folhas, folha após folha, na ordem de pack().
+    bool packed = false;
+    std::vector<FeatureVector> store;
+    std::vector<uint8_t> storeCodes; // códigos de 'store' (apenas no modo quantizado)
+
+    // Consultas percorridas juntas em queryBatch(). O padrão é 1 (uma de cada vez): com a poda
+    // atual cada busca é uma descida curta da raiz à folha, e intercalar não a acelerou (bench_prefetch).
+    int interleave = 1;
+
+    struct PQNode {
+        double bound;
+        QuadNode* node;
+        bool operator>(const PQNode& other) const { return bound > other.bound; }
+    };
+    using Fringe = std::priority_queue<PQNode, std::vector<PQNode>, std::greater<PQNode>>;
+
+    /**
+     * @struct Search
+     * @brief Estado de uma busca best-first: a fila de nós e os k melhores até agora.
+     * @details next() tira da fila o próximo nó que a caixa (R,G) não poda e
+     * process() o varre ou enfileira os filhos. Separadas, as duas etapas deixam
+     * queryBatch() intercalar várias buscas. A busca não é exata: a caixa mede a
+     * distância euclidiana em (R,G) e os vizinhos são ordenados pela do cosseno,
+     * então a poda pode descartar vizinhos verdadeiros.
+     */
+    struct Search {
+        using Pair = std::pair<double, FeatureVector>;
+        struct MaxFirst {
+            bool operator()(const Pair& a, const Pair& b) const { return a.first < b.first; }
+        };
+
+        const Quadtree& tree;
+        const FeatureVector& query_vec;
+        size_t k;
+        std::priority_queue<Pair, std::vector<Pair>, MaxFirst> best;
+        Fringe fringe;
+        double worstBest = std::numeric_limits<double>::infinity();
+        bool done = false;
+
+        Search(const Quadtree& t, const FeatureVector& q, int k) : tree(t), query_vec(q), k(static_cast<size_t>(k)) {}
+
+        // Próximo nó a processar, ou nullptr quando a caixa poda o resto da fila.
+        QuadNode* next(QueryResult& result) {
+            if (fringe.empty()) {
+                done = true;
+                return nullptr;
+            }
+            PQNode cur = fringe.top(); fringe.pop();
+            if (best.size() == k && cur.bound >= worstBest) {
+                result.stats.prune(fringe.size() + 1); // o restante da fila também fica de fora
+                done = true;
+                return nullptr;
+            }
+            return cur.node;
+        }
+
+        void process(QuadNode* node, QueryResult& result) {
+            result.stats.touch(sizeof(QuadNode));
+            if (node->isLeaf) {
+                const FeatureVector* pts = tree.leafPoints(node);
+                size_t n = tree.leafSize(node);
+                result.stats.scanLeaf();
+                result.stats.touch(n * sizeof(FeatureVector));
+                for (size_t i = 0; i < n; ++i) {
+                    const FeatureVector& p = pts[i];
+                    double dist = query_vec.distanceTo(p);
+                    result.comparisons++;
+                    if (best.size() < k) {
+                        best.emplace(dist, p);
+                        if (best.size() == k) worstBest = best.top().first;
+                    } else if (dist < best.top().first) {
+                        best.pop();
+                        best.emplace(dist, p);
+                        worstBest = best.top().first;
+                    }
+                }
+            } else {
+                result.stats.expandNode();
+                for (int q = 0; q < 4; ++q) {
+                    QuadNode* ch = node->child[q].get();
+                    if (!ch) continue;
+                    double b = ch->bbox.minDistRG(query_vec[0], query_vec[1]);
+                    if (best.size() == k && b >= worstBest) {
+                        result.stats.prune();
+                        continue;
+                    }
+                    fringe.push(PQNode{ b, ch });
+                }
+                result.stats.fringeSize(fringe.size());
+            }
+        }
+
+        // Os k melhores, do mais próximo para o mais distante.
+        std::vector<FeatureVector> neighbors() {
+            std::vector<Pair> tmp;
+            tmp.reserve(best.size());
+            while (!best.empty()) { tmp.push_back(best.top()); best.pop(); }
+            std::sort(tmp.begin(), tmp.end(),
+                      [](const Pair& a, const Pair& b){ return a.first < b.first; });
+
+            std::vector<FeatureVector> out;
+            out.reserve(tmp.size());
+            for (auto& pr : tmp) out.push_back(pr.second);
+            return out;
+        }
+    };
+
+    // Pede todas as linhas de cache de um trecho (um QuadNode ocupa duas: a caixa fica numa, os filhos noutra).
+    static void prefetchBytes(const void* addr, size_t bytes) {
+        const char* p = static_cast<const char*>(addr);
+        for (size_t off = 0; off < bytes; off += 64) prefetchRead(p + off);
+        if (bytes > 0) prefetchRead(p + bytes - 1);
+    }
+
+    // Pontos de uma folha: o seu trecho de 'store' (árvore compactada) ou o seu próprio vetor.
+    const FeatureVector* leafPoints(const QuadNode* node) const {
+        return packed ? store.data() + node->first : node->pts.data();
+    }
+    size_t leafSize(const QuadNode* node) const { return packed ? node->count : node->pts.size(); }
+    const uint8_t* leafCodes(const QuadNode* node) const {
+        return packed ? storeCodes.data() + static_cast<size_t>(node->first) * ScalarQuantizer::CODE_DIM
+                      : node->codes.data();
+    }
+
+    // Pede as linhas que process() vai ler do nó: as caixas dos filhos, ou os pontos da folha.
+    void prefetchContents(const QuadNode* node) const {
+        if (node->isLeaf) {
+            prefetchBytes(leafPoints(node), leafSize(node) * sizeof(FeatureVector));
+        } else {
+            for (const auto& ch : node->child) {
+                if (ch) prefetchRead(&ch->bbox);
+            }
+        }
+    }
+
 public:
     Quadtree(double rMin = 0.0, double rMax = 255.0,
-             double gMin = 0.0, double gMax = 255.0) {
+             double gMin = 0.0, double gMax = 255.0)
+        : quantized(false), rerankFactor(4) {
         root = std::make_unique<QuadNode>(AABB2D(rMin, rMax, gMin, gMax));
     }
 
     ~Quadtree() override = default;
 
+    /**
+     * @brief Ativa o modo quantizado; as folhas existentes são codificadas.
+     * @param rerank_factor Quantos candidatos por vizinho pedido passam pela reordenação exata.
+     */
+    void enableQuantization(const ScalarQuantizer& q, int rerank_factor = 4) {
+        unpack();
+        quantized = true;
+        quantizer = q;
+        rerankFactor = std::max(1, rerank_factor);
+        encodeRec(root.get());
+    }
+
     void insert(const FeatureVector& vec) override {
-        ensureRootContains(vec.r, vec.g);
-        insertRec(root.get(), vec);
+        unpack();
+        ensureRootContains(vec[0], vec[1]);
+        insertRec(root.get(), vec, 0);
+        rgById[vec.image_id] = {vec[0], vec[1]};
+    }
+
+    // Remove na folha do (R,G) do vetor, sem tombstones; irmãs que voltam a caber
+    // numa folha só são juntadas no caminho de volta, então a árvore não acumula nós vazios.
+    bool remove(int image_id) override {
+        auto it = rgById.find(image_id);
+        if (it == rgById.end()) return false;
+        unpack();
+        bool removed = removeRec(root.get(), image_id, it->second.first, it->second.second);
+        rgById.erase(it);
+        return removed;
     }
 
     // Busca k-vizinhos mais próximos
     QueryResult query(const FeatureVector& query_vec, int k) override {
         QueryResult result;
         if (k <= 0) return result;
+        if (quantized) return queryQuantized(query_vec, k);
 
-        using Pair = std::pair<double, FeatureVector>;
-        auto cmpMaxHeap = [](const Pair& a, const Pair& b){ return a.first < b.first; };
-        std::priority_queue<Pair, std::vector<Pair>, decltype(cmpMaxHeap)> best(cmpMaxHeap);
+        Search s(*this, query_vec, k);
+        s.fringe.push(PQNode{ root->bbox.minDistRG(query_vec[0], query_vec[1]), root.get() });
+        result.stats.fringeSize(1);
+
+        QuadNode* node;
+        while ((node = s.next(result)) != nullptr) s.process(node, result);
+
+        result.neighbors = s.neighbors();
+        return result;
+    }
+
+    void setInterleave(int width) { interleave = std::max(1, width); }
+    int getInterleave() const { return interleave; }
+
+    /**
+     * @brief Consultas em lote com as buscas de 'interleave' consultas intercaladas.
+     * @details A busca best-first de query() lê um nó, e só depois sabe onde
+     * estão os filhos ou os pontos que vai ler em seguida. Aqui cada nó passa
+     * por duas rodadas: na primeira a consulta o tira da fila e pede (prefetch)
+     * os filhos ou os pontos da folha; na segunda os processa e pede o próximo
+     * nó da sua fila. Entre as duas rodam as etapas das outras consultas do
+     * grupo, que cobrem o tempo das leituras. Cada consulta faz exatamente os
+     * passos de query(), então resultados e estatísticas são os mesmos. No modo
+     * quantizado e com interleave = 1 é o laço sobre query().
+     */
+    std::vector<QueryResult> queryBatch(const std::vector<FeatureVector>& queries, int k) override {
+        if (interleave <= 1 || quantized || k <= 0) return DataStructure::queryBatch(queries, k);
+        std::vector<QueryResult> results(queries.size());
+
+        for (size_t base = 0; base < queries.size(); base += interleave) {
+            size_t n = std::min(static_cast<size_t>(interleave), queries.size() - base);
+            std::vector<Search> group;
+            std::vector<QuadNode*> opened(n, nullptr); // nó tirado da fila e ainda não processado
+            group.reserve(n);
+            for (size_t i = 0; i < n; ++i) {
+                const FeatureVector& q = queries[base + i];
+                group.emplace_back(*this, q, k);
+                group[i].fringe.push(PQNode{ root->bbox.minDistRG(q[0], q[1]), root.get() });
+                results[base + i].stats.fringeSize(1);
+            }
+
+            size_t active = n;
+            while (active > 0) {
+                for (size_t i = 0; i < n; ++i) {
+                    Search& s = group[i];
+                    QueryResult& result = results[base + i];
+                    if (s.done) continue;
+                    if (opened[i]) {
+                        s.process(opened[i], result);
+                        opened[i] = nullptr;
+                        if (!s.fringe.empty()) prefetchBytes(s.fringe.top().node, sizeof(QuadNode));
+                        continue;
+                    }
+                    QuadNode* node = s.next(result);
+                    if (!node) {
+                        active--;
+                        continue;
+                    }
+                    prefetchContents(node);
+                    opened[i] = node;
+                }
+            }
+            for (size_t i = 0; i < n; ++i) results[base + i].neighbors = group[i].neighbors();
+        }
+        return results;
+    }
 
-        struct PQNode {
-            double bound;
-            QuadNode* node;
-            bool operator>(const PQNode& other) const { return bound > other.bound; }
+    MemoryUsage memoryUsage() const override {
+        MemoryUsage usage;
+        usage.addObject(sizeof(*this));
+        usage.addMap(rgById);
+        usage.addVector(store);
+        usage.addVector(storeCodes);
+        usage.countVectors(nodeUsage(root.get(), usage));
+        return usage;
+    }
+
+    /**
+     * @brief Compacta a árvore: os pontos de todas as folhas passam para um único vetor contíguo.
+     * @details Cada folha passa a apontar para o seu trecho [first, first + count)
+     * do vetor. Com uma curva (Morton ou Hilbert), os pontos de cada folha ficam
+     * na ordem da curva sobre as cores normalizadas, e as folhas ficam na ordem
+     * do seu primeiro ponto na curva. Assim, folhas vizinhas no espaço ficam
+     * vizinhas na memória, e uma consulta que varre várias folhas lê menos
+     * linhas de cache e páginas. Sem curva, as folhas ficam na ordem da árvore
+     * (NW, NE, SW, SE em profundidade). Use depois de uma carga: a próxima
+     * inserção ou remoção devolve os pontos às folhas (unpack).
+     */
+    void pack(CurveOrder order) {
+        unpack();
+        std::vector<QuadNode*> leaves;
+        collectLeaves(root.get(), leaves);
+
+        struct Packing {
+            QuadNode* leaf;
+            uint64_t key;
+            std::vector<size_t> perm;
         };
-        std::priority_queue<PQNode, std::vector<PQNode>, std::greater<PQNode>> fringe;
+        std::vector<Packing> order_of(leaves.size());
+        size_t total = 0;
+        for (size_t i = 0; i < leaves.size(); ++i) {
+            QuadNode* leaf = leaves[i];
+            order_of[i].leaf = leaf;
+            order_of[i].perm = curvePermutation(leaf->pts, order);
+            order_of[i].key = leaf->pts.empty() ? 0 : curveKey(leaf->pts[order_of[i].perm[0]], order);
+            total += leaf->pts.size();
+        }
+        if (order != CurveOrder::None) {
+            std::stable_sort(order_of.begin(), order_of.end(),
+                             [](const Packing& a, const Packing& b) { return a.key < b.key; });
+        }
 
-        fringe.push(PQNode{ root->bbox.minDistRG(query_vec.r, query_vec.g), root.get() });
+        const size_t CD = ScalarQuantizer::CODE_DIM;
+        store.clear();
+        store.reserve(total);
+        storeCodes.clear();
+        if (quantized) storeCodes.reserve(total * CD);
+        for (Packing& p : order_of) {
+            QuadNode* leaf = p.leaf;
+            leaf->first = static_cast<uint32_t>(store.size());
+            leaf->count = static_cast<uint32_t>(leaf->pts.size());
+            for (size_t i : p.perm) {
+                store.push_back(leaf->pts[i]);
+                if (quantized) storeCodes.insert(storeCodes.end(), &leaf->codes[i * CD], &leaf->codes[i * CD] + CD);
+            }
+            std::vector<FeatureVector>().swap(leaf->pts);
+            std::vector<uint8_t>().swap(leaf->codes);
+        }
+        packed = true;
+    }
+
+    // Devolve os pontos de 'store' às folhas (a árvore volta a aceitar inserções e remoções).
+    void unpack() {
+        if (!packed) return;
+        std::vector<QuadNode*> leaves;
+        collectLeaves(root.get(), leaves);
+        const size_t CD = ScalarQuantizer::CODE_DIM;
+        for (QuadNode* leaf : leaves) {
+            leaf->pts.assign(store.begin() + leaf->first, store.begin() + leaf->first + leaf->count);
+            if (quantized) {
+                leaf->codes.assign(storeCodes.begin() + leaf->first * CD,
+                                   storeCodes.begin() + (leaf->first + leaf->count) * CD);
+            }
+            leaf->first = leaf->count = 0;
+        }
+        std::vector<FeatureVector>().swap(store);
+        std::vector<uint8_t>().swap(storeCodes);
+        packed = false;
+    }
+
+    bool isPacked() const { return packed; }
+
+private:
+    static void collectLeaves(QuadNode* node, std::vector<QuadNode*>& out) {
+        if (!node) return;
+        if (node->isLeaf) {
+            out.push_back(node);
+            return;
+        }
+        for (auto& ch : node->child) collectLeaves(ch.get(), out);
+    }
+
+    // Soma os nós da subárvore em 'usage' e devolve quantos pontos ela guarda.
+    static size_t nodeUsage(const QuadNode* node, MemoryUsage& usage) {
+        if (!node) return 0;
+        usage.addBlock(node, sizeof(QuadNode), sizeof(QuadNode));
+        usage.addVector(node->pts);
+        usage.addVector(node->codes);
+        size_t n = node->pts.size() + node->count;
+        for (const auto& ch : node->child) n += nodeUsage(ch.get(), usage);
+        return n;
+    }
+
+    // Mesma busca best-first, mas as folhas são pontuadas pelos códigos de 8 bits.
+    // O corte usa a distância aproximada do pior dos k * rerankFactor candidatos.
+    QueryResult queryQuantized(const FeatureVector& query_vec, int k) {
+        QueryResult result;
+        QuantizedQuery qq(quantizer, query_vec);
+        CandidateHeap<const FeatureVector*> heap(static_cast<size_t>(k) * rerankFactor);
+        std::vector<float> scores(QuadNode::CAPACITY + 1);
+
+        Fringe fringe;
+        fringe.push(PQNode{ root->bbox.minDistRG(query_vec[0], query_vec[1]), root.get() });
+        result.stats.fringeSize(1);
 
         double worstBest = std::numeric_limits<double>::infinity();
 
         while (!fringe.empty()) {
             PQNode cur = fringe.top(); fringe.pop();
-
-            if (best.size() == static_cast<size_t>(k) && cur.bound >= worstBest) break;
+            if (heap.full() && cur.bound >= worstBest) {
+                result.stats.prune(fringe.size() + 1);
+                break;
+            }
 
             QuadNode* node = cur.node;
+            result.stats.touch(sizeof(QuadNode));
             if (node->isLeaf) {
-                for (const auto& p : node->pts) {
-                    double dist = query_vec.distanceTo(p);
-                    result.comparisons++;
-                    if (best.size() < static_cast<size_t>(k)) {
-                        best.emplace(dist, p);
-                        if (best.size() == static_cast<size_t>(k)) worstBest = best.top().first;
-                    } else if (dist < best.top().first) {
-                        best.pop();
-                        best.emplace(dist, p);
-                        worstBest = best.top().first;
-                    }
-                }
+                size_t n = leafSize(node);
+                const FeatureVector* pts = leafPoints(node);
+                result.stats.scanLeaf();
+                result.stats.touch(n * ScalarQuantizer::CODE_DIM); // só os códigos; a reordenação lê os vetores depois
+                // Folhas no limite de profundidade podem passar de CAPACITY pontos.
+                if (n > scores.size()) scores.resize(n);
+                scoreCodes(qq, leafCodes(node), n, scores.data());
+                for (size_t i = 0; i < n; ++i) heap.push(scores[i], &pts[i]);
+                result.comparisons += static_cast<int>(n);
+                if (heap.full()) worstBest = qq.approxDistance(heap.worstScore());
             } else {
+                result.stats.expandNode();
                 for (int q = 0; q < 4; ++q) {
                     QuadNode* ch = node->child[q].get();
                     if (!ch) continue;
-                    double b = ch->bbox.minDistRG(query_vec.r, query_vec.g);
-                    if (best.size() == static_cast<size_t>(k) && b >= worstBest) continue;
+                    double b = ch->bbox.minDistRG(query_vec[0], query_vec[1]);
+                    if (heap.full() && b >= worstBest) {
+                        result.stats.prune();
+                        continue;
+                    }
                     fringe.push(PQNode{ b, ch });
                 }
+                result.stats.fringeSize(fringe.size());
             }
         }
 
-        std::vector<Pair> tmp;
-        tmp.reserve(best.size());
-        while (!best.empty()) { tmp.push_back(best.top()); best.pop(); }
-        std::sort(tmp.begin(), tmp.end(),
-                  [](const Pair& a, const Pair& b){ return a.first < b.first; });
-
-        result.neighbors.reserve(tmp.size());
-        for (auto& pr : tmp) result.neighbors.push_back(pr.second);
+        result.stats.touch(heap.size() * sizeof(FeatureVector));
+        result.neighbors = rerankExact(query_vec, heap, k,
+                                       [](const FeatureVector* p) -> const FeatureVector& { return *p; },
+                                       result.comparisons);
         return result;
     }
 
-private:
+    // Codifica os pontos de todas as folhas (usado ao ativar o modo quantizado).
+    void encodeRec(QuadNode* node) {
+        if (!node) return;
+        if (node->isLeaf) {
+            node->codes.assign(node->pts.size() * ScalarQuantizer::CODE_DIM, 0);
+            for (size_t i = 0; i < node->pts.size(); ++i) {
+                quantizer.encode(node->pts[i], &node->codes[i * ScalarQuantizer::CODE_DIM]);
+            }
+            return;
+        }
+        for (auto& ch : node->child) encodeRec(ch.get());
+    }
+
     // Inserção recursiva
-    void insertRec(QuadNode* node, const FeatureVector& vec) {
+    void insertRec(QuadNode* node, const FeatureVector& vec, int depth) {
         if (node->isLeaf) {
             node->pts.push_back(vec);
-            if ((int)node->pts.size() > QuadNode::CAPACITY) {
+            if (quantized) {
+                node->codes.resize(node->codes.size() + ScalarQuantizer::CODE_DIM);
+                quantizer.encode(vec, &node->codes[node->codes.size() - ScalarQuantizer::CODE_DIM]);
+            }
+            if ((int)node->pts.size() > QuadNode::CAPACITY && depth < QuadNode::MAX_DEPTH) {
                 std::vector<FeatureVector> oldPts;
                 oldPts.swap(node->pts);
+                node->codes.clear();
                 node->subdivide();
-                for (const auto& p : oldPts) insertIntoChild(node, p);
+                for (const auto& p : oldPts) insertIntoChild(node, p, depth);
             }
         } else {
-            insertIntoChild(node, vec);
+            insertIntoChild(node, vec, depth);
+        }
+    }
+
+    // Procura o ponto nas folhas que contêm (r, g); um ponto na borda pode estar em mais de uma caixa.
+    bool removeRec(QuadNode* node, int image_id, double r, double g) {
+        if (node->isLeaf) {
+            for (size_t i = 0; i < node->pts.size(); ++i) {
+                if (node->pts[i].image_id != image_id) continue;
+                node->pts[i] = node->pts.back();
+                node->pts.pop_back();
+                if (quantized) {
+                    std::copy_n(node->codes.end() - ScalarQuantizer::CODE_DIM, ScalarQuantizer::CODE_DIM,
+                                node->codes.begin() + i * ScalarQuantizer::CODE_DIM);
+                    node->codes.resize(node->codes.size() - ScalarQuantizer::CODE_DIM);
+                }
+                return true;
+            }
+            return false;
+        }
+        for (auto& ch : node->child) {
+            if (ch && ch->bbox.contains(r, g) && removeRec(ch.get(), image_id, r, g)) {
+                mergeChildren(node);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Transforma o nó de volta em folha se os quatro filhos são folhas e cabem nele.
+    void mergeChildren(QuadNode* node) {
+        size_t total = 0;
+        for (const auto& ch : node->child) {
+            if (ch && !ch->isLeaf) return;
+            if (ch) total += ch->pts.size();
+        }
+        if (total > static_cast<size_t>(QuadNode::CAPACITY)) return;
+        for (auto& ch : node->child) {
+            if (!ch) continue;
+            node->pts.insert(node->pts.end(), ch->pts.begin(), ch->pts.end());
+            node->codes.insert(node->codes.end(), ch->codes.begin(), ch->codes.end());
+            ch.reset();
         }
+        node->isLeaf = true;
     }
 
-    void insertIntoChild(QuadNode* node, const FeatureVector& vec) {
+    void insertIntoChild(QuadNode* node, const FeatureVector& vec, int depth) {
         double rMid = node->bbox.midR();
         double gMid = node->bbox.midG();
-        int q = QuadNode::quadrantOf(vec.r, vec.g, rMid, gMid);
+        int q = QuadNode::quadrantOf(vec[0], vec[1], rMid, gMid);
         QuadNode* ch = node->child[q].get();
-        insertRec(ch, vec);
+        insertRec(ch, vec, depth + 1);
     }
 
     // Expande a raiz para incluir pontos fora do box atual
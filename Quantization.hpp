@@ -0,0 +1,239 @@
+// Quantization.hpp
+
+#ifndef QUANTIZATION_HPP
+#define QUANTIZATION_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Vector.hpp"
+
+/**
+ * @class ScalarQuantizer
+ * @brief Quantização escalar de 8 bits: cada componente vira um código 0-255.
+ * * Usa uma única escala para todas as dimensões e nenhum deslocamento
+ * (código = round(x / escala)). Assim os códigos são, a menos do arredondamento,
+ * um múltiplo do vetor original e a similaridade de cosseno entre códigos
+ * aproxima a similaridade entre os vetores.
+ *
+ * Os códigos ocupam CODE_DIM bytes: 4 para vetores RGB (um int32 por vetor,
+ * quatro vetores por registrador de 16 bytes) ou D arredondado para múltiplo
+ * de 16 nas dimensões maiores. Um vetor RGB em double ocupa 24 bytes de dados;
+ * o código, 3 (+1 de preenchimento).
+ */
+class ScalarQuantizer {
+public:
+    static constexpr int DIM = FeatureVector::DIM;
+    static constexpr int CODE_DIM = (DIM <= 4) ? 4 : ((DIM + 15) / 16) * 16;
+
+    /**
+     * @param max_value Maior valor representável; componentes acima dele são saturados em 255.
+     */
+    explicit ScalarQuantizer(double max_value = 255.0)
+        : scale(max_value > 0.0 ? max_value / 255.0 : 1.0) {}
+
+    // Cria um quantizador cuja faixa cobre o maior componente do conjunto de dados.
+    static ScalarQuantizer fit(const std::vector<FeatureVector>& data) {
+        double max_value = 0.0;
+        for (const auto& vec : data) {
+            for (int d = 0; d < DIM; ++d) max_value = std::max(max_value, static_cast<double>(vec[d]));
+        }
+        return ScalarQuantizer(max_value);
+    }
+
+    // Codifica um vetor em CODE_DIM bytes a partir de 'out'.
+    void encode(const FeatureVector& vec, uint8_t* out) const {
+        for (int d = 0; d < CODE_DIM; ++d) {
+            double c = (d < DIM) ? std::round(static_cast<double>(vec[d]) / scale) : 0.0;
+            out[d] = static_cast<uint8_t>(std::min(255.0, std::max(0.0, c)));
+        }
+    }
+
+    double getScale() const { return scale; }
+
+private:
+    double scale;
+};
+
+/**
+ * @struct QuantizedQuery
+ * @brief Código de uma consulta, já expandido para 16 bits, e sua norma.
+ */
+struct QuantizedQuery {
+    alignas(16) int16_t code[ScalarQuantizer::CODE_DIM * (ScalarQuantizer::CODE_DIM == 4 ? 2 : 1)];
+    double norm = 0.0; // norma do código da consulta
+
+    QuantizedQuery(const ScalarQuantizer& q, const FeatureVector& vec) {
+        uint8_t raw[ScalarQuantizer::CODE_DIM];
+        q.encode(vec, raw);
+        long long sq = 0;
+        for (int d = 0; d < ScalarQuantizer::CODE_DIM; ++d) {
+            code[d] = raw[d];
+            sq += static_cast<long long>(raw[d]) * raw[d];
+        }
+        // Para códigos de 4 bytes, o padrão é repetido para cobrir dois vetores por registrador.
+        if (ScalarQuantizer::CODE_DIM == 4) {
+            for (int d = 0; d < 4; ++d) code[4 + d] = code[d];
+        }
+        norm = std::sqrt(static_cast<double>(sq));
+    }
+
+    /**
+     * @brief Converte a pontuação (dot^2 / |x|^2) de scoreCodes em distância do cosseno aproximada.
+     */
+    double approxDistance(float score) const {
+        if (norm == 0.0 || score <= 0.0f) return 1.0;
+        return 1.0 - std::sqrt(static_cast<double>(score)) / norm;
+    }
+};
+
+/**
+ * @brief Pontua 'n' códigos consecutivos contra a consulta.
+ * @details Para cada código x calcula, em aritmética inteira, dot = <q, x> e |x|^2,
+ * e grava score = dot^2 / |x|^2. Como os códigos são não negativos, ordenar por
+ * score (decrescente) equivale a ordenar pela similaridade de cosseno aproximada,
+ * sem raiz quadrada e sem armazenar normas: só os códigos são lidos da memória.
+ * @param codes n * CODE_DIM bytes.
+ * @param scores Recebe n pontuações (0 para códigos nulos).
+ */
+inline void scoreCodes(const QuantizedQuery& q, const uint8_t* codes, size_t n, float* scores) {
+    constexpr int CD = ScalarQuantizer::CODE_DIM;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    if constexpr (CD == 4) {
+        // 4 vetores por iteração: cada metade (8 x int16) contém 2 vetores.
+        const __m128i qv = _mm_load_si128(reinterpret_cast<const __m128i*>(q.code));
+        for (; i + 4 <= n; i += 4) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i * 4));
+            __m128i lo = _mm_unpacklo_epi8(x, zero);
+            __m128i hi = _mm_unpackhi_epi8(x, zero);
+            // madd soma pares de produtos; a soma dos pares vizinhos completa cada vetor.
+            __m128i dlo = _mm_madd_epi16(lo, qv), dhi = _mm_madd_epi16(hi, qv);
+            __m128i slo = _mm_madd_epi16(lo, lo), shi = _mm_madd_epi16(hi, hi);
+            dlo = _mm_add_epi32(dlo, _mm_shuffle_epi32(dlo, _MM_SHUFFLE(2, 3, 0, 1)));
+            dhi = _mm_add_epi32(dhi, _mm_shuffle_epi32(dhi, _MM_SHUFFLE(2, 3, 0, 1)));
+            slo = _mm_add_epi32(slo, _mm_shuffle_epi32(slo, _MM_SHUFFLE(2, 3, 0, 1)));
+            shi = _mm_add_epi32(shi, _mm_shuffle_epi32(shi, _MM_SHUFFLE(2, 3, 0, 1)));
+            // Pistas 0 e 2 de cada metade têm os resultados: junta os 4 vetores.
+            __m128i dot = _mm_unpacklo_epi64(_mm_shuffle_epi32(dlo, _MM_SHUFFLE(3, 1, 2, 0)),
+                                             _mm_shuffle_epi32(dhi, _MM_SHUFFLE(3, 1, 2, 0)));
+            __m128i sq = _mm_unpacklo_epi64(_mm_shuffle_epi32(slo, _MM_SHUFFLE(3, 1, 2, 0)),
+                                            _mm_shuffle_epi32(shi, _MM_SHUFFLE(3, 1, 2, 0)));
+            __m128 fd = _mm_cvtepi32_ps(dot);
+            __m128 fs = _mm_cvtepi32_ps(sq);
+            // score = dot^2 / |x|^2, com |x|^2 = 0 levando a 0 (máscara).
+            __m128 nz = _mm_cmpneq_ps(fs, _mm_setzero_ps());
+            __m128 sc = _mm_div_ps(_mm_mul_ps(fd, fd), _mm_or_ps(fs, _mm_andnot_ps(nz, _mm_set1_ps(1.0f))));
+            _mm_storeu_ps(scores + i, _mm_and_ps(sc, nz));
+        }
+    } else {
+        // Dimensões maiores: 16 bytes do código por iteração, acumulando em int32.
+        for (; i < n; ++i) {
+            const uint8_t* x = codes + i * CD;
+            __m128i acc_d = zero, acc_s = zero;
+            for (int d = 0; d < CD; d += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + d));
+                __m128i lo = _mm_unpacklo_epi8(v, zero);
+                __m128i hi = _mm_unpackhi_epi8(v, zero);
+                __m128i qlo = _mm_load_si128(reinterpret_cast<const __m128i*>(q.code + d));
+                __m128i qhi = _mm_load_si128(reinterpret_cast<const __m128i*>(q.code + d + 8));
+                acc_d = _mm_add_epi32(acc_d, _mm_add_epi32(_mm_madd_epi16(lo, qlo), _mm_madd_epi16(hi, qhi)));
+                acc_s = _mm_add_epi32(acc_s, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+            }
+            alignas(16) int32_t ld[4], ls[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(ld), acc_d);
+            _mm_store_si128(reinterpret_cast<__m128i*>(ls), acc_s);
+            float dot = static_cast<float>(ld[0] + ld[1] + ld[2] + ld[3]);
+            int32_t sq = ls[0] + ls[1] + ls[2] + ls[3];
+            scores[i] = sq ? dot * dot / static_cast<float>(sq) : 0.0f;
+        }
+    }
+#endif
+
+    // Versão escalar (cauda e arquiteturas sem SSE2).
+    for (; i < n; ++i) {
+        const uint8_t* x = codes + i * CD;
+        int32_t dot = 0, sq = 0;
+        for (int d = 0; d < CD; ++d) {
+            dot += static_cast<int32_t>(x[d]) * q.code[d];
+            sq += static_cast<int32_t>(x[d]) * x[d];
+        }
+        float fd = static_cast<float>(dot);
+        scores[i] = sq ? fd * fd / static_cast<float>(sq) : 0.0f;
+    }
+}
+
+/**
+ * @class CandidateHeap
+ * @brief Mantém os 'capacity' candidatos de maior pontuação aproximada (min-heap).
+ * @tparam T Identificação do candidato (índice, ponteiro, ...).
+ */
+template <typename T>
+class CandidateHeap {
+public:
+    struct Candidate {
+        float score;
+        T item;
+    };
+
+    explicit CandidateHeap(size_t capacity) : capacity(capacity) { items.reserve(capacity + 1); }
+
+    bool full() const { return items.size() >= capacity; }
+    float worstScore() const { return items.empty() ? 0.0f : items.front().score; }
+    size_t size() const { return items.size(); }
+
+    void push(float score, const T& item) {
+        if (capacity == 0) return;
+        if (items.size() < capacity) {
+            items.push_back({score, item});
+            std::push_heap(items.begin(), items.end(), cmp);
+        } else if (score > items.front().score) {
+            std::pop_heap(items.begin(), items.end(), cmp);
+            items.back() = {score, item};
+            std::push_heap(items.begin(), items.end(), cmp);
+        }
+    }
+
+    const std::vector<Candidate>& candidates() const { return items; }
+
+private:
+    size_t capacity;
+    std::vector<Candidate> items;
+    static bool cmp(const Candidate& a, const Candidate& b) { return a.score > b.score; }
+};
+
+/**
+ * @brief Reordena candidatos pela distância exata (distanceTo) e devolve os k melhores.
+ * @param comparisons Incrementado a cada distância exata calculada.
+ */
+template <typename T, typename Resolve>
+std::vector<FeatureVector> rerankExact(const FeatureVector& query_vec, const CandidateHeap<T>& heap,
+                                       int k, Resolve resolve, int& comparisons) {
+    std::vector<std::pair<double, const FeatureVector*>> exact;
+    exact.reserve(heap.size());
+    for (const auto& c : heap.candidates()) {
+        const FeatureVector& vec = resolve(c.item);
+        exact.emplace_back(query_vec.distanceTo(vec), &vec);
+        comparisons++;
+    }
+    size_t num_results = std::min(static_cast<size_t>(k), exact.size());
+    std::partial_sort(exact.begin(), exact.begin() + num_results, exact.end(),
+                      [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<FeatureVector> neighbors;
+    neighbors.reserve(num_results);
+    for (size_t i = 0; i < num_results; ++i) neighbors.push_back(*exact[i].second);
+    return neighbors;
+}
+
+#endif // QUANTIZATION_HPP
@@ -0,0 +1,503 @@
+#ifndef QUERY_SERVER_HPP
+#define QUERY_SERVER_HPP
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cmath>
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "DataStructure.hpp"
+#include "Protocol.hpp"
+
+/**
+ * @class LatencyHistogram
+ * @brief Histograma de latências em escala logarítmica: 16 faixas por potência de 2.
+ * @details Memória fixa e registro O(1), para um processo que roda por tempo
+ * indefinido (o Benchmark guarda todas as amostras, o que aqui não cabe). O
+ * percentil devolve o meio da faixa, com erro relativo abaixo de 1/32.
+ */
+class LatencyHistogram {
+private:
+    static constexpr int SUB = 16; // faixas por potência de 2
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    double sumNs = 0.0;
+
+    static int bucketOf(uint64_t ns) {
+        if (ns < SUB) return static_cast<int>(ns);
+        int e = 63 - __builtin_clzll(ns); // e >= 4
+        int sub = static_cast<int>((ns >> (e - 4)) & (SUB - 1));
+        return (e - 3) * SUB + sub;
+    }
+
+    static double bucketMid(int b) {
+        if (b < SUB) return b;
+        int e = b / SUB + 3;
+        double lower = static_cast<double>(static_cast<uint64_t>(SUB + b % SUB) << (e - 4));
+        return lower + static_cast<double>(1ull << (e - 4)) / 2.0;
+    }
+
+public:
+    LatencyHistogram() : counts(61 * SUB, 0) {}
+
+    void record(uint64_t ns) {
+        counts[bucketOf(ns)]++;
+        total++;
+        sumNs += static_cast<double>(ns);
+    }
+
+    void record(std::chrono::steady_clock::duration d) {
+        record(static_cast<uint64_t>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(d).count())));
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t b = 0; b < counts.size(); ++b) counts[b] += other.counts[b];
+        total += other.total;
+        sumNs += other.sumNs;
+    }
+
+    void clear() {
+        std::fill(counts.begin(), counts.end(), 0);
+        total = 0;
+        sumNs = 0.0;
+    }
+
+    uint64_t count() const { return total; }
+
+    double meanMs() const { return total == 0 ? 0.0 : sumNs / total / 1e6; }
+
+    // Percentil 'p' (0 a 100) pelo posto mais próximo, como percentile() do Benchmark.
+    double percentileMs(double p) const {
+        if (total == 0) return 0.0;
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p / 100.0 * total)));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < counts.size(); ++b) {
+            seen += counts[b];
+            if (seen >= rank) return bucketMid(static_cast<int>(b)) / 1e6;
+        }
+        return bucketMid(static_cast<int>(counts.size()) - 1) / 1e6;
+    }
+};
+
+/**
+ * @struct ServerCounters
+ * @brief Contadores de vazão e latência do servidor (resposta da operação Counters).
+ * @details A latência é medida no servidor, da chegada da requisição até o envio da resposta.
+ */
+struct ServerCounters {
+    uint64_t queries = 0;        // consultas respondidas
+    uint64_t batches = 0;        // lotes de consultas executados
+    uint64_t other_requests = 0; // inserções, remoções e demais operações
+    uint64_t errors = 0;         // requisições inválidas
+    double seconds = 0.0;        // desde o início ou a última zeragem
+    double mean_ms = 0.0, p50_ms = 0.0, p99_ms = 0.0, p999_ms = 0.0;
+
+    double qps() const { return seconds > 0.0 ? queries / seconds : 0.0; }
+    double meanBatch() const { return batches > 0 ? static_cast<double>(queries) / batches : 0.0; }
+
+    void write(WireBuffer& out) const {
+        for (uint64_t v : {queries, batches, other_requests, errors}) out.put(v);
+        for (double v : {seconds, mean_ms, p50_ms, p99_ms, p999_ms}) out.put(v);
+    }
+
+    bool read(WireBuffer& in) {
+        return in.get(queries) && in.get(batches) && in.get(other_requests) && in.get(errors) && in.get(seconds) &&
+               in.get(mean_ms) && in.get(p50_ms) && in.get(p99_ms) && in.get(p999_ms);
+    }
+};
+
+inline void printServerCounters(const ServerCounters& c) {
+    std::cout << "   consultas: " << c.queries << " em " << c.seconds << " s (" << c.qps() << " consultas/s), lotes: "
+              << c.batches << " (media " << c.meanBatch() << " consultas), outras: " << c.other_requests
+              << ", invalidas: " << c.errors << std::endl;
+    std::cout << "   latencia no servidor: media " << c.mean_ms << " ms, p50 " << c.p50_ms << " ms, p99 " << c.p99_ms
+              << " ms, p99.9 " << c.p999_ms << " ms" << std::endl;
+}
+
+/**
+ * Endereços aceitos pelo servidor e pelos clientes:
+ *   unix:CAMINHO  socket Unix no caminho dado
+ *   tcp:PORTA     TCP só na interface de loopback (127.0.0.1)
+ */
+inline bool parseEndpoint(const std::string& endpoint, bool& is_unix, std::string& path, int& port) {
+    if (endpoint.rfind("unix:", 0) == 0 && endpoint.size() > 5) {
+        is_unix = true;
+        path = endpoint.substr(5);
+        return path.size() < sizeof(sockaddr_un::sun_path);
+    }
+    if (endpoint.rfind("tcp:", 0) == 0) {
+        is_unix = false;
+        port = std::atoi(endpoint.c_str() + 4);
+        return port > 0 && port < 65536;
+    }
+    return false;
+}
+
+/**
+ * @brief Abre o socket de escuta do servidor; -1 (com mensagem) em caso de erro.
+ */
+inline int listenOn(const std::string& endpoint) {
+    bool is_unix;
+    std::string path;
+    int port = 0;
+    if (!parseEndpoint(endpoint, is_unix, path, port)) {
+        std::cerr << "Erro: endereco invalido '" << endpoint << "' (use unix:CAMINHO ou tcp:PORTA)." << std::endl;
+        return -1;
+    }
+    int fd = ::socket(is_unix ? AF_UNIX : AF_INET, SOCK_STREAM, 0);
+    int rc = -1;
+    if (fd >= 0 && is_unix) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        ::unlink(path.c_str()); // socket deixado por uma execução anterior
+        rc = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    } else if (fd >= 0) {
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        rc = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    }
+    if (rc != 0 || ::listen(fd, 128) != 0) {
+        std::cerr << "Erro: nao foi possivel escutar em '" << endpoint << "': " << std::strerror(errno) << std::endl;
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Conecta a um servidor; -1 (com mensagem) em caso de erro.
+ */
+inline int connectTo(const std::string& endpoint) {
+    bool is_unix;
+    std::string path;
+    int port = 0;
+    if (!parseEndpoint(endpoint, is_unix, path, port)) {
+        std::cerr << "Erro: endereco invalido '" << endpoint << "' (use unix:CAMINHO ou tcp:PORTA)." << std::endl;
+        return -1;
+    }
+    int fd = ::socket(is_unix ? AF_UNIX : AF_INET, SOCK_STREAM, 0);
+    int rc = -1;
+    if (fd >= 0 && is_unix) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        rc = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    } else if (fd >= 0) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        rc = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        int one = 1;
+        if (rc == 0) ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // respostas pequenas, sem Nagle
+    }
+    if (rc != 0) {
+        std::cerr << "Erro: nao foi possivel conectar em '" << endpoint << "': " << std::strerror(errno) << std::endl;
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @class QueryServer
+ * @brief Servidor de consultas k-NN sobre uma estrutura já construída.
+ * * Cada conexão tem uma thread leitora, que só decodifica os quadros
+ * (Protocol.hpp) e os põe numa fila única. Uma thread executora tira da fila
+ * micro-lotes: depois que a primeira requisição chega, espera até
+ * 'batch_wait_us' por outras, ou até juntar 'max_batch', e responde as
+ * consultas consecutivas do lote com uma única chamada a queryBatch() (o
+ * caminho de pontuação em lote). Com carga baixa a espera só acrescenta
+ * latência, então batch_wait_us = 0 desliga a espera (o lote é o que já está na fila).
+ *
+ * Como só a executora toca na estrutura, inserções e remoções também passam
+ * pela fila e a estrutura não precisa ser thread-safe; e como ela atende a
+ * fila em ordem, cada conexão recebe as respostas na ordem dos pedidos.
+ */
+class QueryServer {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Connection {
+        int fd;
+        std::mutex writeLock;
+        std::atomic<bool> finished{false}; // a leitora terminou
+        explicit Connection(int fd) : fd(fd) {}
+        ~Connection() { ::close(fd); } // só quando nenhuma requisição pendente a referencia
+    };
+
+    struct Request {
+        std::shared_ptr<Connection> conn;
+        WireOp op;
+        WireBuffer body;
+        Clock::time_point arrival;
+    };
+
+    struct Reader {
+        std::shared_ptr<Connection> conn;
+        std::thread thread;
+    };
+
+    DataStructure& index;
+    const size_t maxBatch;
+    const std::chrono::microseconds batchWait;
+
+    std::atomic<bool> stopping{false};
+    std::deque<Request> queue;
+    std::mutex queueLock;
+    std::condition_variable queueReady;
+    std::vector<Reader> readers; // só a thread de run() mexe
+
+    mutable std::mutex statsLock;
+    ServerCounters totals;       // contadores inteiros; latências e tempo ficam abaixo
+    LatencyHistogram latencies;
+    Clock::time_point since = Clock::now();
+
+    void readLoop(std::shared_ptr<Connection> conn) {
+        Request r;
+        while (!stopping && recvFrame(conn->fd, r.op, r.body)) {
+            r.conn = conn;
+            r.arrival = Clock::now();
+            {
+                std::lock_guard<std::mutex> guard(queueLock);
+                queue.push_back(std::move(r));
+            }
+            queueReady.notify_one();
+            r = Request();
+        }
+        conn->finished = true;
+    }
+
+    void reply(Request& r, WireOp op, const WireBuffer& body) {
+        std::lock_guard<std::mutex> guard(r.conn->writeLock);
+        sendFrame(r.conn->fd, op, body); // cliente que já fechou: a resposta é descartada
+    }
+
+    // Responde as consultas de 'pending' com uma chamada a queryBatch().
+    void flushQueries(std::vector<Request*>& pending) {
+        if (pending.empty()) return;
+        std::vector<FeatureVector> queries;
+        std::vector<Request*> valid;
+        std::vector<int32_t> ks;
+        int32_t max_k = 0;
+        uint64_t errors = 0;
+        WireBuffer out;
+        for (Request* r : pending) {
+            int32_t k;
+            FeatureVector q;
+            if (r->body.get(k) && r->body.getVector(q) && k >= 0 && k <= MAX_WIRE_K) {
+                queries.push_back(q);
+                ks.push_back(k);
+                valid.push_back(r);
+                max_k = std::max(max_k, k);
+            } else {
+                out.clear();
+                reply(*r, WireOp::Error, out);
+                errors++;
+            }
+        }
+        pending.clear();
+
+        // O lote usa o maior k pedido e cada resposta leva só os seus k primeiros vizinhos.
+        std::vector<QueryResult> results;
+        if (!queries.empty()) results = index.queryBatch(queries, max_k);
+        for (size_t i = 0; i < valid.size(); ++i) {
+            out.clear();
+            putQueryReply(out, results[i], static_cast<size_t>(ks[i]));
+            reply(*valid[i], WireOp::Query, out);
+        }
+        Clock::time_point now = Clock::now();
+
+        std::lock_guard<std::mutex> guard(statsLock);
+        totals.errors += errors;
+        if (valid.empty()) return;
+        totals.queries += valid.size();
+        totals.batches++;
+        for (Request* r : valid) latencies.record(now - r->arrival);
+    }
+
+    void handleOther(Request& r) {
+        WireBuffer out;
+        bool valid = true;
+        if (r.op == WireOp::Counters) {
+            uint8_t reset = 0;
+            r.body.get(reset);
+            counters(reset != 0).write(out);
+        } else if (r.op == WireOp::Shutdown) {
+            requestStop();
+        } else {
+            valid = applyRequest(index, r.op, r.body, out);
+        }
+        if (!valid) out.clear();
+        reply(r, valid ? r.op : WireOp::Error, out);
+        std::lock_guard<std::mutex> guard(statsLock);
+        if (valid) {
+            totals.other_requests++;
+        } else {
+            totals.errors++;
+        }
+    }
+
+    void executeLoop() {
+        std::vector<Request> batch;
+        std::vector<Request*> pending;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lk(queueLock);
+                queueReady.wait(lk, [this] { return stopping || !queue.empty(); });
+                if (stopping) return;
+                if (batchWait.count() > 0 && queue.size() < maxBatch) {
+                    // Micro-lote: espera outras requisições até o prazo contado da chegada da primeira.
+                    Clock::time_point deadline = queue.front().arrival + batchWait;
+                    queueReady.wait_until(lk, deadline, [this] { return stopping || queue.size() >= maxBatch; });
+                    if (stopping) return;
+                }
+                size_t take = std::min(queue.size(), maxBatch);
+                for (size_t i = 0; i < take; ++i) {
+                    batch.push_back(std::move(queue.front()));
+                    queue.pop_front();
+                }
+            }
+            // Consultas consecutivas formam um lote; as demais operações são executadas na ordem de chegada.
+            for (Request& r : batch) {
+                if (r.op == WireOp::Query) {
+                    pending.push_back(&r);
+                } else {
+                    flushQueries(pending);
+                    handleOther(r);
+                }
+            }
+            flushQueries(pending);
+            batch.clear();
+        }
+    }
+
+    // Junta as leitoras de conexões já encerradas.
+    void reapReaders() {
+        for (size_t i = 0; i < readers.size();) {
+            if (readers[i].conn->finished) {
+                readers[i].thread.join();
+                readers[i] = std::move(readers.back());
+                readers.pop_back();
+            } else {
+                ++i;
+            }
+        }
+    }
+
+public:
+    /**
+     * @param index Estrutura já construída; depois de run() só a thread executora a usa.
+     * @param max_batch Maior número de requisições num micro-lote.
+     * @param batch_wait_us Quanto esperar por mais requisições depois da primeira (0 = não esperar).
+     */
+    QueryServer(DataStructure& index, size_t max_batch = 64, int batch_wait_us = 100)
+        : index(index), maxBatch(std::max<size_t>(1, max_batch)), batchWait(std::max(0, batch_wait_us)) {}
+
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+
+    /**
+     * @brief Atende conexões em 'endpoint' até requestStop() ou uma requisição Shutdown.
+     * @param report_seconds Se > 0, imprime os contadores a cada tantos segundos.
+     * @return false se não foi possível abrir o endereço.
+     */
+    bool run(const std::string& endpoint, double report_seconds = 0.0) {
+        int listener = listenOn(endpoint);
+        if (listener < 0) return false;
+        {
+            std::lock_guard<std::mutex> guard(statsLock);
+            since = Clock::now();
+        }
+        std::thread executor(&QueryServer::executeLoop, this);
+        Clock::time_point last_report = Clock::now();
+
+        while (!stopping) {
+            // poll com prazo curto: requestStop() pode vir de um tratador de sinal.
+            pollfd p{listener, POLLIN, 0};
+            if (::poll(&p, 1, 200) > 0) {
+                int fd = ::accept(listener, nullptr, nullptr);
+                if (fd >= 0) {
+                    int one = 1;
+                    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // falha (inofensiva) em sockets Unix
+                    auto conn = std::make_shared<Connection>(fd);
+                    readers.push_back(Reader{conn, std::thread(&QueryServer::readLoop, this, conn)});
+                }
+            }
+            reapReaders();
+            if (report_seconds > 0.0 &&
+                std::chrono::duration<double>(Clock::now() - last_report).count() >= report_seconds) {
+                printServerCounters(counters());
+                last_report = Clock::now();
+            }
+        }
+
+        ::close(listener);
+        bool is_unix;
+        std::string path;
+        int port;
+        if (parseEndpoint(endpoint, is_unix, path, port) && is_unix) ::unlink(path.c_str());
+
+        // Acorda a executora e desbloqueia as leitoras presas em recv().
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+        }
+        queueReady.notify_all();
+        for (Reader& r : readers) ::shutdown(r.conn->fd, SHUT_RDWR);
+        for (Reader& r : readers) r.thread.join();
+        executor.join();
+        readers.clear();
+        queue.clear();
+        return true;
+    }
+
+    // Pede o encerramento de run(); só grava um atômico, então pode ser chamada por um tratador de sinal.
+    void requestStop() { stopping = true; }
+
+    /**
+     * @brief Contadores desde o início (ou a última zeragem).
+     * @param reset Se true, zera os contadores depois de lê-los.
+     */
+    ServerCounters counters(bool reset = false) {
+        std::lock_guard<std::mutex> guard(statsLock);
+        ServerCounters c = totals;
+        c.seconds = std::chrono::duration<double>(Clock::now() - since).count();
+        c.mean_ms = latencies.meanMs();
+        c.p50_ms = latencies.percentileMs(50.0);
+        c.p99_ms = latencies.percentileMs(99.0);
+        c.p999_ms = latencies.percentileMs(99.9);
+        if (reset) {
+            totals = ServerCounters();
+            latencies.clear();
+            since = Clock::now();
+        }
+        return c;
+    }
+};
+
+#endif // QUERY_SERVER_HPP
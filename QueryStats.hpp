@@ -0,0 +1,108 @@
+// QueryStats.hpp
+
+#ifndef QUERY_STATS_HPP
+#define QUERY_STATS_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// Estatísticas detalhadas por consulta. Compile com -DQUERY_STATS=0 para removê-las:
+// os métodos viram funções vazias (o compilador elimina as chamadas) e as colunas somem dos relatórios.
+#ifndef QUERY_STATS
+#define QUERY_STATS 1
+#endif
+
+/**
+ * @struct BasicQueryStats
+ * @brief O que uma busca percorreu, para explicar latências fora do padrão.
+ * @details Cada estrutura preenche só o que faz sentido para ela (a Quadtree
+ * conta nós e podas, a Hash conta buckets e cadeias); o resto fica em zero.
+ * A especialização <false> tem a mesma interface, sem dados.
+ */
+template <bool Enabled>
+struct BasicQueryStats;
+
+template <>
+struct BasicQueryStats<true> {
+    static constexpr bool enabled = true;
+
+    // Árvores
+    uint64_t nodes_expanded = 0;  // nós internos cujos filhos foram examinados
+    uint64_t leaves_scanned = 0;  // folhas cujos pontos foram comparados
+    uint64_t max_fringe = 0;      // maior tamanho da fila de prioridade
+    uint64_t pruned_subtrees = 0; // subárvores descartadas pelo limite inferior
+    // Tabelas hash
+    uint64_t buckets_probed = 0;  // buckets consultados (um por tabela)
+    uint64_t chain_entries = 0;   // nós percorridos em todas as cadeias
+    uint64_t max_chain = 0;       // maior cadeia percorrida
+    uint64_t duplicate_hits = 0;  // vetores já vistos em outra tabela
+    // Remoções
+    uint64_t dead_skipped = 0;    // vetores apagados (tombstones) encontrados e ignorados
+    // Todas
+    uint64_t bytes_touched = 0;   // estimativa dos bytes lidos da estrutura
+
+    void expandNode() { ++nodes_expanded; }
+    void scanLeaf() { ++leaves_scanned; }
+    void fringeSize(size_t n) { max_fringe = std::max<uint64_t>(max_fringe, n); }
+    void prune(size_t n = 1) { pruned_subtrees += n; }
+    void probeBucket(size_t chain_length) {
+        ++buckets_probed;
+        chain_entries += chain_length;
+        max_chain = std::max<uint64_t>(max_chain, chain_length);
+    }
+    void duplicateHit() { ++duplicate_hits; }
+    void skipDead() { ++dead_skipped; }
+    void touch(size_t bytes) { bytes_touched += bytes; }
+
+    // Acumula as estatísticas de outra consulta (somas; os máximos também são somados, para tirar a média depois).
+    void accumulate(const BasicQueryStats& o) {
+        nodes_expanded += o.nodes_expanded;
+        leaves_scanned += o.leaves_scanned;
+        max_fringe += o.max_fringe;
+        pruned_subtrees += o.pruned_subtrees;
+        buckets_probed += o.buckets_probed;
+        chain_entries += o.chain_entries;
+        max_chain += o.max_chain;
+        duplicate_hits += o.duplicate_hits;
+        dead_skipped += o.dead_skipped;
+        bytes_touched += o.bytes_touched;
+    }
+
+    static std::vector<std::string> columns() {
+        return {"nos_expandidos", "folhas_varridas", "fronteira_max", "subarvores_podadas", "buckets_sondados",
+                "entradas_cadeias", "cadeia_max", "duplicatas", "apagados_ignorados", "bytes_lidos"};
+    }
+
+    std::vector<double> values() const {
+        return {static_cast<double>(nodes_expanded), static_cast<double>(leaves_scanned),
+                static_cast<double>(max_fringe), static_cast<double>(pruned_subtrees),
+                static_cast<double>(buckets_probed), static_cast<double>(chain_entries),
+                static_cast<double>(max_chain), static_cast<double>(duplicate_hits),
+                static_cast<double>(dead_skipped), static_cast<double>(bytes_touched)};
+    }
+};
+
+template <>
+struct BasicQueryStats<false> {
+    static constexpr bool enabled = false;
+
+    void expandNode() {}
+    void scanLeaf() {}
+    void fringeSize(size_t) {}
+    void prune(size_t = 1) {}
+    void probeBucket(size_t) {}
+    void duplicateHit() {}
+    void skipDead() {}
+    void touch(size_t) {}
+    void accumulate(const BasicQueryStats&) {}
+
+    static std::vector<std::string> columns() { return {}; }
+    std::vector<double> values() const { return {}; }
+};
+
+using QueryStats = BasicQueryStats<QUERY_STATS != 0>;
+
+#endif // QUERY_STATS_HPP
@@ -0,0 +1,334 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <iostream>
+
+#include "DataStructure.hpp"
+
+/**
+ * @struct CacheStats
+ * @brief Acertos, faltas e economia de tempo de um CachedIndex.
+ */
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;      // inclui as entradas invalidadas
+    uint64_t stale = 0;       // faltas por entrada de uma geração antiga (após insert/remove)
+    uint64_t evictions = 0;
+    double hit_ms = 0.0;      // tempo total gasto nos acertos
+    double miss_ms = 0.0;     // tempo total gasto nas faltas (consulta à estrutura)
+
+    double hitRate() const { return hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+
+    // Tempo economizado: cada acerto teria custado uma falta média.
+    double savedMs() const {
+        return misses > 0 ? std::max(0.0, hits * (miss_ms / misses) - hit_ms) : 0.0;
+    }
+};
+
+inline void printCacheStats(const CacheStats& s) {
+    std::cout << "   cache: " << s.hits << " acertos, " << s.misses << " faltas (" << s.stale << " invalidadas), taxa "
+              << 100.0 * s.hitRate() << "%, " << s.evictions << " descartes, tempo economizado " << s.savedMs()
+              << " ms" << std::endl;
+}
+
+/**
+ * @class CachedIndex
+ * @brief Cache de resultados na frente de qualquer DataStructure.
+ * * A chave é (consulta quantizada, k): cada componente vira floor(x / cell),
+ * então consultas quase idênticas (cores que diferem por menos de 'cell')
+ * caem na mesma entrada e recebem o resultado calculado para a primeira
+ * delas. Com cell = 0 a chave são os bits exatos da consulta e o cache nunca
+ * muda um resultado.
+ *
+ * Invalidação por geração: cada insert/remove/update bem-sucedido incrementa
+ * um contador global, e uma entrada só vale se foi calculada na geração
+ * atual. A escrita custa O(1) e nenhuma consulta recebe um resultado anterior
+ * a uma escrita já concluída. Por isso o contador só é incrementado depois
+ * que a estrutura terminou a escrita, e a consulta lê a geração antes de
+ * consultar a estrutura. Escritas frequentes esvaziam o cache, que é o preço
+ * de não percorrer as entradas a cada escrita.
+ *
+ * O cache é dividido em SHARDS partes pelo hash da chave, cada uma com o seu
+ * mutex e a sua substituição CLOCK (um bit de uso por entrada: o ponteiro
+ * circular dá uma segunda chance às entradas usadas desde a última volta).
+ * Assim consultas concorrentes raramente disputam o mesmo lock. Se a estrutura
+ * de dentro não for thread-safe (inner_thread_safe = false), as chamadas a ela
+ * são serializadas por um mutex próprio, e os acertos continuam em paralelo.
+ */
+class CachedIndex : public DataStructure {
+private:
+    static constexpr int DIM = FeatureVector::DIM;
+    static constexpr size_t SHARDS = 16;
+    static_assert(sizeof(FeatureVector::ScalarType) <= sizeof(int64_t), "componente nao cabe na chave do cache");
+    using Clock = std::chrono::steady_clock;
+
+    struct Key {
+        std::array<int64_t, DIM> cell; // célula (ou os bits exatos) de cada componente
+        int32_t k;
+        bool operator==(const Key& o) const { return k == o.k && cell == o.cell; }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            uint64_t h = 1469598103934665603ull ^ static_cast<uint32_t>(key.k);
+            for (int64_t c : key.cell) h = (h ^ static_cast<uint64_t>(c)) * 1099511628211ull;
+            return static_cast<size_t>(h ^ (h >> 29));
+        }
+    };
+
+    struct Entry {
+        Key key;
+        std::vector<FeatureVector> neighbors;
+        uint64_t generation = 0;
+        bool referenced = false;
+        bool used = false;
+    };
+
+    struct Shard {
+        mutable std::mutex lock;
+        std::vector<Entry> entries;                    // anel do CLOCK
+        std::unordered_map<Key, size_t, KeyHash> slot; // chave -> posição em 'entries'
+        size_t hand = 0;
+        CacheStats stats;
+    };
+
+    std::unique_ptr<DataStructure> inner;
+    const double cell;
+    const bool innerThreadSafe;
+    std::mutex innerLock;
+    std::atomic<uint64_t> generation{0};
+    std::array<Shard, SHARDS> shards;
+
+    Key keyOf(const FeatureVector& q, int k) const {
+        Key key;
+        key.k = k;
+        for (int d = 0; d < DIM; ++d) {
+            if (cell > 0.0) {
+                key.cell[d] = static_cast<int64_t>(std::floor(static_cast<double>(q[d]) / cell));
+            } else {
+                FeatureVector::ScalarType x = q[d];
+                key.cell[d] = 0;
+                std::memcpy(&key.cell[d], &x, sizeof(x));
+            }
+        }
+        return key;
+    }
+
+    // Posição livre no anel: a primeira não usada ou a escolhida pelo CLOCK (chamar com o lock da parte).
+    size_t victim(Shard& shard) {
+        while (true) {
+            Entry& e = shard.entries[shard.hand];
+            size_t at = shard.hand;
+            shard.hand = (shard.hand + 1) % shard.entries.size();
+            if (!e.used) return at;
+            if (e.referenced) {
+                e.referenced = false;
+                continue;
+            }
+            shard.slot.erase(e.key);
+            shard.stats.evictions++;
+            return at;
+        }
+    }
+
+    Shard& shardOf(const Key& key) { return shards[KeyHash()(key) % SHARDS]; }
+
+    // Acerto: copia o resultado da entrada válida para 'out'. Senão diz se a falta é de uma entrada invalidada.
+    bool lookup(Shard& shard, const Key& key, uint64_t gen, QueryResult& out, bool& stale, Clock::time_point start) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.slot.find(key);
+        if (it == shard.slot.end()) return false;
+        Entry& e = shard.entries[it->second];
+        if (!(e.key == key) || e.generation != gen) {
+            stale = true;
+            return false;
+        }
+        e.referenced = true;
+        out.neighbors = e.neighbors;
+        shard.stats.hits++;
+        shard.stats.hit_ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        return true;
+    }
+
+    // Guarda o resultado de uma falta calculado na geração 'gen' e conta a falta. Um resultado que uma
+    // escrita já invalidou não é guardado: ele não serviria a nenhuma consulta nova e, guardado, tiraria
+    // do anel (ou sobrescreveria) um resultado mais novo.
+    void fill(Shard& shard, const Key& key, uint64_t gen, const std::vector<FeatureVector>& neighbors, bool stale,
+              double miss_ms) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.slot.find(key);
+        bool current = gen == generation.load();
+        if (current && (it == shard.slot.end() || shard.entries[it->second].generation <= gen)) {
+            size_t at;
+            if (it != shard.slot.end()) {
+                at = it->second; // a entrada invalidada desta chave
+            } else {
+                at = victim(shard);
+                shard.slot[key] = at;
+            }
+            Entry& e = shard.entries[at];
+            e.key = key;
+            e.neighbors = neighbors;
+            e.generation = gen;
+            e.referenced = false;
+            e.used = true;
+        }
+        shard.stats.misses++;
+        if (stale) shard.stats.stale++;
+        shard.stats.miss_ms += miss_ms;
+    }
+
+    template <typename F>
+    auto callInner(F f) -> decltype(f()) {
+        if (innerThreadSafe) return f();
+        std::lock_guard<std::mutex> guard(innerLock);
+        return f();
+    }
+
+public:
+    /**
+     * @param inner Estrutura consultada nas faltas (o cache passa a ser o dono dela).
+     * @param capacity Número máximo de resultados guardados (dividido entre as partes).
+     * @param cell Largura da célula de quantização da chave, nas unidades dos componentes (0 = chave exata).
+     * @param inner_thread_safe Se true, as consultas à estrutura de dentro não são serializadas.
+     */
+    CachedIndex(std::unique_ptr<DataStructure> inner, size_t capacity, double cell = 0.0, bool inner_thread_safe = false)
+        : inner(std::move(inner)), cell(std::max(0.0, cell)), innerThreadSafe(inner_thread_safe) {
+        size_t per_shard = std::max<size_t>(1, (capacity + SHARDS - 1) / SHARDS);
+        for (Shard& s : shards) {
+            s.entries.resize(per_shard);
+            s.slot.reserve(per_shard);
+        }
+    }
+
+    ~CachedIndex() override = default;
+
+    void insert(const FeatureVector& vec) override {
+        callInner([&] { inner->insert(vec); });
+        generation++;
+    }
+
+    bool remove(int image_id) override {
+        bool removed = callInner([&] { return inner->remove(image_id); });
+        if (removed) generation++;
+        return removed;
+    }
+
+    bool update(const FeatureVector& vec) override {
+        bool existed = callInner([&] { return inner->update(vec); });
+        generation++;
+        return existed;
+    }
+
+    QueryResult query(const FeatureVector& query_vec, int k) override {
+        Clock::time_point start = Clock::now();
+        Key key = keyOf(query_vec, k);
+        Shard& shard = shardOf(key);
+        uint64_t gen = generation.load();
+        QueryResult result;
+        bool stale = false;
+        if (lookup(shard, key, gen, result, stale, start)) return result;
+
+        result = callInner([&] { return inner->query(query_vec, k); });
+        fill(shard, key, gen, result.neighbors, stale, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        return result;
+    }
+
+    /**
+     * @brief Consultas em lote: os acertos saem do cache e as faltas vão juntas para inner->queryBatch().
+     * @details Assim a estrutura de dentro mantém o seu próprio lote (a varredura
+     * em blocos do Flat, o percurso intercalado da Hash). Consultas repetidas no
+     * mesmo lote são calculadas uma vez só. A geração é lida antes do lote, como em query().
+     */
+    std::vector<QueryResult> queryBatch(const std::vector<FeatureVector>& queries, int k) override {
+        Clock::time_point start = Clock::now();
+        uint64_t gen = generation.load();
+        std::vector<QueryResult> results(queries.size());
+        std::vector<Key> keys;
+        keys.reserve(queries.size());
+        std::vector<FeatureVector> missed;         // consultas que vão para a estrutura
+        std::vector<size_t> missOf(queries.size()); // posição em 'missed' (SIZE_MAX = acerto)
+        std::vector<bool> staleOf;
+        std::unordered_map<Key, size_t, KeyHash> pending;
+
+        for (size_t i = 0; i < queries.size(); ++i) {
+            keys.push_back(keyOf(queries[i], k));
+            const Key& key = keys.back();
+            auto dup = pending.find(key);
+            if (dup != pending.end()) {
+                missOf[i] = dup->second;
+                continue;
+            }
+            bool stale = false;
+            if (lookup(shardOf(key), key, gen, results[i], stale, Clock::now())) {
+                missOf[i] = SIZE_MAX;
+                continue;
+            }
+            missOf[i] = missed.size();
+            pending.emplace(key, missed.size());
+            missed.push_back(queries[i]);
+            staleOf.push_back(stale);
+        }
+        if (missed.empty()) return results;
+
+        std::vector<QueryResult> computed = callInner([&] { return inner->queryBatch(missed, k); });
+        double per_miss = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / missed.size();
+        std::vector<bool> stored(missed.size(), false);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            if (missOf[i] == SIZE_MAX) continue;
+            size_t m = missOf[i];
+            results[i] = computed[m];
+            if (stored[m]) { // repetida no lote: conta como acerto
+                Shard& shard = shardOf(keys[i]);
+                std::lock_guard<std::mutex> guard(shard.lock);
+                shard.stats.hits++;
+                continue;
+            }
+            stored[m] = true;
+            fill(shardOf(keys[i]), keys[i], gen, computed[m].neighbors, staleOf[m], per_miss);
+        }
+        return results;
+    }
+
+    MemoryUsage memoryUsage() const override {
+        MemoryUsage usage = inner->memoryUsage();
+        usage.addObject(sizeof(*this));
+        for (const Shard& s : shards) {
+            std::lock_guard<std::mutex> guard(s.lock);
+            usage.addVector(s.entries);
+            for (const Entry& e : s.entries) usage.addVector(e.neighbors);
+            usage.addMap(s.slot);
+        }
+        return usage;
+    }
+
+    // Soma das estatísticas das partes.
+    CacheStats stats() const {
+        CacheStats total;
+        for (const Shard& s : shards) {
+            std::lock_guard<std::mutex> guard(s.lock);
+            total.hits += s.stats.hits;
+            total.misses += s.stats.misses;
+            total.stale += s.stats.stale;
+            total.evictions += s.stats.evictions;
+            total.hit_ms += s.stats.hit_ms;
+            total.miss_ms += s.stats.miss_ms;
+        }
+        return total;
+    }
+
+    DataStructure& structure() { return *inner; }
+};
+
+#endif // RESULT_CACHE_HPP
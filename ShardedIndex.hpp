@@ -0,0 +1,449 @@
+#ifndef SHARDED_INDEX_HPP
+#define SHARDED_INDEX_HPP
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "DataStructure.hpp"
+#include "Protocol.hpp"
+#include "KMeans.hpp"
+
+/**
+ * @brief Laço de um processo shard: atende as requisições que chegam em 'fd' sobre 'ds'.
+ * @details Termina com Shutdown ou quando o outro lado fecha a conexão.
+ */
+inline void serveShard(int fd, DataStructure& ds) {
+    WireBuffer request, reply;
+    WireOp op;
+    while (recvFrame(fd, op, request)) {
+        reply.clear();
+        if (op == WireOp::Shutdown) {
+            sendFrame(fd, op, reply);
+            return;
+        }
+        bool valid = applyRequest(ds, op, request, reply);
+        if (!valid) reply.clear();
+        if (!sendFrame(fd, valid ? op : WireOp::Error, reply)) return;
+    }
+}
+
+/**
+ * @brief Como o ShardedIndex divide os vetores entre os shards.
+ */
+enum class ShardPolicy {
+    Hash,    // pelo hash do image_id: shards equilibrados, toda consulta visita todos
+    Spatial  // por região angular (k-means sobre os vetores normalizados): permite pular shards
+};
+
+// Constrói a estrutura de um shard a partir da sua parte dos vetores (roda no processo filho).
+using ShardFactory = std::function<std::unique_ptr<DataStructure>(const std::vector<FeatureVector>&)>;
+
+/**
+ * @class ShardedIndex
+ * @brief Índice dividido entre N processos shard na mesma máquina, com um coordenador.
+ * * Cada shard é um processo filho (fork) com a sua própria estrutura, criada
+ * por 'factory', e conversa com o coordenador por um socket Unix (socketpair)
+ * usando o protocolo de Protocol.hpp. Assim o índice usa a memória e os núcleos
+ * de vários processos, e uma falha de um shard não derruba os demais.
+ *
+ * A consulta é scatter-gather: o coordenador envia a consulta aos shards (que
+ * buscam em paralelo, cada um no seu processo), junta os top-k parciais,
+ * recalcula as distâncias, fica com os k melhores e soma as comparações.
+ *
+ * Na divisão espacial, cada shard guarda um cone: a direção do seu centróide
+ * e o maior ângulo θ entre ela e os vetores do shard. Se a consulta faz um
+ * ângulo α com a direção, nenhum vetor do shard está a menos de
+ * 1 - cos(max(0, α - θ)) da consulta (desigualdade triangular dos ângulos).
+ * O coordenador consulta primeiro o shard de menor limite e depois, em
+ * paralelo, só os shards cujo limite ainda pode bater o k-ésimo vizinho; os
+ * demais são contados em stats.prune(). Inserções alargam θ; remoções não o
+ * encolhem (o limite continua válido, só fica menos justo).
+ *
+ * Como nas demais estruturas, erros (shard que não responde) são avisados no
+ * console: o shard é descartado e as consultas seguem com os outros.
+ * As operações são serializadas por um mutex do coordenador.
+ */
+class ShardedIndex : public DataStructure {
+private:
+    static constexpr int DIM = FeatureVector::DIM;
+    static constexpr size_t MAX_TRAIN = 50000; // vetores usados no k-means da divisão espacial
+
+    struct Shard {
+        pid_t pid = -1;
+        int fd = -1;
+        bool alive = false;
+        size_t count = 0;       // vetores vivos no shard
+        bool bounded = false;   // tem cone (direção em 'centroids')
+        double theta = 0.0;     // maior ângulo entre a direção e um vetor do shard
+        bool hasZero = false;   // guarda o vetor nulo (distância 1 de tudo)
+    };
+
+    ShardPolicy policy;
+    ShardFactory factory;
+    std::vector<Shard> shards;
+    std::vector<float> centroids;            // direções (norma 1) dos shards com cone, DIM floats cada
+    int trained = 0;                         // shards com cone (os primeiros 'trained')
+    std::unordered_map<int, int> shardOf;    // image_id -> shard (só na divisão espacial)
+    mutable std::mutex lock;
+
+    // Normaliza 'vec' em 'out'; false para o vetor nulo.
+    static bool unitOf(const FeatureVector& vec, float* out) {
+        double sq = 0.0;
+        for (int d = 0; d < DIM; ++d) sq += static_cast<double>(vec[d]) * static_cast<double>(vec[d]);
+        if (sq <= 0.0) return false;
+        double inv = 1.0 / std::sqrt(sq);
+        for (int d = 0; d < DIM; ++d) out[d] = static_cast<float>(static_cast<double>(vec[d]) * inv);
+        return true;
+    }
+
+    // Ângulo entre o vetor unitário 'u' e a direção do shard 's'.
+    double angleTo(int s, const float* u) const {
+        const float* c = &centroids[static_cast<size_t>(s) * DIM];
+        double dot = 0.0;
+        for (int d = 0; d < DIM; ++d) dot += static_cast<double>(u[d]) * static_cast<double>(c[d]);
+        return std::acos(std::max(-1.0, std::min(1.0, dot)));
+    }
+
+    int hashShard(int image_id) const {
+        uint64_t h = static_cast<uint64_t>(static_cast<uint32_t>(image_id)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<int>((h >> 32) % shards.size());
+    }
+
+    // Escolhe o shard de um vetor novo e alarga o cone dele.
+    int route(const FeatureVector& vec) {
+        float u[DIM];
+        if (policy == ShardPolicy::Hash || trained == 0) return hashShard(vec.image_id);
+        if (!unitOf(vec, u)) {
+            int s = hashShard(vec.image_id);
+            shards[s].hasZero = true;
+            return s;
+        }
+        int s = nearestCentroid(u, centroids, trained, DIM);
+        shards[s].theta = std::max(shards[s].theta, angleTo(s, u));
+        return s;
+    }
+
+    // Limite inferior da distância do cosseno entre a consulta (unitária 'u', ou nula) e o shard 's'.
+    double lowerBound(int s, const float* u, bool zero_query) const {
+        const Shard& sh = shards[s];
+        if (!sh.bounded || zero_query) return 0.0;
+        double gap = std::max(0.0, angleTo(s, u) - sh.theta);
+        double lb = 1.0 - std::cos(std::min(gap, M_PI));
+        return sh.hasZero ? std::min(lb, 1.0) : lb;
+    }
+
+    void fail(int s) {
+        if (!shards[s].alive) return;
+        std::cerr << "Erro: shard " << s << " nao responde; seguindo sem ele." << std::endl;
+        shards[s].alive = false;
+        shards[s].count = 0;
+    }
+
+    bool sendTo(int s, WireOp op, const WireBuffer& body) {
+        if (!shards[s].alive) return false;
+        if (sendFrame(shards[s].fd, op, body)) return true;
+        fail(s);
+        return false;
+    }
+
+    bool receiveFrom(int s, WireOp op, WireBuffer& reply) {
+        WireOp got;
+        if (shards[s].alive && recvFrame(shards[s].fd, got, reply) && got == op) return true;
+        fail(s);
+        return false;
+    }
+
+    bool call(int s, WireOp op, const WireBuffer& body, WireBuffer& reply) {
+        return sendTo(s, op, body) && receiveFrom(s, op, reply);
+    }
+
+    // Cria o processo do shard 's', que constrói a sua estrutura com 'part' e passa a atender.
+    bool spawn(int s, const std::vector<FeatureVector>& part) {
+        int sv[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+            std::cerr << "Erro: nao foi possivel criar o socket do shard " << s << "." << std::endl;
+            return false;
+        }
+        std::cout.flush();
+        std::cerr.flush();
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            std::cerr << "Erro: nao foi possivel criar o processo do shard " << s << "." << std::endl;
+            ::close(sv[0]);
+            ::close(sv[1]);
+            return false;
+        }
+        if (pid == 0) {
+            // Filho: fecha as pontas do coordenador e sai com _exit (sem descarregar buffers herdados).
+            ::close(sv[0]);
+            for (const Shard& other : shards) {
+                if (other.fd >= 0) ::close(other.fd);
+            }
+            std::unique_ptr<DataStructure> ds = factory(part);
+            serveShard(sv[1], *ds);
+            ::_exit(0);
+        }
+        ::close(sv[1]);
+        shards[s].pid = pid;
+        shards[s].fd = sv[0];
+        shards[s].alive = true;
+        return true;
+    }
+
+    void shutdown() {
+        WireBuffer empty, reply;
+        for (size_t s = 0; s < shards.size(); ++s) {
+            if (shards[s].alive) call(static_cast<int>(s), WireOp::Shutdown, empty, reply);
+            if (shards[s].fd >= 0) ::close(shards[s].fd);
+            if (shards[s].pid > 0) ::waitpid(shards[s].pid, nullptr, 0);
+        }
+        shards.clear();
+    }
+
+public:
+    /**
+     * @param num_shards Número de processos shard (pelo menos 1).
+     * @param policy Divisão por hash do ID ou por região angular.
+     * @param factory Constrói a estrutura de cada shard (por exemplo, uma Quadtree).
+     */
+    ShardedIndex(int num_shards, ShardPolicy policy, ShardFactory factory)
+        : policy(policy), factory(std::move(factory)), shards(static_cast<size_t>(std::max(1, num_shards))) {}
+
+    ShardedIndex(const ShardedIndex&) = delete;
+    ShardedIndex& operator=(const ShardedIndex&) = delete;
+
+    ~ShardedIndex() override {
+        shutdown();
+    }
+
+    /**
+     * @brief Divide 'data' entre os shards, cria os processos e espera todos terminarem a construção.
+     * @details Deve ser chamado uma vez, antes de qualquer outra operação. Na divisão
+     * espacial, o k-means sobre (uma amostra de) 'data' define as regiões; sem dados,
+     * os vetores vão por hash e nenhum shard é pulado.
+     * @return false se algum shard não pôde ser criado.
+     */
+    bool build(const std::vector<FeatureVector>& data) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (shards.front().pid > 0) {
+            std::cerr << "Erro: o indice distribuido ja foi construido." << std::endl;
+            return false;
+        }
+
+        if (policy == ShardPolicy::Spatial) {
+            // Treina sobre vetores normalizados (o vetor nulo não tem direção).
+            std::vector<float> train;
+            size_t n = 0;
+            size_t step = std::max<size_t>(1, data.size() / MAX_TRAIN);
+            float u[DIM];
+            for (size_t i = 0; i < data.size() && n < MAX_TRAIN; i += step) {
+                if (!unitOf(data[i], u)) continue;
+                train.insert(train.end(), u, u + DIM);
+                n++;
+            }
+            centroids = kmeans(train, n, DIM, static_cast<int>(shards.size()));
+            trained = static_cast<int>(centroids.size() / DIM);
+            for (int s = 0; s < trained; ++s) {
+                float* c = &centroids[static_cast<size_t>(s) * DIM];
+                double sq = 0.0;
+                for (int d = 0; d < DIM; ++d) sq += static_cast<double>(c[d]) * c[d];
+                double inv = sq > 0.0 ? 1.0 / std::sqrt(sq) : 0.0;
+                for (int d = 0; d < DIM; ++d) c[d] = static_cast<float>(c[d] * inv);
+                shards[s].bounded = sq > 0.0;
+            }
+        }
+
+        std::vector<std::vector<FeatureVector>> parts(shards.size());
+        for (const auto& vec : data) {
+            int s = route(vec);
+            parts[s].push_back(vec);
+            shards[s].count++;
+            if (policy == ShardPolicy::Spatial) shardOf[vec.image_id] = s;
+        }
+
+        bool ok = true;
+        for (size_t s = 0; s < shards.size(); ++s) {
+            ok = spawn(static_cast<int>(s), parts[s]) && ok;
+            std::vector<FeatureVector>().swap(parts[s]); // o filho já tem a sua cópia
+        }
+        // Os shards constroem em paralelo; o Ping só é respondido depois da construção.
+        WireBuffer empty, reply;
+        for (size_t s = 0; s < shards.size(); ++s) {
+            if (shards[s].alive) ok = call(static_cast<int>(s), WireOp::Ping, empty, reply) && ok;
+        }
+        return ok;
+    }
+
+    void insert(const FeatureVector& vec) override {
+        std::lock_guard<std::mutex> guard(lock);
+        int s = route(vec);
+        WireBuffer body, reply;
+        body.putVector(vec);
+        if (!call(s, WireOp::Insert, body, reply)) return;
+        shards[s].count++;
+        if (policy == ShardPolicy::Spatial) shardOf[vec.image_id] = s;
+    }
+
+    bool remove(int image_id) override {
+        std::lock_guard<std::mutex> guard(lock);
+        int s;
+        auto it = shardOf.end();
+        if (policy == ShardPolicy::Spatial) {
+            it = shardOf.find(image_id);
+            if (it == shardOf.end()) return false;
+            s = it->second;
+        } else {
+            s = hashShard(image_id);
+        }
+        WireBuffer body, reply;
+        body.put<int32_t>(image_id);
+        uint8_t removed = 0;
+        if (!call(s, WireOp::Remove, body, reply) || !reply.get(removed) || !removed) return false;
+        shards[s].count--;
+        if (it != shardOf.end()) shardOf.erase(it);
+        return true;
+    }
+
+    QueryResult query(const FeatureVector& query_vec, int k) override {
+        QueryResult result;
+        if (k <= 0) return result;
+        k = std::min<int>(k, MAX_WIRE_K);
+        std::lock_guard<std::mutex> guard(lock);
+
+        WireBuffer request;
+        request.put<int32_t>(k);
+        request.putVector(query_vec);
+        std::vector<std::pair<double, FeatureVector>> found;
+
+        // Envia a consulta a todos os 'targets' antes de ler as respostas: os shards buscam em paralelo.
+        auto gather = [&](const std::vector<int>& targets) {
+            std::vector<int> sent;
+            for (int s : targets) {
+                if (sendTo(s, WireOp::Query, request)) sent.push_back(s);
+            }
+            for (int s : sent) {
+                WireBuffer reply;
+                QueryResult part;
+                if (!receiveFrom(s, WireOp::Query, reply)) continue;
+                if (!getQueryReply(reply, part)) {
+                    fail(s);
+                    continue;
+                }
+                result.comparisons += part.comparisons;
+                for (const auto& vec : part.neighbors) found.emplace_back(query_vec.distanceTo(vec), vec);
+            }
+        };
+        auto kth = [&]() {
+            if (found.size() < static_cast<size_t>(k)) return std::numeric_limits<double>::infinity();
+            std::vector<double> d;
+            d.reserve(found.size());
+            for (const auto& f : found) d.push_back(f.first);
+            std::nth_element(d.begin(), d.begin() + (k - 1), d.end());
+            return d[k - 1];
+        };
+
+        std::vector<std::pair<double, int>> candidates; // (limite inferior, shard)
+        float u[DIM];
+        bool zero_query = !unitOf(query_vec, u);
+        for (size_t s = 0; s < shards.size(); ++s) {
+            if (!shards[s].alive || shards[s].count == 0) continue;
+            candidates.emplace_back(lowerBound(static_cast<int>(s), u, zero_query), static_cast<int>(s));
+        }
+
+        if (policy == ShardPolicy::Hash || candidates.size() <= 1) {
+            std::vector<int> all;
+            for (const auto& c : candidates) all.push_back(c.second);
+            gather(all);
+        } else {
+            // O shard mais promissor primeiro; ele define o k-ésimo vizinho que decide quem é pulado.
+            std::sort(candidates.begin(), candidates.end());
+            gather({candidates.front().second});
+            const double limit = kth() + 1e-5; // tolerância ao arredondamento (floats normalizados, acos)
+            std::vector<int> rest;
+            size_t pruned = 0;
+            for (size_t i = 1; i < candidates.size(); ++i) {
+                if (candidates[i].first <= limit) {
+                    rest.push_back(candidates[i].second);
+                } else {
+                    pruned++;
+                }
+            }
+            result.stats.prune(pruned);
+            gather(rest);
+        }
+
+        // Junta os top-k parciais (empates pelo ID, para o resultado não depender da ordem das respostas).
+        std::sort(found.begin(), found.end(), [](const std::pair<double, FeatureVector>& a,
+                                                 const std::pair<double, FeatureVector>& b) {
+            return a.first < b.first || (a.first == b.first && a.second.image_id < b.second.image_id);
+        });
+        size_t keep = std::min(found.size(), static_cast<size_t>(k));
+        result.neighbors.reserve(keep);
+        for (size_t i = 0; i < keep; ++i) result.neighbors.push_back(found[i].second);
+        return result;
+    }
+
+    /**
+     * @details Soma o memoryUsage() de cada shard (pedido pelo socket) ao do coordenador.
+     * O heap medido no processo do coordenador não inclui o dos shards.
+     */
+    MemoryUsage memoryUsage() const override {
+        std::lock_guard<std::mutex> guard(lock);
+        MemoryUsage usage;
+        usage.addObject(sizeof(*this));
+        usage.addVector(shards);
+        usage.addVector(centroids);
+        usage.addMap(shardOf);
+        auto& self = const_cast<ShardedIndex&>(*this); // a conversa com os shards não altera o índice
+        WireBuffer empty;
+        std::vector<int> sent;
+        for (size_t s = 0; s < shards.size(); ++s) {
+            if (self.sendTo(static_cast<int>(s), WireOp::Stats, empty)) sent.push_back(static_cast<int>(s));
+        }
+        for (int s : sent) {
+            WireBuffer reply;
+            uint64_t payload, overhead, slack;
+            if (!self.receiveFrom(s, WireOp::Stats, reply)) continue;
+            if (!reply.get(payload) || !reply.get(overhead) || !reply.get(slack)) continue;
+            usage.payload += payload;
+            usage.overhead += overhead;
+            usage.slack += slack;
+        }
+        return usage;
+    }
+
+    size_t shardCount() const { return shards.size(); }
+
+    // Vetores vivos em cada shard (0 para shards descartados).
+    std::vector<size_t> shardSizes() const {
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<size_t> sizes;
+        for (const Shard& s : shards) sizes.push_back(s.count);
+        return sizes;
+    }
+
+    // true se todos os shards estão respondendo.
+    bool ok() const {
+        std::lock_guard<std::mutex> guard(lock);
+        for (const Shard& s : shards) {
+            if (!s.alive) return false;
+        }
+        return true;
+    }
+};
+
+#endif // SHARDED_INDEX_HPP
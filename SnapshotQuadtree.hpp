@@ -0,0 +1,301 @@
+#ifndef SNAPSHOT_QUADTREE_HPP
+#define SNAPSHOT_QUADTREE_HPP
+
+#include <vector>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <queue>
+#include <limits>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <unordered_map>
+
+#include "DataStructure.hpp"
+#include "EpochReclaimer.hpp"
+#include "Quadtree.hpp" // AABB2D e os limites de QuadNode (CAPACITY, MAX_DEPTH)
+
+/**
+ * @class SnapshotQuadtree
+ * @brief Quadtree que aceita inserções durante as consultas, sem bloqueá-las.
+ * * Os nós publicados nunca são alterados. Uma inserção copia só o caminho da
+ * raiz até a folha (copy-on-write): os nós do caminho são recriados, os demais
+ * são compartilhados com a versão anterior, e a nova raiz é publicada com um
+ * único store atômico. Cada consulta lê a raiz uma vez e percorre essa versão
+ * (um snapshot imutável) até o fim, sem locks.
+ *
+ * Os nós substituídos só são liberados quando nenhuma consulta pode mais
+ * estar lendo a versão antiga (reclamação por épocas, ver EpochReclaimer): cada
+ * consulta anuncia a época em que começou antes de ler a raiz, e a escritora
+ * entrega os nós do caminho antigo depois de publicar a nova raiz.
+ *
+ * A remoção usa o mesmo caminho copiado, sem o ponto (irmãs que voltam a caber
+ * numa folha são juntadas). As escritoras são serializadas por um mutex (que
+ * as consultas nunca tocam).
+ * A busca é a mesma da Quadtree (best-first pela caixa (R,G)).
+ */
+class SnapshotQuadtree : public DataStructure {
+private:
+    struct SNode {
+        AABB2D bbox;
+        bool isLeaf = true;
+        std::vector<FeatureVector> pts;
+        std::array<const SNode*, 4> child = {nullptr, nullptr, nullptr, nullptr};
+
+        explicit SNode(const AABB2D& box) : bbox(box) {}
+    };
+
+    std::atomic<const SNode*> root;
+    std::atomic<size_t> count;
+    EpochReclaimer<const SNode> epochs; // retire() protegido por writeLock
+
+    mutable std::mutex writeLock;  // serializa as escritoras
+    std::unordered_map<int, std::pair<double, double>> rgById; // image_id -> (R,G); protegido por writeLock
+
+    // Cria uma subárvore nova com os pontos dados (divide enquanto passar da capacidade).
+    static SNode* makeNode(const AABB2D& box, std::vector<FeatureVector> pts, int depth) {
+        SNode* node = new SNode(box);
+        if (static_cast<int>(pts.size()) <= QuadNode::CAPACITY || depth >= QuadNode::MAX_DEPTH) {
+            node->pts = std::move(pts);
+            return node;
+        }
+        double rMid = box.midR(), gMid = box.midG();
+        const AABB2D boxes[4] = {AABB2D(box.minR, rMid, gMid, box.maxG), AABB2D(rMid, box.maxR, gMid, box.maxG),
+                                 AABB2D(box.minR, rMid, box.minG, gMid), AABB2D(rMid, box.maxR, box.minG, gMid)};
+        std::array<std::vector<FeatureVector>, 4> parts;
+        for (const auto& p : pts) parts[QuadNode::quadrantOf(p[0], p[1], rMid, gMid)].push_back(p);
+        node->isLeaf = false;
+        for (int q = 0; q < 4; ++q) node->child[q] = makeNode(boxes[q], std::move(parts[q]), depth + 1);
+        return node;
+    }
+
+    // Copia o caminho até a folha de 'vec'; os nós substituídos vão para 'garbage'.
+    static const SNode* insertCopy(const SNode* node, const FeatureVector& vec, int depth,
+                                   std::vector<const SNode*>& garbage) {
+        garbage.push_back(node);
+        if (node->isLeaf) {
+            std::vector<FeatureVector> pts = node->pts;
+            pts.push_back(vec);
+            return makeNode(node->bbox, std::move(pts), depth);
+        }
+        SNode* copy = new SNode(*node);
+        int q = QuadNode::quadrantOf(vec[0], vec[1], node->bbox.midR(), node->bbox.midG());
+        copy->child[q] = insertCopy(node->child[q], vec, depth + 1, garbage);
+        return copy;
+    }
+
+    // Copia o caminho até a folha do ponto, sem ele; nullptr se o ponto não está na subárvore.
+    // Irmãs que voltam a caber numa folha são juntadas (a cópia do pai nunca é publicada).
+    static const SNode* removeCopy(const SNode* node, int image_id, double r, double g,
+                                   std::vector<const SNode*>& garbage) {
+        if (node->isLeaf) {
+            auto it = std::find_if(node->pts.begin(), node->pts.end(),
+                                   [image_id](const FeatureVector& p) { return p.image_id == image_id; });
+            if (it == node->pts.end()) return nullptr;
+            SNode* copy = new SNode(node->bbox);
+            copy->pts.reserve(node->pts.size() - 1);
+            copy->pts.insert(copy->pts.end(), node->pts.begin(), it);
+            copy->pts.insert(copy->pts.end(), it + 1, node->pts.end());
+            garbage.push_back(node);
+            return copy;
+        }
+        for (int q = 0; q < 4; ++q) {
+            if (!node->child[q]->bbox.contains(r, g)) continue; // um ponto na borda pode estar em mais de uma caixa
+            const SNode* replaced = removeCopy(node->child[q], image_id, r, g, garbage);
+            if (!replaced) continue;
+            garbage.push_back(node);
+
+            size_t total = 0;
+            bool leaves = true;
+            for (int c = 0; c < 4; ++c) {
+                const SNode* ch = (c == q) ? replaced : node->child[c];
+                leaves = leaves && ch->isLeaf;
+                total += ch->pts.size();
+            }
+            if (!leaves || total > static_cast<size_t>(QuadNode::CAPACITY)) {
+                SNode* copy = new SNode(*node);
+                copy->child[q] = replaced;
+                return copy;
+            }
+            SNode* merged = new SNode(node->bbox);
+            for (int c = 0; c < 4; ++c) {
+                const SNode* ch = (c == q) ? replaced : node->child[c];
+                merged->pts.insert(merged->pts.end(), ch->pts.begin(), ch->pts.end());
+                garbage.push_back(ch);
+            }
+            return merged;
+        }
+        return nullptr;
+    }
+
+    // Nova raiz que cobre (r, g); a raiz antiga vira um filho (compartilhado, não é retirada).
+    static const SNode* grow(const SNode* old, double r, double g) {
+        while (!old->bbox.contains(r, g)) {
+            AABB2D oldBox = old->bbox;
+            AABB2D newBox = oldBox;
+            if (r < oldBox.minR) newBox.minR = oldBox.minR - (oldBox.maxR - oldBox.minR);
+            else if (r > oldBox.maxR) newBox.maxR = oldBox.maxR + (oldBox.maxR - oldBox.minR);
+            if (g < oldBox.minG) newBox.minG = oldBox.minG - (oldBox.maxG - oldBox.minG);
+            else if (g > oldBox.maxG) newBox.maxG = oldBox.maxG + (oldBox.maxG - oldBox.minG);
+
+            SNode* top = makeNode(newBox, {}, 0);
+            double rMid = newBox.midR(), gMid = newBox.midG();
+            const AABB2D boxes[4] = {AABB2D(newBox.minR, rMid, gMid, newBox.maxG), AABB2D(rMid, newBox.maxR, gMid, newBox.maxG),
+                                     AABB2D(newBox.minR, rMid, newBox.minG, gMid), AABB2D(rMid, newBox.maxR, newBox.minG, gMid)};
+            int qOld = QuadNode::quadrantOf(oldBox.midR(), oldBox.midG(), rMid, gMid);
+            top->isLeaf = false;
+            for (int q = 0; q < 4; ++q) top->child[q] = (q == qOld) ? old : new SNode(boxes[q]);
+            old = top;
+        }
+        return old;
+    }
+
+    static void destroy(const SNode* node) {
+        if (!node) return;
+        for (const SNode* ch : node->child) destroy(ch);
+        delete node;
+    }
+
+    static size_t nodeUsage(const SNode* node, MemoryUsage& usage) {
+        if (!node) return 0;
+        usage.addBlock(node, sizeof(SNode), sizeof(SNode));
+        usage.addVector(node->pts);
+        size_t n = node->pts.size();
+        for (const SNode* ch : node->child) n += nodeUsage(ch, usage);
+        return n;
+    }
+
+public:
+    SnapshotQuadtree(double rMin = 0.0, double rMax = 255.0, double gMin = 0.0, double gMax = 255.0)
+        : root(new SNode(AABB2D(rMin, rMax, gMin, gMax))), count(0) {}
+
+    ~SnapshotQuadtree() override {
+        // Os nós retirados (liberados por 'epochs') não são alcançáveis pela raiz atual, então cada nó é liberado uma vez.
+        destroy(root.load());
+    }
+
+    SnapshotQuadtree(const SnapshotQuadtree&) = delete;
+    SnapshotQuadtree& operator=(const SnapshotQuadtree&) = delete;
+
+    // Pode ser chamada por várias threads (elas se revezam), junto com query().
+    void insert(const FeatureVector& vec) override {
+        std::lock_guard<std::mutex> guard(writeLock);
+        std::vector<const SNode*> garbage;
+        const SNode* base = grow(root.load(std::memory_order_relaxed), vec[0], vec[1]);
+        root.store(insertCopy(base, vec, 0, garbage)); // seq_cst
+        rgById[vec.image_id] = {vec[0], vec[1]};
+        count.fetch_add(1, std::memory_order_relaxed);
+        epochs.retire(std::move(garbage));
+    }
+
+    // Mesma publicação da inserção: a nova raiz não tem o ponto; as consultas em andamento ainda o veem.
+    bool remove(int image_id) override {
+        std::lock_guard<std::mutex> guard(writeLock);
+        auto it = rgById.find(image_id);
+        if (it == rgById.end()) return false;
+        std::vector<const SNode*> garbage;
+        const SNode* next = removeCopy(root.load(std::memory_order_relaxed), image_id, it->second.first,
+                                       it->second.second, garbage);
+        rgById.erase(it);
+        if (!next) return false;
+        root.store(next); // seq_cst
+        count.fetch_sub(1, std::memory_order_relaxed);
+        epochs.retire(std::move(garbage));
+        return true;
+    }
+
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+    // true se o vetor (mesmo image_id) está na folha do seu (R,G) na versão atual.
+    bool contains(const FeatureVector& vec) {
+        auto* slot = epochs.enterRead();
+        const SNode* node = root.load();
+        while (node && !node->isLeaf) {
+            node = node->child[QuadNode::quadrantOf(vec[0], vec[1], node->bbox.midR(), node->bbox.midG())];
+        }
+        bool found = false;
+        if (node) {
+            for (const auto& p : node->pts) found = found || p.image_id == vec.image_id;
+        }
+        epochs.exitRead(slot);
+        return found;
+    }
+
+    // Pode ser chamada por várias threads, junto com insert().
+    QueryResult query(const FeatureVector& query_vec, int k) override {
+        QueryResult result;
+        if (k <= 0) return result;
+
+        auto* slot = epochs.enterRead();
+        const SNode* snapshot = root.load();
+
+        using Pair = std::pair<double, const FeatureVector*>;
+        std::priority_queue<Pair> best; // max-heap dos k melhores
+        using Entry = std::pair<double, const SNode*>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> fringe;
+        fringe.emplace(snapshot->bbox.minDistRG(query_vec[0], query_vec[1]), snapshot);
+        result.stats.fringeSize(1);
+
+        double worstBest = std::numeric_limits<double>::infinity();
+        while (!fringe.empty()) {
+            Entry cur = fringe.top(); fringe.pop();
+            if (best.size() == static_cast<size_t>(k) && cur.first >= worstBest) {
+                result.stats.prune(fringe.size() + 1);
+                break;
+            }
+            const SNode* node = cur.second;
+            result.stats.touch(sizeof(SNode));
+            if (node->isLeaf) {
+                result.stats.scanLeaf();
+                result.stats.touch(node->pts.size() * sizeof(FeatureVector));
+                for (const auto& p : node->pts) {
+                    double dist = query_vec.distanceTo(p);
+                    result.comparisons++;
+                    if (best.size() < static_cast<size_t>(k)) {
+                        best.emplace(dist, &p);
+                        if (best.size() == static_cast<size_t>(k)) worstBest = best.top().first;
+                    } else if (dist < best.top().first) {
+                        best.pop();
+                        best.emplace(dist, &p);
+                        worstBest = best.top().first;
+                    }
+                }
+            } else {
+                result.stats.expandNode();
+                for (const SNode* ch : node->child) {
+                    double b = ch->bbox.minDistRG(query_vec[0], query_vec[1]);
+                    if (best.size() == static_cast<size_t>(k) && b >= worstBest) {
+                        result.stats.prune();
+                        continue;
+                    }
+                    fringe.emplace(b, ch);
+                }
+                result.stats.fringeSize(fringe.size());
+            }
+        }
+
+        result.neighbors.resize(best.size());
+        for (size_t i = best.size(); i-- > 0; best.pop()) result.neighbors[i] = *best.top().second;
+        epochs.exitRead(slot); // os vizinhos já foram copiados; o snapshot pode ser liberado
+        return result;
+    }
+
+    // Versão atual mais os nós retirados que ainda esperam a liberação (contados como overhead).
+    MemoryUsage memoryUsage() const override {
+        std::lock_guard<std::mutex> guard(writeLock);
+        MemoryUsage usage;
+        usage.addObject(sizeof(*this));
+        usage.addMap(rgById);
+        usage.countVectors(nodeUsage(root.load(), usage));
+        epochs.forEachRetired([&usage](const std::vector<const SNode*>& batch) {
+            for (const SNode* n : batch) {
+                usage.addBlock(n, sizeof(SNode), sizeof(SNode));
+                usage.addVector(n->pts);
+            }
+        });
+        return usage;
+    }
+};
+
+#endif // SNAPSHOT_QUADTREE_HPP
@@ -0,0 +1,115 @@
+#ifndef SPACE_FILLING_CURVE_HPP
+#define SPACE_FILLING_CURVE_HPP
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#include "Vector.hpp"
+
+/**
+ * Ordem de armazenamento dos vetores ao construir uma estrutura.
+ * - None: a ordem de inserção (a do arquivo).
+ * - Morton: curva Z, que intercala os bits das coordenadas.
+ * - Hilbert: curva de Hilbert; como a Morton, mas dois vizinhos na curva são
+ *   sempre vizinhos no espaço (a Z dá saltos entre os quadrantes).
+ * Os valores são os do parâmetro 'curve' do catálogo (0, 1, 2).
+ */
+enum class CurveOrder { None = 0, Morton = 1, Hilbert = 2 };
+
+inline const char* curveName(CurveOrder order) {
+    switch (order) {
+        case CurveOrder::Morton: return "morton";
+        case CurveOrder::Hilbert: return "hilbert";
+        default: return "insercao";
+    }
+}
+
+namespace curve {
+// A curva percorre os CURVE_DIMS primeiros componentes (todos no RGB; os 8 primeiros bins de um
+// histograma), com BITS bits por componente, para que a chave caiba em 64 bits (e cada coordenada em 32).
+constexpr int CURVE_DIMS = FeatureVector::DIM < 8 ? FeatureVector::DIM : 8;
+constexpr int BITS = 63 / CURVE_DIMS < 31 ? 63 / CURVE_DIMS : 31;
+
+// Transforma as coordenadas na forma "transposta" do índice de Hilbert (algoritmo de Skilling, 2004).
+inline void hilbertTranspose(uint32_t* x, int n, int bits) {
+    const uint32_t top = 1u << (bits - 1);
+    for (uint32_t q = top; q > 1; q >>= 1) {
+        uint32_t p = q - 1;
+        for (int i = 0; i < n; ++i) {
+            // Sem desvio: se o bit q de x[i] está ligado, inverte os bits baixos de x[0]; senão troca-os com os de x[i].
+            uint32_t on = 0u - ((x[i] & q) != 0);
+            uint32_t t = (x[0] ^ x[i]) & p & ~on;
+            x[0] ^= (p & on) | t;
+            x[i] ^= t;
+        }
+    }
+    for (int i = 1; i < n; ++i) x[i] ^= x[i - 1];
+    uint32_t t = 0;
+    for (uint32_t q = top; q > 1; q >>= 1) {
+        if (x[n - 1] & q) t ^= q - 1;
+    }
+    for (int i = 0; i < n; ++i) x[i] ^= t;
+}
+}
+
+/**
+ * @brief Posição do vetor na curva, sobre o espaço de cores normalizado.
+ * @details O vetor é dividido pela norma (a distância do cosseno só vê a
+ * direção), cada componente em [0, 1] vira um inteiro de BITS bits e os bits
+ * das coordenadas são intercalados, do mais significativo para o menos.
+ */
+inline uint64_t curveKey(const FeatureVector& vec, CurveOrder order) {
+    if (order == CurveOrder::None) return 0;
+    double sq = 0.0;
+    for (int d = 0; d < FeatureVector::DIM; ++d) sq += static_cast<double>(vec[d]) * static_cast<double>(vec[d]);
+    double inv = sq > 0.0 ? 1.0 / std::sqrt(sq) : 0.0;
+    const double scale = static_cast<double>((1u << curve::BITS) - 1);
+    uint32_t x[curve::CURVE_DIMS];
+    for (int d = 0; d < curve::CURVE_DIMS; ++d) {
+        double c = std::min(1.0, std::max(0.0, static_cast<double>(vec[d]) * inv));
+        x[d] = static_cast<uint32_t>(std::lround(c * scale));
+    }
+    if (order == CurveOrder::Hilbert) curve::hilbertTranspose(x, curve::CURVE_DIMS, curve::BITS);
+
+    uint64_t key = 0;
+    for (int b = curve::BITS - 1; b >= 0; --b) {
+        for (int d = 0; d < curve::CURVE_DIMS; ++d) key = (key << 1) | ((x[d] >> b) & 1u);
+    }
+    return key;
+}
+
+/**
+ * @brief Permutação que põe os vetores na ordem da curva (empates pela ordem original).
+ */
+inline std::vector<size_t> curvePermutation(const std::vector<FeatureVector>& data, CurveOrder order) {
+    std::vector<size_t> perm(data.size());
+    std::iota(perm.begin(), perm.end(), 0);
+    if (order == CurveOrder::None) return perm;
+    // Ordenar os pares (chave, posição) contíguos é mais rápido que ordenar índices que apontam para as chaves.
+    std::vector<std::pair<uint64_t, size_t>> keyed(data.size());
+    for (size_t i = 0; i < data.size(); ++i) keyed[i] = {curveKey(data[i], order), i};
+    std::sort(keyed.begin(), keyed.end());
+    for (size_t i = 0; i < keyed.size(); ++i) perm[i] = keyed[i].second;
+    return perm;
+}
+
+/**
+ * @brief Os vetores na ordem da curva, para inserir numa estrutura.
+ * @details Com CurveOrder::None devolve o próprio 'data', sem cópia; senão
+ * preenche 'sorted' e devolve uma referência a ele.
+ */
+inline const std::vector<FeatureVector>& curveOrdered(const std::vector<FeatureVector>& data, CurveOrder order,
+                                                      std::vector<FeatureVector>& sorted) {
+    if (order == CurveOrder::None) return data;
+    std::vector<size_t> perm = curvePermutation(data, order);
+    sorted.clear();
+    sorted.reserve(data.size());
+    for (size_t i : perm) sorted.push_back(data[i]);
+    return sorted;
+}
+
+#endif // SPACE_FILLING_CURVE_HPP
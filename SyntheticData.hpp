@@ -0,0 +1,199 @@
+#ifndef SYNTHETIC_DATA_HPP
+#define SYNTHETIC_DATA_HPP
+
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "Vector.hpp"
+#include "DatasetIO.hpp"
+
+/**
+ * @brief Gera um conjunto de dados sintético agrupado (mistura de gaussianas).
+ * @details Os centros são sorteados uniformemente em [0, max_value] em cada
+ * dimensão e cada ponto é um centro mais ruído gaussiano de desvio 'spread',
+ * limitado à faixa [0, max_value] (componentes de cor não são negativos).
+ * Serve para comparar as estruturas em dados com vizinhanças densas, onde a
+ * poda faz mais diferença do que em dados uniformes.
+ * @param n Número de vetores.
+ * @param clusters Número de grupos.
+ * @param spread Desvio padrão do ruído em torno de cada centro.
+ * @param max_value Maior valor de um componente (255 para RGB, 1 para histogramas).
+ * @param seed Semente, para que o conjunto seja reprodutível.
+ * @param first_id ID da primeira imagem sintética.
+ */
+inline std::vector<FeatureVector> clusteredDataset(size_t n, int clusters, double spread,
+                                                   double max_value = 255.0, unsigned seed = 42,
+                                                   int first_id = 0) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, max_value);
+    std::normal_distribution<double> noise(0.0, spread);
+
+    clusters = std::max(1, clusters);
+    std::vector<FeatureVector> centers(clusters);
+    for (auto& c : centers) {
+        for (int d = 0; d < FeatureVector::DIM; ++d) c[d] = static_cast<FeatureVector::ScalarType>(uniform(rng));
+    }
+
+    std::vector<FeatureVector> data(n);
+    std::uniform_int_distribution<int> pick(0, clusters - 1);
+    for (size_t i = 0; i < n; ++i) {
+        const FeatureVector& c = centers[pick(rng)];
+        for (int d = 0; d < FeatureVector::DIM; ++d) {
+            double x = static_cast<double>(c[d]) + noise(rng);
+            data[i][d] = static_cast<FeatureVector::ScalarType>(std::min(max_value, std::max(0.0, x)));
+        }
+        data[i].image_id = first_id + static_cast<int>(i);
+    }
+    return data;
+}
+
+/**
+ * @brief Distribuições do gerador de datasets grandes (generate_dataset).
+ * - Uniform: componentes uniformes em [0, max_value].
+ * - Clusters: mistura de gaussianas com grupos equiprováveis (como clusteredDataset).
+ * - Skewed: grupos escolhidos por uma lei de Zipf e uma fração de cópias exatas
+ *   de vetores "populares", como fotos repetidas num catálogo real.
+ * - Adversarial: os dois primeiros componentes (R e G) são iguais em todos os
+ *   vetores e os demais variam numa faixa menor que um bin da Hash. A Quadtree,
+ *   que divide só por (R,G), desce até a profundidade máxima e acaba numa única
+ *   folha enorme; a Hash concentra tudo em poucos buckets por tabela.
+ */
+enum class Distribution { Uniform, Clusters, Skewed, Adversarial };
+
+inline const char* distributionName(Distribution dist) {
+    switch (dist) {
+        case Distribution::Uniform: return "uniform";
+        case Distribution::Clusters: return "clusters";
+        case Distribution::Skewed: return "skewed";
+        case Distribution::Adversarial: return "adversarial";
+    }
+    return "?";
+}
+
+// Retorna false se o nome não for de uma distribuição conhecida.
+inline bool parseDistribution(const std::string& name, Distribution& dist) {
+    for (Distribution d : {Distribution::Uniform, Distribution::Clusters, Distribution::Skewed, Distribution::Adversarial}) {
+        if (name == distributionName(d)) {
+            dist = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @class SyntheticGenerator
+ * @brief Gera vetores sintéticos um a um, sem guardar o conjunto na memória.
+ * @details A dimensão é dada em tempo de execução. Com a mesma semente e os
+ * mesmos parâmetros, a sequência gerada é sempre a mesma.
+ */
+class SyntheticGenerator {
+public:
+    /**
+     * @param dim Número de componentes por vetor.
+     * @param max_value Maior valor de um componente (255 para RGB, 1 para histogramas).
+     * @param clusters Número de grupos (Clusters e Skewed).
+     * @param spread Desvio padrão do ruído em torno de cada centro, como fração de max_value.
+     * @param duplicates Fração de cópias exatas no Skewed.
+     */
+    SyntheticGenerator(Distribution dist, int dim, double max_value, int clusters, double spread,
+                       double duplicates, unsigned seed)
+        : dist(dist), dim(dim), maxValue(max_value), duplicates(duplicates), rng(seed),
+          uniform(0.0, 1.0), noise(0.0, spread * max_value) {
+        clusters = std::max(1, clusters);
+        centers.resize(static_cast<size_t>(clusters) * dim);
+        for (double& c : centers) c = uniform(rng) * maxValue;
+        if (dist == Distribution::Skewed) {
+            clusterCdf = zipfCdf(clusters, 1.1);
+            hotCdf = zipfCdf(HOT_VECTORS, 1.1);
+        }
+    }
+
+    // Escreve o próximo vetor em out[0, dim).
+    void next(double* out) {
+        switch (dist) {
+            case Distribution::Uniform:
+                for (int d = 0; d < dim; ++d) out[d] = uniform(rng) * maxValue;
+                break;
+            case Distribution::Clusters:
+                aroundCenter(std::uniform_int_distribution<size_t>(0, centers.size() / dim - 1)(rng), out);
+                break;
+            case Distribution::Skewed:
+                // Os primeiros HOT_VECTORS vetores formam o conjunto "popular" que é repetido depois.
+                if (hot.size() == static_cast<size_t>(HOT_VECTORS) * dim && uniform(rng) < duplicates) {
+                    const double* src = &hot[sampleCdf(hotCdf) * dim];
+                    std::copy(src, src + dim, out);
+                } else {
+                    aroundCenter(sampleCdf(clusterCdf), out);
+                    if (hot.size() < static_cast<size_t>(HOT_VECTORS) * dim) hot.insert(hot.end(), out, out + dim);
+                }
+                break;
+            case Distribution::Adversarial:
+                for (int d = 0; d < dim; ++d) {
+                    out[d] = 0.5 * maxValue + (d < 2 ? 0.0 : uniform(rng) * ADVERSARIAL_BAND * maxValue);
+                }
+                break;
+        }
+    }
+
+private:
+    static constexpr int HOT_VECTORS = 1024;
+    // Largura da faixa do Adversarial: 10.2 no RGB e 0.04 nos histogramas, menor que o bin da Hash (25 e 0.05).
+    static constexpr double ADVERSARIAL_BAND = 0.04;
+
+    Distribution dist;
+    int dim;
+    double maxValue;
+    double duplicates;
+    std::mt19937_64 rng;
+    std::uniform_real_distribution<double> uniform;
+    std::normal_distribution<double> noise;
+    std::vector<double> centers;     // clusters * dim
+    std::vector<double> clusterCdf;  // Skewed: probabilidade acumulada de cada grupo
+    std::vector<double> hotCdf;      // Skewed: probabilidade acumulada de cada vetor popular
+    std::vector<double> hot;         // Skewed: vetores populares (HOT_VECTORS * dim)
+
+    // Probabilidade acumulada de uma lei de Zipf com expoente s sobre n itens.
+    static std::vector<double> zipfCdf(int n, double s) {
+        std::vector<double> cdf(n);
+        double sum = 0.0;
+        for (int i = 0; i < n; ++i) cdf[i] = (sum += 1.0 / std::pow(i + 1, s));
+        for (double& c : cdf) c /= sum;
+        return cdf;
+    }
+
+    size_t sampleCdf(const std::vector<double>& cdf) {
+        size_t i = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+        return std::min(i, cdf.size() - 1);
+    }
+
+    void aroundCenter(size_t c, double* out) {
+        for (int d = 0; d < dim; ++d) {
+            out[d] = std::min(maxValue, std::max(0.0, centers[c * dim + d] + noise(rng)));
+        }
+    }
+};
+
+/**
+ * @brief Carrega o dataset pedido: um arquivo, ou "sintetico:N[:grupos]" para dados agrupados gerados na hora.
+ * @details Lança std::invalid_argument / std::out_of_range se N ou grupos não forem números.
+ */
+inline std::vector<FeatureVector> loadInput(const std::string& spec, double value_max) {
+    const std::string prefix = "sintetico:";
+    if (spec.rfind(prefix, 0) == 0) {
+        std::vector<std::string> parts;
+        std::stringstream ss(spec.substr(prefix.size()));
+        std::string item;
+        while (std::getline(ss, item, ':')) parts.push_back(item);
+        size_t n = parts.size() > 0 ? std::stoul(parts[0]) : 20000;
+        int clusters = parts.size() > 1 ? std::stoi(parts[1]) : 50;
+        return clusteredDataset(n, clusters, 0.02 * value_max, value_max);
+    }
+    return loadDataset(spec);
+}
+
+#endif // SYNTHETIC_DATA_HPP
@@ -0,0 +1,286 @@
+#ifndef VP_TREE_HPP
+#define VP_TREE_HPP
+
+#include <vector>
+#include <queue>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <tuple>
+#include <unordered_map>
+
+#include "DataStructure.hpp"
+
+/**
+ * @brief Distância angular normalizada: acos(similaridade de cosseno) / pi, entre 0 e 1.
+ * @details Ao contrário da distância do cosseno (1 - cos), o ângulo satisfaz a
+ * desigualdade triangular, o que permite podar uma árvore métrica. Como é uma
+ * função crescente de distanceTo, ordena os vizinhos da mesma forma.
+ */
+inline double angularDistance(double cosine_distance) {
+    double sim = std::max(-1.0, std::min(1.0, 1.0 - cosine_distance));
+    return std::acos(sim) / M_PI;
+}
+
+/**
+ * @class VPTree
+ * @brief Árvore de pontos de vantagem (vantage-point tree) sobre a distância angular.
+ * * Cada nó escolhe um ponto de vantagem e separa os demais pela mediana 'mu'
+ * das distâncias até ele: os mais próximos vão para o filho interno e os mais
+ * distantes para o externo. Cada filho guarda a faixa [lo, hi] das distâncias
+ * dos seus pontos ao ponto de vantagem do pai, e pela desigualdade triangular
+ * nenhum ponto do filho está a menos de max(lo - d, d - hi, 0) da consulta,
+ * onde d é a distância da consulta ao ponto de vantagem.
+ *
+ * A busca é best-first: os nós são visitados em ordem desse limite inferior e
+ * a busca para quando o próximo limite já é maior que o k-ésimo vizinho atual.
+ * Diferente da caixa euclidiana da Quadtree, a poda usa a própria métrica da
+ * consulta, então o resultado é exato.
+ *
+ * Inserções seguem o esquema logarítmico (Bentley-Saxe): vão para um
+ * transbordo de no máximo BUFFER_SIZE pontos, varrido linearmente; quando ele
+ * enche, vira uma árvore nova junto com as árvores existentes de até
+ * MERGE_FACTOR vezes o seu tamanho. Assim há O(log n) árvores, a consulta
+ * percorre todas com uma única fila best-first e não fica mais lenta conforme
+ * as inserções se acumulam. Cada ponto é reconstruído O(log n) vezes: a
+ * inserção custa O(log² n) amortizado.
+ * Remoções viram tombstones: o ponto continua servindo de ponto de vantagem e
+ * nas faixas de distância, que seguem válidas, mas não entra no resultado.
+ * Quando os apagados passam de MAX_DEAD_FRACTION do total, a própria remoção
+ * reconstrói tudo numa árvore só (O(n log n), O(log n) amortizado).
+ */
+class VPTree : public DataStructure {
+private:
+    static constexpr int LEAF_SIZE = 8;       // pontos em um nó folha (varridos linearmente)
+    static constexpr size_t BUFFER_SIZE = 64; // pontos no transbordo antes de virarem uma árvore
+    static constexpr size_t MERGE_FACTOR = 4; // mais árvores juntas por fusão: menos árvores por consulta
+
+    struct VPNode {
+        int begin, end;     // faixa em 'order' coberta pelo nó (order[begin] é o ponto de vantagem)
+        int inside = -1;    // filho com distância <= mu
+        int outside = -1;   // filho com distância > mu
+        double in_lo = 0.0, in_hi = 0.0;
+        double out_lo = 0.0, out_hi = 0.0;
+    };
+
+    struct Tree {
+        std::vector<int> order;    // índices de 'points' na ordem da árvore
+        std::vector<VPNode> nodes;
+    };
+
+    std::vector<FeatureVector> points; // points[0, treeSize) estão nas árvores; o resto é o transbordo
+    size_t treeSize = 0;
+    std::vector<Tree> trees;           // em ordem decrescente de tamanho
+    std::vector<uint8_t> dead;              // dead[i] = 1 se points[i] foi removido
+    size_t deadCount = 0;
+    std::unordered_map<int, int> slotById;  // image_id -> posição em 'points'
+    std::vector<double> scratch;            // distâncias ao ponto de vantagem durante a construção
+    unsigned seed;
+
+    double dist(const FeatureVector& a, const FeatureVector& b) const {
+        return angularDistance(a.distanceTo(b));
+    }
+
+    // Constrói o nó que cobre t.order[begin, end) e devolve o seu índice em t.nodes.
+    int buildRec(Tree& t, int begin, int end, std::vector<double>& d, std::mt19937& rng) {
+        std::vector<int>& order = t.order;
+        int id = static_cast<int>(t.nodes.size());
+        t.nodes.push_back(VPNode{begin, end});
+        if (end - begin <= LEAF_SIZE) return id;
+
+        // Ponto de vantagem aleatório, movido para o início da faixa.
+        int pick = std::uniform_int_distribution<int>(begin, end - 1)(rng);
+        std::swap(order[begin], order[pick]);
+        const FeatureVector& vp = points[order[begin]];
+        for (int i = begin + 1; i < end; ++i) d[order[i]] = dist(vp, points[order[i]]);
+
+        // Divide pela mediana das distâncias.
+        int mid = begin + 1 + (end - begin - 1) / 2;
+        std::nth_element(order.begin() + begin + 1, order.begin() + mid, order.begin() + end,
+                         [&d](int a, int b) { return d[a] < d[b]; });
+
+        auto range = [&](int from, int to, double& lo, double& hi) {
+            lo = std::numeric_limits<double>::infinity();
+            hi = 0.0;
+            for (int i = from; i < to; ++i) {
+                lo = std::min(lo, d[order[i]]);
+                hi = std::max(hi, d[order[i]]);
+            }
+        };
+        double in_lo, in_hi, out_lo, out_hi;
+        range(begin + 1, mid, in_lo, in_hi);
+        range(mid, end, out_lo, out_hi);
+
+        int inside = buildRec(t, begin + 1, mid, d, rng);
+        int outside = buildRec(t, mid, end, d, rng);
+        VPNode& node = t.nodes[id];
+        node.inside = inside;
+        node.outside = outside;
+        node.in_lo = in_lo;
+        node.in_hi = in_hi;
+        node.out_lo = out_lo;
+        node.out_hi = out_hi;
+        return id;
+    }
+
+    // Árvore sobre os pontos de 'order' (índices de 'points').
+    Tree buildTree(std::vector<int> order) {
+        Tree t;
+        t.order = std::move(order);
+        if (!t.order.empty()) {
+            if (scratch.size() < points.size()) scratch.resize(points.size());
+            std::mt19937 rng(seed + static_cast<unsigned>(trees.size()));
+            t.nodes.reserve(2 * t.order.size() / LEAF_SIZE + 1);
+            buildRec(t, 0, static_cast<int>(t.order.size()), scratch, rng);
+        }
+        return t;
+    }
+
+    // O transbordo cheio vira uma árvore, junto com as árvores de até MERGE_FACTOR vezes o tamanho acumulado
+    // (os apagados delas ficam de fora).
+    void flushBuffer() {
+        std::vector<int> run;
+        for (size_t p = treeSize; p < points.size(); ++p) run.push_back(static_cast<int>(p));
+        while (!trees.empty() && trees.back().order.size() <= run.size() * MERGE_FACTOR) {
+            for (int p : trees.back().order) {
+                if (!dead[p]) run.push_back(p);
+            }
+            trees.pop_back();
+        }
+        trees.push_back(buildTree(std::move(run)));
+        treeSize = points.size();
+    }
+
+    // Descarta os apagados e reconstrói tudo numa árvore só.
+    void rebuild() {
+        if (deadCount > 0) {
+            size_t kept = 0;
+            for (size_t i = 0; i < points.size(); ++i) {
+                if (!dead[i]) points[kept++] = points[i];
+            }
+            points.resize(kept);
+        }
+        dead.assign(points.size(), 0);
+        deadCount = 0;
+        slotById.clear();
+        for (size_t i = 0; i < points.size(); ++i) slotById[points[i].image_id] = static_cast<int>(i);
+        trees.clear();
+        std::vector<int> order(points.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+        if (!order.empty()) trees.push_back(buildTree(std::move(order)));
+        treeSize = points.size();
+    }
+
+public:
+    explicit VPTree(unsigned seed = 42) : seed(seed) {}
+
+    ~VPTree() override = default;
+
+    /**
+     * @brief Construção em lote: substitui o conteúdo da árvore por 'data'.
+     */
+    void build(const std::vector<FeatureVector>& data) {
+        points = data;
+        dead.assign(points.size(), 0);
+        deadCount = 0;
+        rebuild();
+    }
+
+    void insert(const FeatureVector& vec) override {
+        slotById[vec.image_id] = static_cast<int>(points.size());
+        points.push_back(vec);
+        dead.push_back(0);
+        if (points.size() - treeSize >= BUFFER_SIZE) flushBuffer();
+    }
+
+    bool remove(int image_id) override {
+        auto it = slotById.find(image_id);
+        if (it == slotById.end()) return false;
+        dead[it->second] = 1;
+        slotById.erase(it);
+        deadCount++;
+        if (compactionDue(deadCount, points.size())) rebuild();
+        return true;
+    }
+
+    QueryResult query(const FeatureVector& query_vec, int k) override {
+        QueryResult result;
+        if (k <= 0 || points.empty()) return result;
+
+        // k melhores até agora (max-heap por distância angular).
+        std::priority_queue<std::pair<double, int>> best;
+        auto consider = [&](int p) {
+            double dq = dist(query_vec, points[p]);
+            result.comparisons++;
+            if (dead[p]) {
+                result.stats.skipDead(); // a distância ainda serve para a poda
+            } else if (static_cast<int>(best.size()) < k) {
+                best.emplace(dq, p);
+            } else if (dq < best.top().first) {
+                best.pop();
+                best.emplace(dq, p);
+            }
+            return dq;
+        };
+        auto kth = [&]() {
+            return static_cast<int>(best.size()) < k ? std::numeric_limits<double>::infinity() : best.top().first;
+        };
+
+        // O transbordo primeiro: os seus vizinhos já apertam a poda das árvores.
+        for (size_t p = treeSize; p < points.size(); ++p) consider(static_cast<int>(p));
+
+        // Uma fila para todas as árvores, ordenada pelo limite inferior da distância (min-heap de (limite, árvore, nó)).
+        using Entry = std::tuple<double, int, int>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> frontier;
+        for (size_t t = 0; t < trees.size(); ++t) {
+            if (!trees[t].nodes.empty()) frontier.emplace(0.0, static_cast<int>(t), 0);
+        }
+        const double slack = 1e-9; // tolerância ao arredondamento do acos
+
+        while (!frontier.empty()) {
+            auto [lb, t, n] = frontier.top();
+            frontier.pop();
+            if (lb > kth() + slack) break;
+
+            const Tree& tree = trees[t];
+            const VPNode& node = tree.nodes[n];
+            if (node.inside < 0) {
+                for (int i = node.begin; i < node.end; ++i) consider(tree.order[i]);
+                continue;
+            }
+
+            double d = consider(tree.order[node.begin]);
+            double lb_in = std::max({0.0, node.in_lo - d, d - node.in_hi});
+            double lb_out = std::max({0.0, node.out_lo - d, d - node.out_hi});
+            if (lb_in <= kth() + slack) frontier.emplace(lb_in, t, node.inside);
+            if (lb_out <= kth() + slack) frontier.emplace(lb_out, t, node.outside);
+        }
+
+        result.neighbors.resize(best.size());
+        for (size_t i = best.size(); i-- > 0; best.pop()) {
+            result.neighbors[i] = points[best.top().second];
+        }
+        return result;
+    }
+
+    MemoryUsage memoryUsage() const override {
+        MemoryUsage usage;
+        usage.addObject(sizeof(*this));
+        usage.addVector(points);
+        usage.addVector(trees);
+        for (const Tree& t : trees) {
+            usage.addVector(t.order);
+            usage.addVector(t.nodes);
+        }
+        usage.addVector(dead);
+        usage.addVector(scratch);
+        usage.addMap(slotById);
+        usage.countVectors(points.size() - deadCount);
+        return usage;
+    }
+};
+
+#endif // VP_TREE_HPP
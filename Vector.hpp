@@ -5,17 +5,83 @@
 
 #include <cmath>      // Para funções matemáticas como sqrt e pow
 #include <iostream>   // Para permitir a impressão (ostream)
+#include <utility>    // std::integer_sequence, usado para desenrolar laços
+#include <type_traits>
+
+// Dimensão dos vetores de características, escolhida em tempo de compilação.
+// 3 = RGB médio (padrão); 64 ou 512 = histogramas de cor gerados por
+// 'create_dataset --hist 64' / '--hist 512' (ex.: g++ -DFEATURE_DIM=64 main.cpp).
+#ifndef FEATURE_DIM
+#define FEATURE_DIM 3
+#endif
+
+// Tipo usado para armazenar cada componente: double (padrão), float ou half.
+// As médias vêm de pixels de 8 bits, então float já preserva toda a informação
+// e reduz pela metade o tráfego de memória (ex.: g++ -DFEATURE_SCALAR=float main.cpp).
+#ifndef FEATURE_SCALAR
+#define FEATURE_SCALAR double
+#endif
+
+#if defined(__FLT16_MAX__)
+// Meia precisão (IEEE binary16), disponível no GCC/Clang para x86-64 e ARM.
+using half = _Float16;
+#endif
+
+/**
+ * @brief Tipo dos acumuladores dos laços de distância para cada tipo de armazenamento.
+ * @details double acumula em double; float e half acumulam em float, que é o tipo
+ * nativo dos registradores SIMD e evita a perda de precisão de somar em half.
+ */
+template <typename Scalar>
+struct AccumulatorOf { using type = float; };
+template <>
+struct AccumulatorOf<double> { using type = double; };
+
+/**
+ * @brief Executa f(std::integral_constant<int, 0>) ... f(std::integral_constant<int, N-1>).
+ * @details Desenrola laços de tamanho fixo em tempo de compilação (fold expression).
+ */
+template <typename F, int... I>
+constexpr void unrollImpl(F&& f, std::integer_sequence<int, I...>) {
+    (f(std::integral_constant<int, I>{}), ...);
+}
+template <int N, typename F>
+constexpr void unroll(F&& f) {
+    unrollImpl(f, std::make_integer_sequence<int, N>{});
+}
 
 /**
- * @struct FeatureVector
- * @brief Representa um único "documento" (neste caso, uma imagem) como um vetor de características.
- * * Para imagens coloridas, usamos os valores médios dos canais Vermelho (R), Verde (G) e Azul (B).
+ * @struct FeatureVectorT
+ * @brief Representa um único "documento" (neste caso, uma imagem) como um vetor de características de dimensão D.
+ * * Com D = 3 os componentes são os valores médios dos canais Vermelho (R), Verde (G) e Azul (B).
+ * Com D maior, cada componente é a fração de pixels em um bin do histograma de cor.
  * Cada vetor também armazena um ID para identificar a imagem original.
+ *
+ * Para D > 4 o armazenamento é preenchido com zeros até um múltiplo de LANES
+ * componentes (32 bytes, um registrador AVX), de modo que os laços de distância
+ * percorram blocos completos de registradores SIMD sem tratamento de sobras.
+ * Os zeros não alteram produtos escalares nem normas.
+ *
+ * @tparam D Número de componentes.
+ * @tparam Scalar Tipo de armazenamento de cada componente (double, float ou half).
  */
-struct FeatureVector {
+template <int D, typename Scalar = double>
+struct FeatureVectorT {
+    static_assert(D > 0, "FeatureVectorT requer ao menos uma dimensao");
+
+    using ScalarType = Scalar;
+    using Accumulator = typename AccumulatorOf<Scalar>::type;
+
+    static constexpr int DIM = D;
+    static constexpr int LANES = static_cast<int>(32 / sizeof(Scalar));
+    static constexpr int PADDED_DIM = (D <= 4) ? D : ((D + LANES - 1) / LANES) * LANES;
+
     // Membros da struct que armazenam os dados do vetor
-    double r, g, b; // Valores médios dos canais de cor (0-255)
-    int image_id;   // Identificador único da imagem
+    Scalar v[PADDED_DIM] = {}; // Componentes (os excedentes a D ficam sempre em zero)
+    int image_id = 0;          // Identificador único da imagem
+
+    Scalar& operator[](int i) { return v[i]; }
+    const Scalar& operator[](int i) const { return v[i]; }
 
     /**
      * @brief Calcula a DISTÂNCIA DO COSSENO entre este vetor e outro.
@@ -25,23 +91,23 @@ struct FeatureVector {
      * @param other O outro FeatureVector para comparar.
      * @return A Distância do Cosseno (double, entre 0 e 2).
      */
-    double distanceTo(const FeatureVector& other) const {
-        // 1. Calcular o produto escalar (dot product)
-        double dot_product = (this->r * other.r) + (this->g * other.g) + (this->b * other.b);
+    double distanceTo(const FeatureVectorT& other) const {
+        // 1. Calcular o produto escalar e as magnitudes (normas) numa única passada
+        Accumulator dot_product, sq_this, sq_other;
+        dotAndNorms(other, dot_product, sq_this, sq_other);
 
-        // 2. Calcular a magnitude (norma) de cada vetor
-        double mag_this = std::sqrt((this->r * this->r) + (this->g * this->g) + (this->b * this->b));
-        double mag_other = std::sqrt((other.r * other.r) + (other.g * other.g) + (other.b * other.b));
+        double mag_this = std::sqrt(static_cast<double>(sq_this));
+        double mag_other = std::sqrt(static_cast<double>(sq_other));
 
         // Evitar divisão por zero se um dos vetores for nulo
         if (mag_this == 0.0 || mag_other == 0.0) {
             return 1.0; // Retorna 1.0 (dissimilaridade neutra) se um vetor for nulo
         }
 
-        // 3. Calcular a similaridade de cosseno
-        double similarity = dot_product / (mag_this * mag_other);
+        // 2. Calcular a similaridade de cosseno
+        double similarity = static_cast<double>(dot_product) / (mag_this * mag_other);
 
-        // 4. Retornar a distância do cosseno
+        // 3. Retornar a distância do cosseno
         return 1.0 - similarity;
     }
 
@@ -53,21 +119,76 @@ struct FeatureVector {
      * @param other O outro FeatureVector para comparar.
      * @return A pontuação de similaridade de cosseno (double).
      */
-    double similarityTo(const FeatureVector& other) const {
+    double similarityTo(const FeatureVectorT& other) const {
         // A similaridade é o inverso da distância do cosseno
         // Similaridade = 1 - Distância
         double dist = distanceTo(other);
         return 1.0 - dist;
     }
+
+private:
+    // Número de blocos de LANES componentes; até este limite o laço é totalmente desenrolado.
+    static constexpr int BLOCKS = PADDED_DIM / LANES;
+    static constexpr int MAX_UNROLLED_BLOCKS = 16;
+
+    // Produto escalar e normas ao quadrado, com laços de tamanho fixo desenrolados
+    // em tempo de compilação para que o compilador vetorize cada bloco de LANES.
+    void dotAndNorms(const FeatureVectorT& other, Accumulator& dot, Accumulator& sq_a, Accumulator& sq_b) const {
+        if constexpr (PADDED_DIM % LANES != 0) {
+            // Vetores pequenos (D <= 4, ex.: RGB): soma direta, totalmente desenrolada.
+            dot = sq_a = sq_b = Accumulator(0);
+            unroll<PADDED_DIM>([&](auto i) {
+                Accumulator x = static_cast<Accumulator>(v[i]);
+                Accumulator y = static_cast<Accumulator>(other.v[i]);
+                dot += x * y;
+                sq_a += x * x;
+                sq_b += y * y;
+            });
+        } else {
+            // Um acumulador por pista: cada bloco de LANES vira um registrador SIMD.
+            Accumulator dp[LANES] = {}, sa[LANES] = {}, sb[LANES] = {};
+            auto block = [&](int base) {
+                unroll<LANES>([&](auto j) {
+                    Accumulator x = static_cast<Accumulator>(v[base + j]);
+                    Accumulator y = static_cast<Accumulator>(other.v[base + j]);
+                    dp[j] += x * y;
+                    sa[j] += x * x;
+                    sb[j] += y * y;
+                });
+            };
+            if constexpr (BLOCKS <= MAX_UNROLLED_BLOCKS) {
+                unroll<BLOCKS>([&](auto b) { block(b * LANES); });
+            } else {
+                for (int b = 0; b < BLOCKS; ++b) block(b * LANES);
+            }
+            dot = sq_a = sq_b = Accumulator(0);
+            unroll<LANES>([&](auto j) {
+                dot += dp[j];
+                sq_a += sa[j];
+                sq_b += sb[j];
+            });
+        }
+    }
 };
 
+// Tipo usado por todas as estruturas e programas do projeto.
+using FeatureVector = FeatureVectorT<FEATURE_DIM, FEATURE_SCALAR>;
+
 /**
  * @brief Sobrecarga do operador de saída (<<) para imprimir um FeatureVector de forma legível.
- * (Esta função não precisa de alterações)
  */
-std::ostream& operator<<(std::ostream& os, const FeatureVector& vec) {
-    os << "Image ID: " << vec.image_id << " (R=" << vec.r << ", G=" << vec.g << ", B=" << vec.b << ")";
+template <int D, typename Scalar>
+inline std::ostream& operator<<(std::ostream& os, const FeatureVectorT<D, Scalar>& vec) {
+    os << "Image ID: " << vec.image_id;
+    if constexpr (D == 3) {
+        os << " (R=" << static_cast<double>(vec[0]) << ", G=" << static_cast<double>(vec[1])
+           << ", B=" << static_cast<double>(vec[2]) << ")";
+    } else {
+        os << " (";
+        for (int i = 0; i < D; ++i) os << (i ? ", " : "") << static_cast<double>(vec[i]);
+        os << ")";
+    }
     return os;
 }
 
-#endif // VECTOR_HPP
\ No newline at end of file
+#endif // VECTOR_HPP
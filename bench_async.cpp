@@ -0,0 +1,170 @@
+// bench_async.cpp
+// ----------------------------------------------------------------------------
+// Benchmark das consultas assíncronas (corrotinas C++20) sobre um índice IVF
+// lido do disco por mmap (DiskIVF.hpp, AsyncQuery.hpp). Grava o índice, tira
+// o arquivo do page cache antes de cada modo (como se ele fosse maior que a
+// memória) e mede, numa única thread de consulta:
+//   - a busca síncrona, que fica bloqueada em cada falta de página;
+//   - a busca síncrona que pede antes a leitura antecipada (madvise) das
+//     listas sondadas, e por isso só espera as páginas uma vez por consulta;
+//   - a busca por corrotinas com 1, 8, 32 e 128 consultas em andamento, em que
+//     as páginas frias são lidas pelas threads de E/S enquanto a thread de
+//     consulta atende as outras;
+//   - as duas com o arquivo já em memória, para mostrar o custo das corrotinas.
+// Confere que:
+//   - toda consulta assíncrona devolve os mesmos vizinhos que a síncrona;
+//   - com nprobe = nlist, as distâncias dos k vizinhos batem com as da busca
+//     exaustiva em memória (o arquivo guarda os vetores sem perda além do float).
+//
+// Compilação: g++ bench_async.cpp -o bench_async -std=c++20 -O2 -pthread
+// Uso: ./bench_async [vetores] [consultas] [nprobe] [arquivo]
+// ----------------------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <cstdio>
+
+#include "AsyncQuery.hpp"
+#include "Benchmark.hpp"     // summarizeLatencies
+#include "SyntheticData.hpp" // clusteredDataset
+
+using Clock = std::chrono::steady_clock;
+
+static bool sameNeighbors(const QueryResult& a, const QueryResult& b) {
+    if (a.neighbors.size() != b.neighbors.size()) return false;
+    for (size_t i = 0; i < a.neighbors.size(); ++i) {
+        if (a.neighbors[i].image_id != b.neighbors[i].image_id) return false;
+    }
+    return true;
+}
+
+// Busca síncrona que pede a leitura antecipada de todas as listas sondadas antes de varrer a primeira.
+static QueryResult queryPrefetched(const DiskIVF& index, const FeatureVector& query_vec, int k) {
+    QueryResult result;
+    float qn[DiskIVF::DIM];
+    normalizeToFloat(query_vec, qn);
+    std::vector<int> lists = index.probe(qn, result);
+    for (int list : lists) index.prefetch(list);
+    CandidateHeap<const char*> heap(static_cast<size_t>(k));
+    for (int list : lists) index.scanList(list, qn, heap, result);
+    result.neighbors = index.collect(heap, k);
+    return result;
+}
+
+static void report(const std::string& mode, double seconds, size_t n, const std::vector<double>& latencies,
+                   const std::string& waits) {
+    LatencyStats s = summarizeLatencies(latencies);
+    std::cout << "   " << mode << " | " << (seconds > 0.0 ? n / seconds : 0.0) << " | " << s.mean << " | " << s.p99
+              << " | " << waits << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t num_queries = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    int nprobe = (argc > 3) ? std::max(1, std::atoi(argv[3])) : 8;
+    std::string path = (argc > 4) ? argv[4] : "bench_async.fvi";
+    const int k = 10;
+    const double value_max = (FeatureVector::DIM == 3) ? 255.0 : 1.0;
+
+    std::vector<FeatureVector> data = clusteredDataset(n, 100, 0.05 * value_max, value_max, 42, 0);
+    std::vector<FeatureVector> queries = clusteredDataset(num_queries, 100, 0.05 * value_max, value_max, 7, -1);
+
+    auto start = Clock::now();
+    if (!writeDiskIVF(path, data, 0)) return 1;
+    DiskIVF index(path, nprobe);
+    if (!index.ok()) return 1;
+    std::cout << ">> indice em disco '" << path << "': " << index.size() << " vetores, " << index.getNlist()
+              << " listas, " << index.fileBytes() / (1024.0 * 1024.0) << " MiB, gravado em "
+              << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms" << std::endl;
+    std::cout << ">> " << num_queries << " consultas, k = " << k << ", nprobe = " << nprobe
+              << ", uma thread de consulta" << std::endl;
+    std::cout << "   modo | consultas/s | media_ms | p99_ms | esperas_de_E/S" << std::endl;
+
+    bool all_ok = true;
+    PageFetcher io(4);
+
+    // Síncrona, com o arquivo fora do page cache.
+    index.dropCache();
+    std::vector<QueryResult> reference(queries.size());
+    std::vector<double> latencies(queries.size());
+    start = Clock::now();
+    for (size_t i = 0; i < queries.size(); ++i) {
+        auto t0 = Clock::now();
+        reference[i] = index.query(queries[i], k);
+        latencies[i] = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    }
+    report("sincrona fria", std::chrono::duration<double>(Clock::now() - start).count(), queries.size(), latencies,
+           "-");
+
+    size_t mismatches = 0;
+    index.dropCache();
+    start = Clock::now();
+    for (size_t i = 0; i < queries.size(); ++i) {
+        auto t0 = Clock::now();
+        QueryResult r = queryPrefetched(index, queries[i], k);
+        latencies[i] = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        mismatches += !sameNeighbors(r, reference[i]);
+    }
+    report("sincrona fria + madvise", std::chrono::duration<double>(Clock::now() - start).count(), queries.size(),
+           latencies, "-");
+
+    // Corrotinas, com o arquivo fora do page cache.
+    for (size_t inflight : {1, 8, 32, 128}) {
+        index.dropCache();
+        uint64_t cold = io.coldFetches();
+        start = Clock::now();
+        std::vector<QueryResult> results = runAsyncQueries(index, io, queries, k, inflight, &latencies);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        report("corrotinas fria x" + std::to_string(inflight), seconds, queries.size(), latencies,
+               std::to_string(io.coldFetches() - cold));
+        for (size_t i = 0; i < queries.size(); ++i) mismatches += !sameNeighbors(results[i], reference[i]);
+    }
+
+    // Arquivo já em memória: a diferença é o custo de criar e escalonar as corrotinas.
+    start = Clock::now();
+    for (size_t i = 0; i < queries.size(); ++i) {
+        auto t0 = Clock::now();
+        index.query(queries[i], k);
+        latencies[i] = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    }
+    report("sincrona quente", std::chrono::duration<double>(Clock::now() - start).count(), queries.size(),
+           latencies, "-");
+    uint64_t cold = io.coldFetches();
+    start = Clock::now();
+    std::vector<QueryResult> warm = runAsyncQueries(index, io, queries, k, 32, &latencies);
+    report("corrotinas quente x32", std::chrono::duration<double>(Clock::now() - start).count(), queries.size(),
+           latencies, std::to_string(io.coldFetches() - cold));
+    for (size_t i = 0; i < queries.size(); ++i) mismatches += !sameNeighbors(warm[i], reference[i]);
+
+    std::cout << ">> consultas com madvise ou assincronas diferentes da sincrona: " << mismatches << std::endl;
+    all_ok = all_ok && mismatches == 0;
+
+    // Varredura de todas as listas == busca exaustiva em memória.
+    index.setNprobe(index.getNlist());
+    size_t inexact = 0;
+    size_t checks = std::min<size_t>(queries.size(), 20);
+    for (size_t i = 0; i < checks; ++i) {
+        QueryResult r = index.query(queries[i], k);
+        std::vector<double> exact;
+        exact.reserve(data.size());
+        for (const auto& vec : data) exact.push_back(queries[i].distanceTo(vec));
+        std::partial_sort(exact.begin(), exact.begin() + std::min<size_t>(k, exact.size()), exact.end());
+        bool same = r.neighbors.size() == std::min<size_t>(k, data.size());
+        for (size_t j = 0; same && j < r.neighbors.size(); ++j) {
+            same = std::fabs(queries[i].distanceTo(r.neighbors[j]) - exact[j]) < 1e-4;
+        }
+        inexact += !same;
+    }
+    std::cout << ">> nprobe = nlist: " << inexact << " de " << checks << " consultas diferentes da busca exaustiva"
+              << std::endl;
+    all_ok = all_ok && inexact == 0;
+
+    std::remove(path.c_str());
+    std::cout << (all_ok ? ">> OK" : ">> FALHOU") << std::endl;
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+// bench_cache.cpp
+// ----------------------------------------------------------------------------
+// Benchmark e teste do cache de resultados (CachedIndex) na frente das
+// estruturas do catálogo. As consultas imitam um tráfego repetitivo: saem de
+// um conjunto de imagens populares sorteadas por uma lei de Zipf, e metade
+// delas leva um ruído menor que a célula do cache (cores quase idênticas).
+// Para cada estrutura mede, em uma thread e com várias threads, a latência
+// média sem e com o cache, a taxa de acertos e o tempo economizado, e confere
+// que:
+//   - com a chave exata (cell = 0), intercalando inserções e remoções com as
+//     consultas, todo resultado do cache é igual ao da estrutura consultada
+//     diretamente: nenhuma entrada sobrevive a uma escrita que a invalidou;
+//   - o mesmo vale para queryBatch(), que responde os acertos do cache e manda
+//     as faltas juntas para o queryBatch() da estrutura;
+//   - com consultas concorrentes a um cache pequeno (muitos descartes) enquanto
+//     uma thread insere e remove um vetor sem parar, todo resultado é o da
+//     busca exata com ou sem esse vetor: nunca o de outra chave.
+//
+// Uso: ./bench_cache [vetores] [consultas] [populares] [threads] [estruturas]
+//   estruturas: lista separada por vírgulas (padrão: lista,quadtree,hash)
+// ----------------------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <cstdlib>
+#include <cmath>
+
+#include "Experiment.hpp"    // structureCatalog
+#include "SyntheticData.hpp" // clusteredDataset
+#include "ResultCache.hpp"
+#include "Evaluation.hpp"    // computeGroundTruth
+
+using Clock = std::chrono::steady_clock;
+
+// Consultas repetitivas: índices de 'popular' sorteados por Zipf(1.1), metade com ruído menor que 'cell'.
+static std::vector<FeatureVector> skewedQueries(const std::vector<FeatureVector>& popular, size_t n, double cell,
+                                                unsigned seed) {
+    std::vector<double> cdf(popular.size());
+    double sum = 0.0;
+    for (size_t i = 0; i < popular.size(); ++i) cdf[i] = (sum += 1.0 / std::pow(i + 1.0, 1.1));
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> u(0.0, sum);
+    std::uniform_real_distribution<double> jitter(0.0, 0.5 * cell);
+    std::vector<FeatureVector> out(n);
+    for (size_t i = 0; i < n; ++i) {
+        size_t pick = std::lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin();
+        out[i] = popular[std::min(pick, popular.size() - 1)];
+        out[i].image_id = -1;
+        if (i % 2 == 1) {
+            for (int d = 0; d < FeatureVector::DIM; ++d) {
+                out[i][d] = static_cast<FeatureVector::ScalarType>(out[i][d] + jitter(rng));
+            }
+        }
+    }
+    return out;
+}
+
+static bool sameNeighbors(const QueryResult& a, const QueryResult& b) {
+    if (a.neighbors.size() != b.neighbors.size()) return false;
+    for (size_t j = 0; j < a.neighbors.size(); ++j) {
+        if (a.neighbors[j].image_id != b.neighbors[j].image_id) return false;
+    }
+    return true;
+}
+
+// Latência média (ms) das consultas divididas entre 'threads' threads.
+static double runQueries(const std::function<void(const FeatureVector&)>& query,
+                         const std::vector<FeatureVector>& queries, int threads) {
+    auto start = Clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            for (size_t i = t; i < queries.size(); i += threads) query(queries[i]);
+        });
+    }
+    for (auto& th : pool) th.join();
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return queries.empty() ? 0.0 : ms * threads / queries.size();
+}
+
+// Distâncias dos vizinhos de 'r' até 'q', para comparar com a busca exata sem depender da ordem dos empates.
+static std::vector<double> distances(const FeatureVector& q, const std::vector<FeatureVector>& neighbors) {
+    std::vector<double> d;
+    for (const auto& vec : neighbors) d.push_back(q.distanceTo(vec));
+    return d;
+}
+
+static bool sameDistances(const std::vector<double>& a, const std::vector<double>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::fabs(a[i] - b[i]) > 1e-9) return false;
+    }
+    return true;
+}
+
+// Consultas concorrentes à Lista com cache enquanto uma escritora alterna a presença de 'toggled'.
+// Devolve quantos resultados não batem com a busca exata em nenhum dos dois estados.
+static size_t concurrentInvalid(const StructureSpec& lista, const std::vector<FeatureVector>& data,
+                                const std::vector<FeatureVector>& queries, const FeatureVector& toggled, int k,
+                                int threads) {
+    std::vector<FeatureVector> with = data;
+    with.push_back(toggled);
+    GroundTruth without_truth = computeGroundTruth(data, queries, k, threads);
+    GroundTruth with_truth = computeGroundTruth(with, queries, k, threads);
+
+    ParamSet params = expandGrid(lista.build_params)[0];
+    CachedIndex cached(lista.build(data, params), 64, 0.0); // a Lista não é thread-safe: o cache a serializa
+    std::atomic<bool> done(false);
+    std::atomic<size_t> invalid(0);
+    std::thread writer([&] {
+        for (bool present = false; !done.load(std::memory_order_relaxed); present = !present) {
+            if (present) cached.remove(toggled.image_id);
+            else cached.update(toggled);
+        }
+    });
+    std::vector<std::thread> readers;
+    for (int t = 0; t < threads; ++t) {
+        readers.emplace_back([&, t] {
+            for (size_t i = t; i < queries.size(); i += threads) {
+                std::vector<double> got = distances(queries[i], cached.query(queries[i], k).neighbors);
+                if (!sameDistances(got, without_truth.distances[i]) && !sameDistances(got, with_truth.distances[i])) {
+                    invalid++;
+                }
+            }
+        });
+    }
+    for (auto& th : readers) th.join();
+    done = true;
+    writer.join();
+    return invalid;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    size_t num_queries = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 20000;
+    size_t num_popular = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 500;
+    int threads = (argc > 4) ? std::max(1, std::atoi(argv[4])) : 4;
+    std::string only = (argc > 5) ? argv[5] : "lista,quadtree,hash";
+    const int k = 5;
+    const double value_max = (FeatureVector::DIM == 3) ? 255.0 : 1.0;
+    const double cell = value_max / 256.0;
+    const size_t capacity = 4096;
+
+    std::vector<FeatureVector> data = clusteredDataset(n, 50, 0.05 * value_max, value_max, 42, 0);
+    std::vector<FeatureVector> popular = clusteredDataset(std::max<size_t>(1, num_popular), 50, 0.05 * value_max,
+                                                          value_max, 42, -1);
+    std::vector<FeatureVector> queries = skewedQueries(popular, num_queries, cell, 7);
+    std::vector<FeatureVector> extra = clusteredDataset(200, 50, 0.05 * value_max, value_max, 9, static_cast<int>(n));
+
+    std::cout << ">> cache: " << n << " vetores, " << num_queries << " consultas sobre " << num_popular
+              << " populares (Zipf 1.1), " << capacity << " entradas, celula " << cell << ", k = " << k << std::endl;
+    std::cout << "   estrutura | threads | ms sem cache | ms com cache | acertos_% | economizado_ms | invalidos"
+              << std::endl;
+
+    bool all_ok = true;
+    for (const auto& spec : structureCatalog(value_max, 1)) {
+        if (("," + only + ",").find("," + spec.key + ",") == std::string::npos) continue;
+        ParamSet params = expandGrid(spec.build_params)[0];
+        ParamSet query_params = expandGrid(spec.query_params)[0];
+        params.insert(query_params.begin(), query_params.end());
+        auto build = [&]() {
+            std::unique_ptr<DataStructure> ds = spec.build(data, params);
+            if (spec.configure) spec.configure(*ds, params);
+            return ds;
+        };
+
+        for (int t : {1, threads}) {
+            // Sem cache as consultas concorrentes são serializadas (as estruturas não são thread-safe).
+            std::unique_ptr<DataStructure> direct = build();
+            std::mutex lock;
+            double plain_ms = runQueries([&](const FeatureVector& q) {
+                std::lock_guard<std::mutex> guard(lock);
+                direct->query(q, k);
+            }, queries, t);
+
+            CachedIndex cached(build(), capacity, cell);
+            double cached_ms = runQueries([&](const FeatureVector& q) { cached.query(q, k); }, queries, t);
+            CacheStats s = cached.stats();
+
+            // Invalidação: chave exata, escritas intercaladas, resultado do cache == resultado direto.
+            size_t invalid = 0;
+            if (t == 1) {
+                CachedIndex exact(build(), capacity, 0.0);
+                std::unique_ptr<DataStructure> reference = build();
+                for (size_t i = 0; i < 2000 && i < queries.size(); ++i) {
+                    if (i % 10 == 0) {
+                        const FeatureVector& v = extra[(i / 20) % extra.size()]; // inserido e depois removido
+                        if ((i / 10) % 2 == 0) {
+                            exact.update(v);
+                            reference->update(v);
+                        } else {
+                            exact.remove(v.image_id);
+                            reference->remove(v.image_id);
+                        }
+                    }
+                    QueryResult b = reference->query(queries[i], k);
+                    if (!sameNeighbors(exact.query(queries[i], k), b)) invalid++;
+                    if (i % 10 == 0) {
+                        // Um lote logo depois da escrita: parte acerta o cache, parte vai para a estrutura.
+                        size_t end = std::min(queries.size(), i + 10);
+                        std::vector<FeatureVector> batch(queries.begin() + i, queries.begin() + end);
+                        batch.push_back(queries[i]); // repetida no lote
+                        std::vector<QueryResult> got = exact.queryBatch(batch, k);
+                        for (size_t j = 0; j < batch.size(); ++j) {
+                            if (!sameNeighbors(got[j], reference->query(batch[j], k))) invalid++;
+                        }
+                    }
+                }
+            }
+
+            std::cout << "   " << spec.label << " | " << t << " | " << plain_ms << " | " << cached_ms << " | "
+                      << 100.0 * s.hitRate() << " | " << s.savedMs() << " | " << (t == 1 ? std::to_string(invalid) : "-")
+                      << std::endl;
+            all_ok = all_ok && invalid == 0;
+        }
+    }
+
+    // A Lista é exata: o resultado certo de cada estado é a busca exata.
+    for (const auto& spec : structureCatalog(value_max, 1)) {
+        if (spec.key != "lista") continue;
+        std::vector<FeatureVector> concurrent_queries(queries.begin(), queries.begin() + std::min<size_t>(queries.size(), 4000));
+        // O vetor alternado é uma das consultas populares, então entra nos vizinhos de várias delas.
+        FeatureVector toggled = popular[0];
+        toggled.image_id = static_cast<int>(n + extra.size());
+        size_t invalid = concurrentInvalid(spec, data, concurrent_queries, toggled, k, threads);
+        std::cout << ">> consultas concorrentes com escritas (Lista, 64 entradas, " << threads << " threads): "
+                  << invalid << " resultados invalidos" << std::endl;
+        all_ok = all_ok && invalid == 0;
+    }
+
+    std::cout << (all_ok ? ">> OK" : ">> FALHOU") << std::endl;
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+// bench_concurrent.cpp
+// ----------------------------------------------------------------------------
+// Benchmark e teste de estresse de inserções concorrentes com consultas.
+// Compara a ConcurrentHashTable (buckets sem lock) com a HashTable protegida
+// por um std::shared_mutex (consultas em modo compartilhado, inserções em modo
+// exclusivo). Enquanto as threads escritoras inserem, as leitoras consultam
+// sem parar; ao final o programa informa a vazão das duas partes e a latência
+// das consultas, e confere que:
+//   - todo resultado devolvido durante a ingestão é válido (no máximo k vizinhos,
+//     em ordem de distância, todos vetores realmente inseridos);
+//   - depois da ingestão, todo vetor inserido está no seu bucket de todas as
+//     tabelas e o contador de vetores bate.
+// Depois, as escritoras removem metade dos vetores (o que dispara compactações)
+// enquanto as leitoras continuam consultando; no fim, nenhum removido pode ser
+// encontrado e todos os outros continuam lá. Por fim, todas as escritoras
+// atualizam os mesmos IDs ao mesmo tempo, com as leitoras consultando: cada
+// update() precisa devolver true, cada ID precisa continuar com um único vetor
+// vivo e a memória não pode passar do dobro (os nós desligados são liberados).
+// Rode também com -fsanitize=thread para procurar condições de corrida.
+//
+// As leitoras fazem, juntas, no máximo uma consulta por inserção (MixedWorkload.hpp).
+//
+// Uso: ./bench_concurrent [vetores_iniciais] [insercoes] [leitores] [escritores]
+// ----------------------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <shared_mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+#include "Hash.hpp"
+#include "ConcurrentHash.hpp"
+#include "SyntheticData.hpp"
+#include "MixedWorkload.hpp" // runMixed: escritoras + leitoras simultâneas
+
+int main(int argc, char* argv[]) {
+    size_t initial = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    size_t inserts = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 100000;
+    int readers = (argc > 3) ? std::atoi(argv[3]) : 4;
+    int writers = (argc > 4) ? std::atoi(argv[4]) : 2;
+    if (initial == 0) initial = 1;
+    if (writers < 1) writers = 1;
+    const int k = 5;
+    const double value_max = (FeatureVector::DIM == 3) ? 255.0 : 1.0;
+    const double bin = (FeatureVector::DIM == 3) ? 25.0 : 0.05;
+
+    std::cout << ">> Ingestao concorrente: " << initial << " vetores iniciais + " << inserts << " insercoes, "
+              << readers << " leitoras, " << writers << " escritoras" << std::endl;
+    std::vector<FeatureVector> data = clusteredDataset(initial + inserts, 2000, 0.05 * value_max, value_max);
+
+    bool ok = true;
+    {
+        HashTable table(1013, 5, bin);
+        std::shared_mutex lock;
+        MixedReport r = runMixed(
+            [&](const FeatureVector& v) { std::unique_lock<std::shared_mutex> g(lock); table.insert(v); },
+            [&](const FeatureVector& q, int kk) { std::shared_lock<std::shared_mutex> g(lock); return table.query(q, kk); },
+            data, initial, readers, writers, k);
+        printMixedReport("HashTable + shared_mutex", r, inserts);
+        ok = ok && r.invalid_results == 0;
+    }
+    {
+        ConcurrentHashTable table(1013, 5, bin);
+        MixedReport r = runMixed([&](const FeatureVector& v) { table.insert(v); },
+                               [&](const FeatureVector& q, int kk) { return table.query(q, kk); },
+                               data, initial, readers, writers, k);
+        printMixedReport("ConcurrentHashTable     ", r, inserts);
+        ok = ok && r.invalid_results == 0;
+
+        // Depois da ingestão: todos os vetores precisam estar lá, no seu bucket de cada tabela.
+        size_t missing = 0;
+        for (const auto& v : data) {
+            if (!table.contains(v)) missing++;
+        }
+        std::cout << "   Verificacao: " << table.size() << " / " << data.size() << " vetores, "
+                  << missing << " nao encontrados" << std::endl;
+        ok = ok && missing == 0 && table.size() == data.size();
+
+        // Remoções concorrentes dos IDs pares, com leitoras consultando.
+        std::atomic<size_t> next(0);
+        std::atomic<bool> done(false);
+        std::atomic<size_t> failed(0), invalid(0);
+        std::vector<std::thread> threads;
+        auto startReaders = [&]() {
+            done = false;
+            for (int r = 0; r < readers; ++r) {
+                threads.emplace_back([&, r]() {
+                    for (size_t qi = static_cast<size_t>(r) * 7919; !done.load(std::memory_order_relaxed);) {
+                        const FeatureVector& q = data[(qi += 104729) % data.size()];
+                        if (!validResult(q, table.query(q, k), k, data.size())) invalid++;
+                    }
+                });
+            }
+        };
+        auto stopReaders = [&]() {
+            done = true;
+            for (auto& t : threads) t.join();
+            threads.clear();
+        };
+        startReaders();
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> removers;
+        for (int w = 0; w < writers; ++w) {
+            removers.emplace_back([&]() {
+                for (size_t i = next.fetch_add(2); i < data.size(); i = next.fetch_add(2)) {
+                    if (!table.remove(data[i].image_id)) failed++;
+                }
+            });
+        }
+        for (auto& t : removers) t.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stopReaders();
+
+        size_t wrong = 0;
+        for (size_t i = 0; i < data.size(); ++i) {
+            if (table.contains(data[i]) != (i % 2 == 1)) wrong++;
+        }
+        size_t expected = data.size() / 2;
+        std::cout << "   Remocoes concorrentes: " << (data.size() - expected) / seconds << " remocoes/s, "
+                  << failed << " falhas, " << invalid << " resultados invalidos; restam " << table.size()
+                  << " vetores (esperado " << expected << "), " << wrong << " com presenca errada" << std::endl;
+        ok = ok && failed == 0 && invalid == 0 && wrong == 0 && table.size() == expected;
+
+        // Atualizações simultâneas dos mesmos IDs (os ímpares, ainda presentes): todas as escritoras passam por todos,
+        // com as leitoras consultando. Cada atualização desliga um nó; a memória precisa continuar limitada.
+        const int rounds = 5;
+        std::atomic<size_t> notFound(0);
+        std::vector<std::thread> updaters;
+        size_t memory_before = table.memoryUsage().total();
+        invalid = 0;
+        startReaders();
+        start = std::chrono::steady_clock::now();
+        for (int w = 0; w < writers; ++w) {
+            updaters.emplace_back([&]() {
+                for (int round = 0; round < rounds; ++round) {
+                    for (size_t i = 1; i < data.size(); i += 2) {
+                        if (!table.update(data[i])) notFound++;
+                    }
+                }
+            });
+        }
+        for (auto& t : updaters) t.join();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stopReaders();
+        size_t memory_after = table.memoryUsage().total();
+        wrong = 0;
+        for (size_t i = 1; i < data.size(); i += 2) wrong += !table.contains(data[i]);
+        std::cout << "   Atualizacoes concorrentes dos mesmos IDs: " << writers * rounds * expected / seconds
+                  << " atualizacoes/s, " << notFound << " devolveram false, " << invalid
+                  << " resultados invalidos; restam " << table.size() << " vetores (esperado " << expected << "), "
+                  << wrong << " ausentes; memoria " << memory_before / (1024.0 * 1024.0) << " -> "
+                  << memory_after / (1024.0 * 1024.0) << " MiB" << std::endl;
+        // Sem liberar os nós desligados, a memória cresceria com writers * rounds nós por ID.
+        ok = ok && notFound == 0 && invalid == 0 && wrong == 0 && table.size() == expected &&
+             memory_after <= 2 * memory_before;
+    }
+
+    std::cout << (ok ? ">> OK" : ">> FALHOU") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+// bench_curve.cpp
+// ----------------------------------------------------------------------------
+// Benchmark da ordem dos vetores na memória (SpaceFillingCurve.hpp): para cada
+// estrutura e cada ordem (inserção, Morton, Hilbert), constrói pelo catálogo
+// com o parâmetro 'curve' e mede o tempo de construção, o tempo por consulta
+// e a memória. Na Quadtree e na Hash a curva ordena o armazenamento
+// compactado (pack); na Lista e no Flat, a ordem de inserção. Confere que:
+//   - as distâncias dos k vizinhos são as mesmas em todas as ordens (a ordem
+//     muda onde os vetores ficam, não quais são encontrados);
+//   - depois da compactação, remover e inserir de novo ainda funcionam: o
+//     vetor removido some das respostas e volta depois de reinserido.
+//
+// Para ver as faltas na cache de último nível, rode o main com --perf
+// (ex.: --structures quadtree --param quadtree.curve=0,1,2 --perf).
+//
+// Uso: ./bench_curve [vetores] [consultas] [estruturas]
+//   estruturas: lista separada por vírgulas (padrão: quadtree,hash,flat,lista)
+// ----------------------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+#include "Experiment.hpp"
+#include "SyntheticData.hpp" // clusteredDataset
+
+using Clock = std::chrono::steady_clock;
+
+static std::vector<double> distances(const FeatureVector& q, const QueryResult& r) {
+    std::vector<double> d;
+    for (const auto& vec : r.neighbors) d.push_back(q.distanceTo(vec));
+    return d;
+}
+
+static bool sameDistances(const std::vector<double>& a, const std::vector<double>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::fabs(a[i] - b[i]) > 1e-9) return false;
+    }
+    return true;
+}
+
+static bool hasId(const QueryResult& r, int image_id) {
+    for (const auto& vec : r.neighbors) {
+        if (vec.image_id == image_id) return true;
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t num_queries = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    std::string only = (argc > 3) ? argv[3] : "quadtree,hash,flat,lista";
+    const int k = 10;
+    const double value_max = (FeatureVector::DIM == 3) ? 255.0 : 1.0;
+
+    std::vector<FeatureVector> data = clusteredDataset(n, 100, 0.05 * value_max, value_max, 42, 0);
+    std::vector<FeatureVector> queries = clusteredDataset(num_queries, 100, 0.05 * value_max, value_max, 7, -1);
+    std::cout << ">> " << n << " vetores, " << num_queries << " consultas, k = " << k << std::endl;
+    std::cout << "   estrutura | ordem | construcao_ms | us/consulta | memoria_MiB | distancias_diferentes"
+              << std::endl;
+
+    bool all_ok = true;
+    for (StructureSpec& spec : structureCatalog(value_max, 1)) {
+        if (("," + only + ",").find("," + spec.key + ",") == std::string::npos) continue;
+        // A Lista é O(N) por consulta: poucas consultas bastam para comparar as ordens.
+        size_t nq = spec.key == "lista" ? std::min<size_t>(num_queries, 100) : num_queries;
+        // Na Hash, buckets proporcionais ao tamanho, para cadeias curtas como numa tabela bem dimensionada.
+        if (spec.key == "hash") overrideParam(spec, "buckets", {static_cast<double>(n / 4 + 1)});
+
+        std::vector<std::vector<double>> reference(nq);
+        for (int order = 0; order <= 2; ++order) {
+            overrideParam(spec, "curve", {static_cast<double>(order)});
+            ParamSet params = expandGrid(spec.build_params)[0];
+
+            auto start = Clock::now();
+            std::unique_ptr<DataStructure> ds = spec.build(data, params);
+            double build_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+            // Uma passada de aquecimento: a primeira depois da compactação ainda paga a limpeza do heap.
+            std::vector<QueryResult> results(nq);
+            for (size_t i = 0; i < nq; ++i) results[i] = ds->query(queries[i], k);
+            start = Clock::now();
+            for (size_t i = 0; i < nq; ++i) results[i] = ds->query(queries[i], k);
+            double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / nq;
+
+            size_t different = 0;
+            for (size_t i = 0; i < nq; ++i) {
+                std::vector<double> d = distances(queries[i], results[i]);
+                if (order == 0) reference[i] = d;
+                else different += !sameDistances(d, reference[i]);
+            }
+            all_ok = all_ok && different == 0;
+            std::cout << "   " << spec.label << " | " << curveName(static_cast<CurveOrder>(order)) << " | "
+                      << build_ms << " | " << us << " | " << ds->memoryUsage().total() / (1024.0 * 1024.0)
+                      << " | " << different << std::endl;
+
+            // Remove o vizinho mais próximo da primeira consulta e o insere de novo.
+            if (order == 0 || results[0].neighbors.empty()) continue;
+            FeatureVector nearest = results[0].neighbors[0];
+            bool removed = ds->remove(nearest.image_id);
+            bool gone = !hasId(ds->query(queries[0], k), nearest.image_id);
+            ds->insert(nearest);
+            bool back = sameDistances(distances(queries[0], ds->query(queries[0], k)), reference[0]);
+            if (!(removed && gone && back)) {
+                std::cout << ">> " << spec.label << " (" << curveName(static_cast<CurveOrder>(order))
+                          << "): remover/inserir depois da compactacao falhou" << std::endl;
+                all_ok = false;
+            }
+        }
+    }
+
+    std::cout << (all_ok ? ">> OK" : ">> FALHOU") << std::endl;
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+// bench_prefetch.cpp
+// ----------------------------------------------------------------------------
+// Benchmark do percurso intercalado com prefetch de queryBatch() na Quadtree e
+// na Hash. Para um índice pequeno (cabe na cache) e um grande (não cabe), mede
+// o tempo por consulta do laço de query() e de queryBatch() com 1, 2, 4, 8, 16
+// e 32 consultas intercaladas, e confere que:
+//   - queryBatch() devolve, para toda consulta, os mesmos vizinhos e o mesmo
+//     número de comparações que query(): intercalar muda só a ordem das
+//     leituras de memória, não os passos de cada busca.
+//
+// Uso: ./bench_prefetch [vetores] [consultas] [estruturas]
+//   estruturas: lista separada por vírgulas (padrão: quadtree,hash)
+// ----------------------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+#include "Quadtree.hpp"
+#include "Hash.hpp"
+#include "SyntheticData.hpp" // clusteredDataset
+
+using Clock = std::chrono::steady_clock;
+
+static bool sameResults(const QueryResult& a, const QueryResult& b) {
+    if (a.comparisons != b.comparisons || a.neighbors.size() != b.neighbors.size()) return false;
+    for (size_t i = 0; i < a.neighbors.size(); ++i) {
+        if (a.neighbors[i].image_id != b.neighbors[i].image_id) return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t num_queries = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 20000;
+    std::string only = (argc > 3) ? argv[3] : "quadtree,hash";
+    const int k = 10;
+    const double value_max = (FeatureVector::DIM == 3) ? 255.0 : 1.0;
+    const double hash_bin = (FeatureVector::DIM == 3) ? 4.0 : 0.05;
+
+    std::vector<FeatureVector> queries = clusteredDataset(num_queries, 100, 0.05 * value_max, value_max, 7, -1);
+    std::cout << ">> " << num_queries << " consultas, k = " << k << std::endl;
+    std::cout << "   estrutura | vetores | modo | us/consulta | aceleracao | diferentes" << std::endl;
+
+    bool all_ok = true;
+    for (size_t size : {std::min<size_t>(n, 10000), n}) {
+        std::vector<FeatureVector> data = clusteredDataset(size, 100, 0.05 * value_max, value_max, 42, 0);
+        for (const std::string key : {"quadtree", "hash"}) {
+            if (("," + only + ",").find("," + key + ",") == std::string::npos) continue;
+            std::unique_ptr<DataStructure> ds;
+            std::string label;
+            if (key == "quadtree") {
+                ds = std::make_unique<Quadtree>(0.0, value_max, 0.0, value_max);
+                label = "Quadtree";
+            } else {
+                // Buckets proporcionais ao tamanho, para cadeias curtas como numa tabela bem dimensionada.
+                ds = std::make_unique<HashTable>(static_cast<int>(size / 4 + 1), 5, hash_bin);
+                label = "Hash";
+            }
+            for (const auto& vec : data) ds->insert(vec);
+            auto setInterleave = [&](int width) {
+                if (auto* t = dynamic_cast<Quadtree*>(ds.get())) t->setInterleave(width);
+                if (auto* h = dynamic_cast<HashTable*>(ds.get())) h->setInterleave(width);
+            };
+
+            std::vector<QueryResult> reference(queries.size());
+            auto start = Clock::now();
+            for (size_t i = 0; i < queries.size(); ++i) reference[i] = ds->query(queries[i], k);
+            double plain_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / queries.size();
+            std::cout << "   " << label << " | " << size << " | query() | " << plain_us << " | 1 | -" << std::endl;
+
+            for (int width : {1, 2, 4, 8, 16, 32}) {
+                setInterleave(width);
+                start = Clock::now();
+                std::vector<QueryResult> results = ds->queryBatch(queries, k);
+                double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / queries.size();
+                size_t different = 0;
+                for (size_t i = 0; i < queries.size(); ++i) different += !sameResults(results[i], reference[i]);
+                std::cout << "   " << label << " | " << size << " | lote x" << width << " | " << us << " | "
+                          << plain_us / us << " | " << different << std::endl;
+                all_ok = all_ok && different == 0;
+            }
+        }
+    }
+
+    std::cout << (all_ok ? ">> OK" : ">> FALHOU") << std::endl;
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+// bench_shards.cpp
+// ----------------------------------------------------------------------------
+// Benchmark e teste do índice distribuído em processos shard (ShardedIndex).
+// Para cada estrutura interna (Flat, Quadtree, Hash) e cada divisão (hash do
+// ID, região angular) mede a latência média das consultas, as comparações
+// somadas dos shards e quantos shards a divisão espacial pulou, comparando
+// com a mesma estrutura em um único processo. Confere que:
+//   - com a Flat (exata) dentro dos shards, as distâncias dos k vizinhos batem
+//     com as da busca exaustiva: a junção dos top-k e o pulo de shards pelo
+//     cone não perdem vizinhos;
+//   - remoções e inserções depois da construção chegam ao shard certo (um ID
+//     removido some dos resultados e remove() devolve false na segunda vez).
+//
+// Uso: ./bench_shards [vetores] [shards] [consultas]
+// ----------------------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+#include "ShardedIndex.hpp"
+#include "FlatIndex.hpp"
+#include "Quadtree.hpp"
+#include "Hash.hpp"
+#include "SyntheticData.hpp" // clusteredDataset
+
+using Clock = std::chrono::steady_clock;
+
+struct Run {
+    double mean_ms = 0.0;
+    double comparisons = 0.0;
+    double pruned = 0.0;
+    size_t inexact = 0;     // consultas cujas distâncias diferem da busca exaustiva
+};
+
+static Run runQueries(DataStructure& ds, const std::vector<FeatureVector>& data, const std::vector<FeatureVector>& queries,
+                      int k, bool check) {
+    Run run;
+    for (const auto& q : queries) {
+        auto t0 = Clock::now();
+        QueryResult r = ds.query(q, k);
+        run.mean_ms += std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        run.comparisons += r.comparisons;
+#if QUERY_STATS
+        run.pruned += static_cast<double>(r.stats.pruned_subtrees);
+#endif
+        if (!check) continue;
+        std::vector<double> dists;
+        dists.reserve(data.size());
+        for (const auto& v : data) dists.push_back(q.distanceTo(v));
+        size_t expected = std::min(dists.size(), static_cast<size_t>(k));
+        std::partial_sort(dists.begin(), dists.begin() + expected, dists.end());
+        bool ok = r.neighbors.size() == expected;
+        for (size_t i = 0; ok && i < expected; ++i) ok = std::abs(q.distanceTo(r.neighbors[i]) - dists[i]) <= 1e-9;
+        if (!ok) run.inexact++;
+    }
+    if (!queries.empty()) {
+        run.mean_ms /= queries.size();
+        run.comparisons /= queries.size();
+        run.pruned /= queries.size();
+    }
+    return run;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    int num_shards = (argc > 2) ? std::max(1, std::atoi(argv[2])) : 4;
+    size_t num_queries = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 200;
+    const int k = 5;
+    const double value_max = (FeatureVector::DIM == 3) ? 255.0 : 1.0;
+    const double hash_bin = (FeatureVector::DIM == 3) ? 25.0 : 0.05;
+
+    std::vector<FeatureVector> data = clusteredDataset(n, 50, 0.05 * value_max, value_max, 42, 0);
+    std::vector<FeatureVector> queries = clusteredDataset(num_queries, 50, 0.05 * value_max, value_max, 42, -1);
+
+    struct Inner {
+        std::string label;
+        bool exact;
+        ShardFactory make;
+    };
+    std::vector<Inner> inners = {
+        {"Flat", true, [](const std::vector<FeatureVector>& part) {
+             auto s = std::make_unique<FlatIndex>();
+             for (const auto& vec : part) s->insert(vec);
+             return std::unique_ptr<DataStructure>(std::move(s));
+         }},
+        {"Quadtree", false, [value_max](const std::vector<FeatureVector>& part) {
+             auto s = std::make_unique<Quadtree>(0.0, value_max, 0.0, value_max);
+             for (const auto& vec : part) s->insert(vec);
+             return std::unique_ptr<DataStructure>(std::move(s));
+         }},
+        {"Hash", false, [hash_bin](const std::vector<FeatureVector>& part) {
+             auto s = std::make_unique<HashTable>(1013, 5, hash_bin);
+             for (const auto& vec : part) s->insert(vec);
+             return std::unique_ptr<DataStructure>(std::move(s));
+         }},
+    };
+
+    std::cout << ">> shards: " << n << " vetores, " << num_shards << " shards, " << num_queries
+              << " consultas (k = " << k << ")" << std::endl;
+    std::cout << "   estrutura | divisao | construcao_ms | consulta_ms | comparacoes | shards_pulados | tamanhos | inexatas"
+              << std::endl;
+
+    bool all_ok = true;
+    for (const auto& inner : inners) {
+        auto start = Clock::now();
+        std::unique_ptr<DataStructure> single = inner.make(data);
+        double build_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        Run base = runQueries(*single, data, queries, k, inner.exact);
+        std::cout << "   " << inner.label << " | 1 processo | " << build_ms << " | " << base.mean_ms << " | "
+                  << base.comparisons << " | - | " << n << " | " << base.inexact << std::endl;
+        single.reset();
+
+        for (ShardPolicy policy : {ShardPolicy::Hash, ShardPolicy::Spatial}) {
+            start = Clock::now();
+            ShardedIndex index(num_shards, policy, inner.make);
+            bool ok = index.build(data);
+            build_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            Run run = runQueries(index, data, queries, k, inner.exact);
+
+            std::string sizes;
+            for (size_t s : index.shardSizes()) sizes += (sizes.empty() ? "" : "/") + std::to_string(s);
+
+            // Remove e reinsere o vizinho mais próximo da primeira consulta.
+            if (!queries.empty()) {
+                QueryResult r = index.query(queries[0], 1);
+                if (!r.neighbors.empty()) {
+                    FeatureVector nearest = r.neighbors[0];
+                    ok = index.remove(nearest.image_id) && !index.remove(nearest.image_id) && ok;
+                    QueryResult after = index.query(queries[0], k);
+                    for (const auto& v : after.neighbors) ok = ok && v.image_id != nearest.image_id;
+                    index.insert(nearest);
+                    after = index.query(queries[0], 1);
+                    ok = ok && !after.neighbors.empty() && after.neighbors[0].image_id == nearest.image_id;
+                }
+            }
+            ok = ok && index.ok();
+
+            std::cout << "   " << inner.label << " | " << (policy == ShardPolicy::Hash ? "hash" : "espacial") << " | "
+                      << build_ms << " | " << run.mean_ms << " | " << run.comparisons << " | " << run.pruned << " | "
+                      << sizes << " | " << run.inexact << (ok ? "" : "  (remocao/insercao incorreta)") << std::endl;
+            all_ok = all_ok && ok && run.inexact == 0;
+        }
+    }
+
+    std::cout << (all_ok ? ">> OK" : ">> FALHOU") << std::endl;
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+// bench_snapshot.cpp
+// ----------------------------------------------------------------------------
+// Latência das consultas à Quadtree enquanto vetores novos são inseridos.
+// Compara a SnapshotQuadtree (cópia do caminho + publicação atômica da raiz;
+// consultas sem lock) com a Quadtree protegida por um std::shared_mutex
+// (consultas em modo compartilhado, inserções em modo exclusivo). Primeiro
+// mede a latência das consultas sem escritoras (referência); depois repete
+// as consultas durante a ingestão e informa p50, p99 e p99.9. Ao final confere
+// que:
+//   - todo resultado devolvido durante a ingestão é válido (no máximo k vizinhos,
+//     em ordem de distância, todos vetores realmente inseridos);
+//   - depois da ingestão, todo vetor inserido está na folha do seu (R,G) e o
+//     contador de vetores bate.
+// Rode também com -fsanitize=thread (ou address) para conferir a reclamação
+// dos nós antigos.
+//
+// Uso: ./bench_snapshot [vetores_iniciais] [insercoes] [leitores] [escritores]
+// ----------------------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <shared_mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+#include "Quadtree.hpp"
+#include "SnapshotQuadtree.hpp"
+#include "SyntheticData.hpp"
+#include "MixedWorkload.hpp" // runMixed: escritoras + leitoras simultâneas
+
+// Latências (ms) de 'queries' consultas sem escritoras, sobre os 'initial' primeiros vetores.
+std::vector<double> idleLatencies(DataStructure& ds, const std::vector<FeatureVector>& data, size_t initial,
+                                  size_t queries, int k) {
+    std::vector<double> ms;
+    size_t qi = 0;
+    for (size_t i = 0; i < queries; ++i) {
+        const FeatureVector& q = data[(qi += 104729) % initial];
+        auto t0 = std::chrono::steady_clock::now();
+        QueryResult result = ds.query(q, k);
+        auto t1 = std::chrono::steady_clock::now();
+        ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+    std::sort(ms.begin(), ms.end());
+    return ms;
+}
+
+void printIdle(const std::string& name, const std::vector<double>& sorted) {
+    std::cout << "   " << name << ": sem escritoras p50 " << percentile(sorted, 50.0) << " ms, p99 "
+              << percentile(sorted, 99.0) << " ms, p99.9 " << percentile(sorted, 99.9) << " ms" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t initial = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    size_t inserts = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 100000;
+    int readers = (argc > 3) ? std::atoi(argv[3]) : 4;
+    int writers = (argc > 4) ? std::atoi(argv[4]) : 1;
+    if (initial == 0) initial = 1;
+    if (writers < 1) writers = 1;
+    const int k = 5;
+    const double value_max = (FeatureVector::DIM == 3) ? 255.0 : 1.0;
+    const size_t idle_queries = std::min<size_t>(initial, 5000);
+
+    std::cout << ">> Quadtree com ingestao: " << initial << " vetores iniciais + " << inserts << " insercoes, "
+              << readers << " leitoras, " << writers << " escritoras" << std::endl;
+    std::vector<FeatureVector> data = clusteredDataset(initial + inserts, 2000, 0.05 * value_max, value_max);
+    std::vector<FeatureVector> base(data.begin(), data.begin() + initial);
+
+    bool ok = true;
+    {
+        Quadtree tree(0.0, value_max, 0.0, value_max);
+        for (const auto& v : base) tree.insert(v);
+        printIdle("Quadtree + shared_mutex", idleLatencies(tree, data, initial, idle_queries, k));
+    }
+    {
+        SnapshotQuadtree tree(0.0, value_max, 0.0, value_max);
+        for (const auto& v : base) tree.insert(v);
+        printIdle("SnapshotQuadtree       ", idleLatencies(tree, data, initial, idle_queries, k));
+    }
+    {
+        Quadtree tree(0.0, value_max, 0.0, value_max);
+        std::shared_mutex lock;
+        MixedReport r = runMixed(
+            [&](const FeatureVector& v) { std::unique_lock<std::shared_mutex> g(lock); tree.insert(v); },
+            [&](const FeatureVector& q, int kk) { std::shared_lock<std::shared_mutex> g(lock); return tree.query(q, kk); },
+            data, initial, readers, writers, k);
+        printMixedReport("Quadtree + shared_mutex", r, inserts);
+        ok = ok && r.invalid_results == 0;
+    }
+    {
+        SnapshotQuadtree tree(0.0, value_max, 0.0, value_max);
+        MixedReport r = runMixed([&](const FeatureVector& v) { tree.insert(v); },
+                               [&](const FeatureVector& q, int kk) { return tree.query(q, kk); },
+                               data, initial, readers, writers, k);
+        printMixedReport("SnapshotQuadtree       ", r, inserts);
+        ok = ok && r.invalid_results == 0;
+
+        size_t missing = 0;
+        for (const auto& v : data) {
+            if (!tree.contains(v)) missing++;
+        }
+        std::cout << "   Verificacao: " << tree.size() << " / " << data.size() << " vetores, "
+                  << missing << " nao encontrados" << std::endl;
+        ok = ok && missing == 0 && tree.size() == data.size();
+    }
+
+    std::cout << (ok ? ">> OK" : ">> FALHOU") << std::endl;
+    return ok ? 0 : 1;
+}
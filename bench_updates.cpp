@@ -0,0 +1,173 @@
+// bench_updates.cpp
+// ----------------------------------------------------------------------------
+// Benchmark e teste de remove() e update() em todas as estruturas do catálogo.
+// Para cada estrutura: constrói o índice, remove uma fração dos vetores (em
+// ordem aleatória), atualiza outra fração (mesmo image_id, componentes novos)
+// e reinsere os removidos. Mede a vazão das remoções e atualizações e a
+// latência média das consultas (antes, logo após as remoções e no final), o
+// tempo de uma atualização seguida de uma consulta (o caso de um índice que
+// recebe dados enquanto atende) e a memória antes e depois, e confere que:
+//   - remove() devolve false para IDs que não estão (nunca inseridos ou já
+//     removidos) e update() devolve true só para IDs presentes;
+//   - nenhum resultado contém um vetor removido ou a versão antiga de um vetor
+//     atualizado (todo vizinho é igual à versão atual do seu ID);
+//   - nas estruturas exatas (Lista, Flat, VP-tree), as distâncias dos k vizinhos
+//     batem com as da busca exaustiva sobre os vetores vivos.
+//
+// Uso: ./bench_updates [vetores] [fracao_removida] [consultas] [estruturas]
+//   estruturas: lista separada por vírgulas (padrão: todas)
+// ----------------------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdlib>
+#include <cmath>
+
+#include "Experiment.hpp"    // structureCatalog
+#include "SyntheticData.hpp" // clusteredDataset
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static bool sameVector(const FeatureVector& a, const FeatureVector& b) {
+    if (a.image_id != b.image_id) return false;
+    for (int d = 0; d < FeatureVector::DIM; ++d) {
+        if (a[d] != b[d]) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Consulta 'queries' vetores e confere cada vizinho contra a versão atual do seu ID.
+ * @param exact Se true, compara também as distâncias com a busca exaustiva sobre 'live'.
+ * @return Número de consultas com algum vizinho inválido; 'mean_ms' recebe a latência média.
+ */
+static size_t checkQueries(DataStructure& ds, const std::unordered_map<int, FeatureVector>& live,
+                           const std::vector<FeatureVector>& queries, int k, bool exact, double& mean_ms) {
+    size_t invalid = 0;
+    double total_ms = 0.0;
+    for (const auto& q : queries) {
+        auto t0 = Clock::now();
+        QueryResult r = ds.query(q, k);
+        total_ms += std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+        bool ok = r.neighbors.size() <= static_cast<size_t>(k);
+        for (const auto& n : r.neighbors) {
+            auto it = live.find(n.image_id);
+            ok = ok && it != live.end() && sameVector(it->second, n);
+        }
+        if (ok && exact) {
+            std::vector<double> dists;
+            dists.reserve(live.size());
+            for (const auto& entry : live) dists.push_back(q.distanceTo(entry.second));
+            size_t expected = std::min(dists.size(), static_cast<size_t>(k));
+            std::partial_sort(dists.begin(), dists.begin() + expected, dists.end());
+            ok = r.neighbors.size() == expected;
+            for (size_t i = 0; ok && i < expected; ++i) {
+                ok = std::abs(q.distanceTo(r.neighbors[i]) - dists[i]) <= 1e-9;
+            }
+        }
+        if (!ok) invalid++;
+    }
+    mean_ms = queries.empty() ? 0.0 : total_ms / queries.size();
+    return invalid;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    double fraction = (argc > 2) ? std::atof(argv[2]) : 0.5;
+    size_t num_queries = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 200;
+    std::string only = (argc > 4) ? argv[4] : "";
+    if (n < 2) n = 2;
+    fraction = std::max(0.0, std::min(1.0, fraction));
+    const int k = 5;
+    const double value_max = (FeatureVector::DIM == 3) ? 255.0 : 1.0;
+
+    // Os IDs 0..n-1 são indexados; 'fresh' traz os componentes novos das atualizações (mesmos IDs).
+    std::vector<FeatureVector> data = clusteredDataset(n, 50, 0.05 * value_max, value_max, 42, 0);
+    std::vector<FeatureVector> fresh = clusteredDataset(n, 50, 0.05 * value_max, value_max, 7, 0);
+    std::vector<FeatureVector> queries = clusteredDataset(num_queries, 50, 0.05 * value_max, value_max, 42, -1);
+
+    std::vector<int> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = static_cast<int>(i);
+    std::mt19937 rng(123);
+    std::shuffle(order.begin(), order.end(), rng);
+    const size_t removed = static_cast<size_t>(fraction * n);
+    const size_t updated = std::min(n - removed, removed / 2 + 1);
+
+    std::cout << ">> remove/update: " << n << " vetores, " << removed << " remocoes, " << updated
+              << " atualizacoes, " << num_queries << " consultas (k = " << k << ")" << std::endl;
+    std::cout << "   estrutura | remocoes/s | atualizacoes/s | consulta_ms antes | apos remocoes | final"
+              << " | atualizacao+consulta_ms | memoria_KiB antes | final | invalidos" << std::endl;
+
+    bool all_ok = true;
+    for (const auto& spec : structureCatalog(value_max, 1)) {
+        if (!only.empty() && ("," + only + ",").find("," + spec.key + ",") == std::string::npos) continue;
+        ParamSet params = expandGrid(spec.build_params)[0];
+        ParamSet query_params = expandGrid(spec.query_params)[0];
+        params.insert(query_params.begin(), query_params.end());
+        const bool exact = spec.key == "lista" || spec.key == "flat" || spec.key == "vp-tree";
+
+        std::unique_ptr<DataStructure> ds = spec.build(data, params);
+        if (spec.configure) spec.configure(*ds, params);
+        std::unordered_map<int, FeatureVector> live;
+        for (const auto& v : data) live[v.image_id] = v;
+
+        double before_ms = 0.0, removed_ms = 0.0, after_ms = 0.0;
+        size_t invalid = checkQueries(*ds, live, queries, k, exact, before_ms);
+        size_t before_kib = ds->memoryUsage().total() / 1024;
+        bool ok = true;
+
+        // Remoções (e IDs que não estão lá).
+        auto start = Clock::now();
+        for (size_t i = 0; i < removed; ++i) ok = ds->remove(order[i]) && ok;
+        double remove_s = secondsSince(start);
+        for (size_t i = 0; i < removed; ++i) live.erase(order[i]);
+        ok = !ds->remove(static_cast<int>(n) + 1) && ok;
+        if (removed > 0) ok = !ds->remove(order[0]) && ok;
+        invalid += checkQueries(*ds, live, queries, k, exact, removed_ms);
+
+        // Atualizações de vetores presentes.
+        start = Clock::now();
+        for (size_t i = removed; i < removed + updated; ++i) ok = ds->update(fresh[order[i]]) && ok;
+        double update_s = secondsSince(start);
+        for (size_t i = removed; i < removed + updated; ++i) live[order[i]] = fresh[order[i]];
+        invalid += checkQueries(*ds, live, queries, k, exact, after_ms);
+
+        // Atualização seguida de consulta, alternadas: a consulta não pode pagar uma reconstrução a cada vez.
+        const size_t rounds = std::min<size_t>(updated, 20);
+        double mixed_ms = 0.0;
+        start = Clock::now();
+        for (size_t i = removed; i < removed + rounds; ++i) {
+            ok = ds->update(data[order[i]]) && ok;
+            ds->query(queries[i % queries.size()], k);
+        }
+        if (rounds > 0) mixed_ms = secondsSince(start) * 1000.0 / rounds;
+        for (size_t i = removed; i < removed + rounds; ++i) live[order[i]] = data[order[i]];
+
+        // Reinserção dos removidos pela update() (devolve false: não havia vetor antigo).
+        for (size_t i = 0; i < removed; ++i) {
+            ok = !ds->update(data[order[i]]) && ok;
+            live[order[i]] = data[order[i]];
+        }
+        invalid += checkQueries(*ds, live, queries, k, exact, after_ms);
+        size_t after_kib = ds->memoryUsage().total() / 1024;
+
+        std::cout << "   " << spec.label << " | " << (remove_s > 0.0 ? removed / remove_s : 0.0) << " | "
+                  << (update_s > 0.0 ? updated / update_s : 0.0) << " | " << before_ms << " | " << removed_ms << " | " << after_ms
+                  << " | " << mixed_ms << " | " << before_kib << " | " << after_kib << " | " << invalid
+                  << (ok ? "" : "  (retorno de remove/update incorreto)") << std::endl;
+        all_ok = all_ok && ok && invalid == 0;
+    }
+
+    std::cout << (all_ok ? ">> OK" : ">> FALHOU") << std::endl;
+    return all_ok ? 0 : 1;
+}
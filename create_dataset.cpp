@@ -1,82 +1,558 @@
 // create_dataset.cpp
+// ----------------------------------------------------------------------------
+// Lê um diretório de imagens e grava, para cada uma, o vetor de características
+// (RGB médio ou histograma de cor) em um arquivo CSV.
+//
+// Uso: ./create_dataset [pasta] [saida.csv] [opcoes]
+//   --hist N             Extrai um histograma RGB com N bins (8, 64, 512 ou 4096)
+//                        em vez do RGB médio. Use com main compilado com -DFEATURE_DIM=N.
+//   --stride N           Lê apenas 1 pixel a cada N linhas e colunas (padrão: 1).
+//   --max-megapixels M   Não decodifica imagens inteiras com mais de M megapixels,
+//                        o que limita o pico de memória (padrão: 0 = sem limite):
+//                        BMPs sem compressão são lidos com um stride maior, que
+//                        cabe no limite; os outros formatos são pulados e contados.
+//   --fast               Atalho para '--stride 4 --max-megapixels 64'.
+//   --check-error        Calcula também a média completa e informa o erro real
+//                        da subamostragem (mais lento; útil para calibrar N).
+//   --incremental        Atualiza o dataset usando um manifesto: só extrai imagens
+//                        novas ou alteradas, mantém os IDs e marca as removidas.
+//   --manifest ARQ       Caminho do manifesto (padrão: <saida.csv>.manifest).
+// ----------------------------------------------------------------------------
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
 #include <filesystem> // Requer C++17 para iterar em diretórios
 
+#include "ChannelSum.hpp" // Kernel vetorizado de soma dos canais RGB
+#include "ColorHistogram.hpp"
+#include "Manifest.hpp"   // Manifesto da atualização incremental
+
 // Define que este arquivo .cpp irá conter a implementação da biblioteca stb_image.
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-// A função main não precisa mais de 'argc' e 'argv'
-int main() {
-    // Defina o caminho para a pasta com suas imagens diretamente no código.
+/**
+ * @struct ExtractOptions
+ * @brief Parâmetros da extração de características lidos da linha de comando.
+ */
+struct ExtractOptions {
     std::filesystem::path dataset_root_path = "./database_flowers";
-
-    // Defina o nome do arquivo de saída.
     std::string output_filename = "dataset.csv";
+    int stride = 1;
+    int hist_bins = 0;           // 0 = RGB médio; N = histograma com N bins
+    double max_megapixels = 0.0; // 0 = sem limite
+    bool check_error = false;
+    bool incremental = false;
+    std::string manifest_filename; // vazio = <saida.csv>.manifest
+};
 
+// Interpreta os argumentos; retorna false se algum for inválido.
+bool parseArguments(int argc, char* argv[], ExtractOptions& opt) {
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--hist" && i + 1 < argc) {
+            opt.hist_bins = std::atoi(argv[++i]);
+            if (histogramBinsPerChannel(opt.hist_bins) == 0) return false;
+        } else if (arg == "--stride" && i + 1 < argc) {
+            opt.stride = std::atoi(argv[++i]);
+            if (opt.stride < 1) return false;
+        } else if (arg == "--max-megapixels" && i + 1 < argc) {
+            opt.max_megapixels = std::atof(argv[++i]);
+        } else if (arg == "--fast") {
+            opt.stride = 4;
+            opt.max_megapixels = 64.0;
+        } else if (arg == "--check-error") {
+            opt.check_error = true;
+        } else if (arg == "--incremental") {
+            opt.incremental = true;
+        } else if (arg == "--manifest" && i + 1 < argc) {
+            opt.manifest_filename = argv[++i];
+        } else if (!arg.empty() && arg[0] != '-' && positional == 0) {
+            opt.dataset_root_path = arg;
+            positional++;
+        } else if (!arg.empty() && arg[0] != '-' && positional == 1) {
+            opt.output_filename = arg;
+            positional++;
+        } else {
+            return false;
+        }
+    }
+    if (opt.manifest_filename.empty()) opt.manifest_filename = opt.output_filename + ".manifest";
+    return true;
+}
 
-    std::ofstream output_file(output_filename);
-    if (!output_file.is_open()) {
-        std::cerr << "Erro: Nao foi possivel criar o arquivo de saida " << output_filename << std::endl;
-        return 1;
+// Estatísticas acumuladas ao longo de uma execução.
+struct RunStats {
+    double worst_bound = 0.0;      // maior limite de erro estimado (95%)
+    double last_bound = 0.0;       // limite estimado da última imagem extraída
+    double worst_real_error = 0.0; // maior erro real (apenas com --check-error)
+    int skipped_large = 0;         // acima do limite e sem leitura parcial
+    int downsampled_large = 0;     // acima do limite, lidas com stride maior
+};
+
+bool isImageFile(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    return extension == ".jpg" || extension == ".jpeg" || extension == ".png" || extension == ".bmp";
+}
+
+// Identifica os parâmetros que alteram as características extraídas (o limite de megapixels decide
+// quais imagens são lidas com stride maior ou puladas). Se mudarem entre duas execuções
+// incrementais, todas as imagens são extraídas novamente.
+uint32_t extractionSignature(const ExtractOptions& opt) {
+    uint64_t h = fnv1a64(reinterpret_cast<const unsigned char*>(&opt.stride), sizeof(opt.stride));
+    h = fnv1a64(reinterpret_cast<const unsigned char*>(&opt.hist_bins), sizeof(opt.hist_bins), h);
+    h = fnv1a64(reinterpret_cast<const unsigned char*>(&opt.max_megapixels), sizeof(opt.max_megapixels), h);
+    return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+// Número de características por imagem.
+uint32_t featureDimension(const ExtractOptions& opt) {
+    return opt.hist_bins > 0 ? static_cast<uint32_t>(opt.hist_bins) : 3u;
+}
+
+// Leitura de 'n' bytes a partir de 'offset', dos bytes em memória ou do arquivo.
+bool readAt(std::ifstream& in, const std::vector<unsigned char>* bytes, uint64_t offset, unsigned char* dst, size_t n) {
+    if (bytes) {
+        if (offset > bytes->size() || bytes->size() - offset < n) return false;
+        std::memcpy(dst, bytes->data() + offset, n);
+        return true;
     }
+    in.seekg(static_cast<std::streamoff>(offset));
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(dst), static_cast<std::streamsize>(n)));
+}
 
-    std::cout << "Processando imagens do diretorio raiz: " << dataset_root_path << std::endl;
-    std::cout << "Salvando vetores em: " << output_filename << std::endl;
+/**
+ * @brief Lê um BMP sem compressão (24 ou 32 bits) tomando 1 pixel a cada 'stride' linhas e colunas.
+ * @details Só as linhas amostradas são lidas, e o buffer guarda ceil(largura/stride) x
+ * ceil(altura/stride) pixels RGB em vez da imagem inteira. O stb_image sempre decodifica
+ * na resolução completa, então este é o caminho das imagens acima de --max-megapixels.
+ * @return false se a imagem não for um BMP nesse formato.
+ */
+bool loadStridedBmp(const std::filesystem::path& path, const std::vector<unsigned char>* bytes, int stride,
+                    std::vector<unsigned char>& rgb, int& out_width, int& out_height) {
+    std::ifstream in;
+    if (!bytes) {
+        in.open(path, std::ios::binary);
+        if (!in.is_open()) return false;
+    }
+    unsigned char h[34];
+    if (!readAt(in, bytes, 0, h, sizeof(h)) || h[0] != 'B' || h[1] != 'M') return false;
+    auto u16 = [&h](int o) { return static_cast<uint32_t>(h[o] | (h[o + 1] << 8)); };
+    auto u32 = [&](int o) { return u16(o) | (u16(o + 2) << 16); };
+    uint32_t data_offset = u32(10), header_size = u32(14), bpp = u16(28), compression = u32(30);
+    int32_t width = static_cast<int32_t>(u32(18)), height = static_cast<int32_t>(u32(22));
+    if (header_size < 40 || compression != 0 || (bpp != 24 && bpp != 32) || width <= 0 || height == 0) return false;
 
-    int image_id_counter = 1;
+    // As linhas são gravadas de baixo para cima, a menos que a altura seja negativa.
+    bool bottom_up = height > 0;
+    int64_t rows = bottom_up ? height : -static_cast<int64_t>(height);
+    size_t row_bytes = ((static_cast<size_t>(width) * bpp + 31) / 32) * 4;
+    size_t pixel_bytes = bpp / 8;
+    out_width = static_cast<int>((width + stride - 1) / stride);
+    out_height = static_cast<int>((rows + stride - 1) / stride);
+    rgb.resize(static_cast<size_t>(out_width) * out_height * 3);
 
-    // Itera recursivamente por todos os arquivos e pastas a partir do caminho raiz.
-    for (const auto& entry : std::filesystem::recursive_directory_iterator(dataset_root_path)) {
-        if (!entry.is_regular_file()) {
-            continue; // Pula se não for um arquivo (ex: é um diretório)
+    std::vector<unsigned char> row(row_bytes);
+    unsigned char* dst = rgb.data();
+    for (int64_t y = 0; y < rows; y += stride) {
+        int64_t stored = bottom_up ? rows - 1 - y : y;
+        if (!readAt(in, bytes, data_offset + static_cast<uint64_t>(stored) * row_bytes, row.data(), row_bytes)) return false;
+        for (size_t x = 0; x < static_cast<size_t>(width); x += stride) {
+            const unsigned char* p = row.data() + x * pixel_bytes; // BGR(X)
+            *dst++ = p[2];
+            *dst++ = p[1];
+            *dst++ = p[0];
         }
+    }
+    return true;
+}
 
-        const auto& path = entry.path();
-        std::string extension = path.extension().string();
+// RGB médio de uma amostra, acumulando o limite de erro estimado.
+void meanFeatures(const ChannelSample& sample, std::vector<double>& features, RunStats& stats) {
+    features.assign({sample.mean(sample.sum.r), sample.mean(sample.sum.g), sample.mean(sample.sum.b)});
+    stats.last_bound = sample.maxErrorBound();
+    if (stats.last_bound > stats.worst_bound) stats.worst_bound = stats.last_bound;
+}
 
-        if (extension == ".jpg" || extension == ".jpeg" || extension == ".png" || extension == ".bmp") {
-            int width, height, channels;
-            unsigned char* img_data = stbi_load(path.string().c_str(), &width, &height, &channels, 0);
+/**
+ * @brief Decodifica uma imagem e calcula seu vetor de características (RGB médio ou histograma).
+ * @param path Caminho da imagem (usado para leitura e nas mensagens).
+ * @param bytes Conteúdo do arquivo já lido em memória, ou nullptr para ler do disco.
+ * @param features Recebe as características extraídas.
+ * @return false se a imagem foi pulada (erro de leitura, tons de cinza ou acima do limite sem leitura parcial).
+ */
+bool extractFeatures(const std::filesystem::path& path, const std::vector<unsigned char>* bytes,
+                     const ExtractOptions& opt, std::vector<double>& features, RunStats& stats) {
+    int width = 0, height = 0, channels = 0;
+    int len = bytes ? static_cast<int>(bytes->size()) : 0;
 
-            if (img_data == nullptr) {
-                std::cerr << "Aviso: Nao foi possivel carregar a imagem " << path.string() << std::endl;
-                continue;
+    // Lê apenas o cabeçalho para decidir se a imagem cabe no orçamento de memória.
+    // O stb_image não decodifica em escala reduzida: acima do limite, um BMP sem
+    // compressão é lido com o menor stride cuja amostra cabe no limite, e os outros
+    // formatos são pulados em vez de alocar um buffer proporcional ao seu tamanho.
+    if (opt.max_megapixels > 0.0) {
+        int ok = bytes ? stbi_info_from_memory(bytes->data(), len, &width, &height, &channels)
+                       : stbi_info(path.string().c_str(), &width, &height, &channels);
+        // O stb_image informa altura negativa para BMPs gravados de cima para baixo.
+        if (ok) height = std::abs(height);
+        double pixels = ok ? static_cast<double>(width) * height : 0.0;
+        if (pixels > opt.max_megapixels * 1e6) {
+            int stride = std::max(opt.stride, static_cast<int>(std::ceil(std::sqrt(pixels / (opt.max_megapixels * 1e6)))));
+            std::vector<unsigned char> rgb;
+            int sampled_width = 0, sampled_height = 0;
+            if (!loadStridedBmp(path, bytes, stride, rgb, sampled_width, sampled_height)) {
+                std::cerr << "Aviso: Imagem " << path.string() << " (" << width << "x" << height
+                          << ") excede o limite de " << opt.max_megapixels
+                          << " MP e o formato nao permite leitura parcial. Pulando." << std::endl;
+                stats.skipped_large++;
+                return false;
             }
-
-            if (channels < 3) {
-                std::cerr << "Aviso: Imagem " << path.string() << " nao e colorida (RGB). Pulando." << std::endl;
-                stbi_image_free(img_data);
-                continue;
+            std::cerr << "Aviso: Imagem " << path.string() << " (" << width << "x" << height
+                      << ") excede o limite de " << opt.max_megapixels << " MP. Lendo 1 pixel a cada "
+                      << stride << " linhas e colunas." << std::endl;
+            stats.downsampled_large++;
+            if (opt.hist_bins > 0) {
+                colorHistogram(rgb.data(), sampled_width, sampled_height, 3, 1,
+                               histogramBinsPerChannel(opt.hist_bins), features);
+            } else {
+                meanFeatures(sampleCompact(rgb.data(), rgb.size() / 3, 3, static_cast<size_t>(pixels)), features, stats);
             }
+            return true;
+        }
+    }
 
-            unsigned long long total_r = 0, total_g = 0, total_b = 0;
-            long num_pixels = width * height;
+    unsigned char* img_data = bytes ? stbi_load_from_memory(bytes->data(), len, &width, &height, &channels, 0)
+                                    : stbi_load(path.string().c_str(), &width, &height, &channels, 0);
 
-            for (int i = 0; i < num_pixels; ++i) {
-                total_r += img_data[i * channels + 0];
-                total_g += img_data[i * channels + 1];
-                total_b += img_data[i * channels + 2];
-            }
+    if (img_data == nullptr) {
+        std::cerr << "Aviso: Nao foi possivel carregar a imagem " << path.string() << std::endl;
+        return false;
+    }
 
-            double avg_r = static_cast<double>(total_r) / num_pixels;
-            double avg_g = static_cast<double>(total_g) / num_pixels;
-            double avg_b = static_cast<double>(total_b) / num_pixels;
+    if (channels < 3) {
+        std::cerr << "Aviso: Imagem " << path.string() << " nao e colorida (RGB). Pulando." << std::endl;
+        stbi_image_free(img_data);
+        return false;
+    }
 
-            output_file << image_id_counter << "," << avg_r << "," << avg_g << "," << avg_b << "\n";
-            std::cout << "Processado: " << path.filename() << " -> ID: " << image_id_counter << std::endl;
+    if (opt.hist_bins > 0) {
+        colorHistogram(img_data, width, height, channels, opt.stride,
+                       histogramBinsPerChannel(opt.hist_bins), features);
+        stbi_image_free(img_data);
+        return true;
+    }
 
-            image_id_counter++;
-            stbi_image_free(img_data);
+    meanFeatures(sampleChannels(img_data, width, height, channels, opt.stride), features, stats);
+
+    if (opt.check_error && opt.stride > 1) {
+        ChannelSample full = sampleChannels(img_data, width, height, channels, 1);
+        double err = std::fmax(std::fabs(features[0] - full.mean(full.sum.r)),
+                     std::fmax(std::fabs(features[1] - full.mean(full.sum.g)),
+                               std::fabs(features[2] - full.mean(full.sum.b))));
+        if (err > stats.worst_real_error) stats.worst_real_error = err;
+    }
+
+    stbi_image_free(img_data);
+    return true;
+}
+
+// Sufixo da linha de progresso com o erro estimado da última imagem (só no RGB médio subamostrado,
+// pelo --stride ou por ela estar acima do limite de megapixels).
+std::string boundNote(const ExtractOptions& opt, const RunStats& stats) {
+    if (opt.hist_bins > 0 || (opt.stride <= 1 && stats.last_bound == 0.0)) return std::string();
+    std::ostringstream note;
+    note << " (erro estimado <= " << stats.last_bound << ")";
+    return note.str();
+}
+
+// Grava uma linha do dataset: id seguido das características.
+void writeRow(std::ofstream& out, int image_id, const std::vector<double>& features) {
+    out << image_id;
+    for (double f : features) out << "," << f;
+    out << "\n";
+}
+
+// Lê um arquivo inteiro para a memória.
+bool readFile(const std::filesystem::path& path, std::vector<unsigned char>& bytes) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) return false;
+    bytes.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(bytes.data()), bytes.size()));
+}
+
+/**
+ * @brief Atualização incremental do dataset a partir do manifesto.
+ * @details
+ * 1. Varre o diretório comparando tamanho e data de modificação com o manifesto;
+ *    arquivos iguais são reaproveitados sem serem lidos.
+ * 2. Os demais são lidos e identificados pelo hash do conteúdo: se o conteúdo não
+ *    mudou (só a data), ou se é um arquivo movido, o ID e as características são mantidos.
+ *    Caso contrário, a imagem é decodificada; um caminho conhecido mantém seu ID e um
+ *    caminho novo recebe o próximo ID livre. Se a leitura ou a extração falhar, o arquivo
+ *    fica registrado como ignorado (skipped) e só é tentado de novo quando mudar.
+ * 3. Entradas não encontradas viram tombstones e seus IDs nunca são reutilizados.
+ * O CSV de saída é então regravado a partir das entradas vivas do manifesto.
+ */
+int runIncremental(const ExtractOptions& opt, RunStats& stats) {
+    namespace fs = std::filesystem;
+    auto start = std::chrono::steady_clock::now();
+
+    Manifest manifest;
+    bool loaded = manifest.load(opt.manifest_filename);
+    uint32_t signature = extractionSignature(opt);
+    bool reextract_all = loaded && manifest.signature != signature;
+    if (!loaded || reextract_all) {
+        manifest.dim = featureDimension(opt);
+        // Tombstones mantêm as características antigas; ajusta o tamanho para o novo formato.
+        for (auto& e : manifest.entries) e.features.assign(manifest.dim, 0.0);
+    }
+    manifest.signature = signature;
+
+    std::cout << "Manifesto: " << opt.manifest_filename
+              << (loaded ? " (" + std::to_string(manifest.entries.size()) + " entradas)" : std::string(" (novo)"))
+              << std::endl;
+    if (reextract_all) {
+        std::cout << "Parametros de extracao mudaram: todas as imagens serao extraidas novamente." << std::endl;
+    }
+
+    struct PendingFile {
+        std::string rel;
+        fs::path path;
+        uint64_t size;
+        int64_t mtime;
+    };
+    std::vector<PendingFile> pending;
+    std::vector<char> seen(manifest.entries.size(), 0);
+    int unchanged = 0, touched = 0, moved = 0, changed = 0, added = 0, removed = 0;
+    int skipped = 0, still_skipped = 0;
+
+    // Fase 1: varredura barata (apenas stat).
+    for (const auto& entry : fs::recursive_directory_iterator(opt.dataset_root_path)) {
+        if (!entry.is_regular_file() || !isImageFile(entry.path())) continue;
+
+        std::string rel = entry.path().lexically_relative(opt.dataset_root_path).generic_string();
+        uint64_t size = entry.file_size();
+        int64_t mtime = static_cast<int64_t>(entry.last_write_time().time_since_epoch().count());
+
+        ManifestEntry* e = manifest.find(rel);
+        if (e && !e->deleted && !reextract_all && e->size == size && e->mtime == mtime) {
+            seen[e - manifest.entries.data()] = 1;
+            if (e->skipped) still_skipped++;
+            else unchanged++;
+            continue;
+        }
+        pending.push_back({rel, entry.path(), size, mtime});
+    }
+
+    // Entradas vivas ainda não vistas podem ter sido movidas: indexa-as pelo hash.
+    std::unordered_multimap<uint64_t, size_t> unseen_by_hash;
+    if (!reextract_all) {
+        for (size_t i = 0; i < manifest.entries.size(); ++i) {
+            if (!seen[i] && !manifest.entries[i].deleted) unseen_by_hash.emplace(manifest.entries[i].hash, i);
+        }
+    }
+
+    // Arquivo que não pôde ser lido ou extraído: fica registrado, sem características, para
+    // não ser lido de novo enquanto o tamanho e a data não mudarem.
+    auto markSkipped = [&](const PendingFile& p, ManifestEntry* e, uint64_t hash) {
+        if (!e) {
+            ManifestEntry ne;
+            ne.path = p.rel;
+            ne.features.assign(manifest.dim, 0.0);
+            e = &manifest.add(std::move(ne));
+            seen.push_back(0);
+        }
+        e->size = p.size;
+        e->mtime = p.mtime;
+        e->hash = hash;
+        e->deleted = false;
+        e->skipped = true;
+        seen[e - manifest.entries.data()] = 1;
+        skipped++;
+    };
+
+    // Fase 2: arquivos novos ou alterados.
+    std::vector<unsigned char> bytes;
+    std::vector<double> features;
+    for (const auto& p : pending) {
+        ManifestEntry* e = manifest.find(p.rel);
+        if (!readFile(p.path, bytes)) {
+            std::cerr << "Aviso: Nao foi possivel ler o arquivo " << p.path.string() << std::endl;
+            markSkipped(p, e, 0);
+            continue;
+        }
+        uint64_t hash = fnv1a64(bytes.data(), bytes.size());
+
+        if (e && !reextract_all && e->hash == hash) {
+            // Mesmo conteúdo, apenas a data mudou (ou o arquivo voltou a existir).
+            e->size = p.size;
+            e->mtime = p.mtime;
+            e->deleted = false;
+            seen[e - manifest.entries.data()] = 1;
+            touched++;
+            continue;
+        }
+
+        bool was_moved = false;
+        auto range = unseen_by_hash.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            ManifestEntry& old = manifest.entries[it->second];
+            if (seen[it->second] || old.deleted) continue;
+            manifest.rename(old, p.rel);
+            old.size = p.size;
+            old.mtime = p.mtime;
+            seen[it->second] = 1;
+            was_moved = true;
+            break;
+        }
+        if (was_moved) {
+            moved++;
+            continue;
+        }
+
+        if (!extractFeatures(p.path, &bytes, opt, features, stats)) {
+            markSkipped(p, e, hash);
+            continue;
+        }
+
+        if (e) {
+            e->size = p.size;
+            e->mtime = p.mtime;
+            e->hash = hash;
+            e->deleted = false;
+            e->skipped = false;
+            e->features = features;
+            seen[e - manifest.entries.data()] = 1;
+            changed++;
+            std::cout << "Atualizado: " << p.rel << " -> ID: " << e->image_id << boundNote(opt, stats) << std::endl;
+        } else {
+            ManifestEntry ne;
+            ne.path = p.rel;
+            ne.size = p.size;
+            ne.mtime = p.mtime;
+            ne.hash = hash;
+            ne.features = features;
+            const ManifestEntry& added_entry = manifest.add(std::move(ne));
+            seen.push_back(1);
+            added++;
+            std::cout << "Processado: " << p.rel << " -> ID: " << added_entry.image_id << boundNote(opt, stats)
+                      << std::endl;
+        }
+    }
+
+    // Fase 3: tombstones para o que não foi encontrado.
+    for (size_t i = 0; i < manifest.entries.size(); ++i) {
+        if (!seen[i] && !manifest.entries[i].deleted) {
+            manifest.entries[i].deleted = true;
+            if (!manifest.entries[i].skipped) removed++;
         }
     }
 
+    std::ofstream output_file(opt.output_filename);
+    if (!output_file.is_open()) {
+        std::cerr << "Erro: Nao foi possivel criar o arquivo de saida " << opt.output_filename << std::endl;
+        return 1;
+    }
+    // As entradas são acrescentadas em ordem crescente de ID, então o CSV sai ordenado.
+    for (const auto& e : manifest.entries) {
+        if (!e.deleted && !e.skipped) writeRow(output_file, e.image_id, e.features);
+    }
     output_file.close();
-    std::cout << "\nDataset criado com sucesso em " << output_filename << std::endl;
 
+    if (!manifest.save(opt.manifest_filename)) {
+        std::cerr << "Erro: Nao foi possivel gravar o manifesto " << opt.manifest_filename << std::endl;
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "\nAtualizacao incremental concluida em " << seconds << " s: "
+              << unchanged << " inalteradas, " << touched << " apenas com data alterada, "
+              << moved << " movidas, " << changed << " alteradas, " << added << " novas, "
+              << removed << " removidas, " << skipped << " puladas";
+    if (still_skipped > 0) std::cout << " (e " << still_skipped << " puladas antes e sem mudancas, nao lidas)";
+    std::cout << "." << std::endl;
     return 0;
-}
\ No newline at end of file
+}
+
+
+int main(int argc, char* argv[]) {
+    ExtractOptions opt;
+    if (!parseArguments(argc, argv, opt)) {
+        std::cerr << "Uso: " << argv[0] << " [pasta] [saida.csv] [--stride N] [--max-megapixels M] [--hist N] [--fast] [--check-error]"
+                  << " [--incremental] [--manifest ARQ]" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Processando imagens do diretorio raiz: " << opt.dataset_root_path << std::endl;
+    std::cout << "Salvando vetores em: " << opt.output_filename << std::endl;
+    if (opt.stride > 1 || opt.max_megapixels > 0.0) {
+        std::cout << "Modo rapido: stride " << opt.stride << ", limite de "
+                  << (opt.max_megapixels > 0.0 ? std::to_string(opt.max_megapixels) + " MP" : std::string("(nenhum)"))
+                  << std::endl;
+    }
+
+    RunStats stats;
+    int status = 0;
+
+    if (opt.incremental) {
+        status = runIncremental(opt, stats);
+    } else {
+        std::ofstream output_file(opt.output_filename);
+        if (!output_file.is_open()) {
+            std::cerr << "Erro: Nao foi possivel criar o arquivo de saida " << opt.output_filename << std::endl;
+            return 1;
+        }
+
+        int image_id_counter = 1;
+        std::vector<double> features;
+
+        // Itera recursivamente por todos os arquivos e pastas a partir do caminho raiz.
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(opt.dataset_root_path)) {
+            if (!entry.is_regular_file()) {
+                continue; // Pula se não for um arquivo (ex: é um diretório)
+            }
+
+            const auto& path = entry.path();
+            if (!isImageFile(path)) continue;
+
+            if (!extractFeatures(path, nullptr, opt, features, stats)) continue;
+
+            writeRow(output_file, image_id_counter, features);
+            std::cout << "Processado: " << path.filename() << " -> ID: " << image_id_counter << boundNote(opt, stats)
+                      << std::endl;
+
+            image_id_counter++;
+        }
+
+        output_file.close();
+        std::cout << "\nDataset criado com sucesso em " << opt.output_filename << std::endl;
+    }
+
+    if ((opt.stride > 1 || stats.downsampled_large > 0) && opt.hist_bins == 0) {
+        std::cout << "Maior limite de erro estimado (95%) por canal: " << stats.worst_bound << " (escala 0-255)" << std::endl;
+        if (opt.check_error) {
+            std::cout << "Maior erro real em relacao a resolucao completa: " << stats.worst_real_error << std::endl;
+        }
+    }
+    if (stats.downsampled_large > 0) {
+        std::cout << stats.downsampled_large << " imagem(ns) acima do limite de megapixels foram lidas com stride maior."
+                  << std::endl;
+    }
+    if (stats.skipped_large > 0) {
+        std::cout << stats.skipped_large << " imagem(ns) acima do limite de megapixels foram puladas "
+                  << "(formato sem leitura parcial)." << std::endl;
+    }
+
+    return status;
+}
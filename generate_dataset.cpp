@@ -0,0 +1,140 @@
+// generate_dataset.cpp
+// ----------------------------------------------------------------------------
+// Gera datasets sintéticos de qualquer tamanho para medir como as estruturas
+// escalam (10^6 a 10^8 vetores), sem depender das imagens. Os vetores são
+// gravados um a um, então o tamanho não é limitado pela memória.
+//
+// Uso: ./generate_dataset [opcoes]
+//   --n N              Número de vetores (padrão: 1000000).
+//   --dist D           uniform, clusters, skewed ou adversarial (padrão: clusters).
+//   --dim D            Componentes por vetor (padrão: 3). Use main com -DFEATURE_DIM=D.
+//   --max V            Maior valor de um componente (padrão: 255 se dim = 3, senão 1).
+//   --clusters C       Número de grupos em clusters/skewed (padrão: 100).
+//   --spread S         Desvio dos grupos, como fração de --max (padrão: 0.02).
+//   --duplicates P     Fração de cópias exatas em skewed (padrão: 0.3).
+//   --seed S           Semente (padrão: 42). A mesma semente gera o mesmo arquivo.
+//   --first-id I       ID do primeiro vetor (padrão: 1).
+//   --output ARQ       Arquivo de saída; .fvb grava no formato binário, os demais
+//                      em CSV (padrão: dataset_sintetico.fvb).
+// ----------------------------------------------------------------------------
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+
+#include "DatasetIO.hpp"     // DatasetWriter (CSV e .fvb)
+#include "SyntheticData.hpp" // SyntheticGenerator
+
+/**
+ * @struct GenerateOptions
+ * @brief Parâmetros do gerador lidos da linha de comando.
+ */
+struct GenerateOptions {
+    unsigned long long n = 1000000;
+    Distribution dist = Distribution::Clusters;
+    int dim = 3;
+    double max_value = 0.0; // 0 = padrão pela dimensão
+    int clusters = 100;
+    double spread = 0.02;
+    double duplicates = 0.3;
+    unsigned seed = 42;
+    long long first_id = 1;
+    std::string output = "dataset_sintetico.fvb";
+};
+
+void printUsage(const char* program) {
+    std::cout << "Uso: " << program << " [--n N] [--dist uniform|clusters|skewed|adversarial] [--dim D] [--max V]"
+              << " [--clusters C] [--spread S] [--duplicates P] [--seed S] [--first-id I] [--output ARQ]" << std::endl;
+}
+
+// Interpreta os argumentos; retorna false se algum for inválido.
+bool parseArguments(int argc, char* argv[], GenerateOptions& opt) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--n" && has_value) {
+                opt.n = std::stoull(argv[++i]);
+            } else if (arg == "--dist" && has_value) {
+                if (!parseDistribution(argv[++i], opt.dist)) return false;
+            } else if (arg == "--dim" && has_value) {
+                opt.dim = std::stoi(argv[++i]);
+                if (opt.dim < 1) return false;
+            } else if (arg == "--max" && has_value) {
+                opt.max_value = std::stod(argv[++i]);
+                if (opt.max_value <= 0.0) return false;
+            } else if (arg == "--clusters" && has_value) {
+                opt.clusters = std::stoi(argv[++i]);
+                if (opt.clusters < 1) return false;
+            } else if (arg == "--spread" && has_value) {
+                opt.spread = std::stod(argv[++i]);
+                if (opt.spread <= 0.0) return false; // desvio padrão da normal: precisa ser positivo
+            } else if (arg == "--duplicates" && has_value) {
+                opt.duplicates = std::stod(argv[++i]);
+                if (opt.duplicates < 0.0 || opt.duplicates > 1.0) return false;
+            } else if (arg == "--seed" && has_value) {
+                opt.seed = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else if (arg == "--first-id" && has_value) {
+                opt.first_id = std::stoll(argv[++i]);
+            } else if (arg == "--output" && has_value) {
+                opt.output = argv[++i];
+            } else {
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        return false; // número inválido
+    }
+    if (opt.max_value == 0.0) opt.max_value = (opt.dim == 3) ? 255.0 : 1.0;
+    // Os IDs são gravados como int32 (no .fvb e na leitura do main).
+    if (opt.first_id < 0 || opt.first_id + static_cast<long long>(opt.n) - 1 > 2147483647LL) {
+        std::cerr << "Erro: os IDs precisam caber em 32 bits." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    GenerateOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+    }
+    if (!parseArguments(argc, argv, opt)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    DatasetWriter writer(opt.output, static_cast<uint32_t>(opt.dim));
+    if (!writer.ok()) {
+        std::cerr << "Erro: Nao foi possivel criar o arquivo de saida " << opt.output << std::endl;
+        return 1;
+    }
+
+    std::cout << "Gerando " << opt.n << " vetores (" << distributionName(opt.dist) << ", dimensao " << opt.dim
+              << ", semente " << opt.seed << ") em " << opt.output << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    SyntheticGenerator generator(opt.dist, opt.dim, opt.max_value, opt.clusters, opt.spread, opt.duplicates, opt.seed);
+    std::vector<double> values(opt.dim);
+    const unsigned long long report_every = opt.n >= 10 ? opt.n / 10 : 1;
+    for (unsigned long long i = 0; i < opt.n; ++i) {
+        generator.next(values.data());
+        writer.write(static_cast<int32_t>(opt.first_id + static_cast<long long>(i)), values.data());
+        if ((i + 1) % report_every == 0) {
+            std::cout << "  " << (i + 1) << " / " << opt.n << std::endl;
+        }
+    }
+
+    if (!writer.close()) {
+        std::cerr << "Erro: falha ao gravar " << opt.output << " (disco cheio?)" << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Concluido: " << opt.n << " vetores em " << seconds << " s." << std::endl;
+    return 0;
+}
@@ -0,0 +1,265 @@
+// loadgen.cpp
+// ----------------------------------------------------------------------------
+// Gerador de carga para o servidor de consultas (server.cpp). Descobre a maior
+// vazão (consultas/s) que o servidor sustenta com o p99 da latência abaixo de
+// um alvo.
+//
+// A carga é em malha aberta: cada conexão envia consultas num ritmo fixo sem
+// esperar as respostas (uma thread envia, outra recebe), e a latência é medida
+// a partir do instante em que a consulta DEVERIA ter sido enviada. Assim,
+// quando o servidor atrasa, as consultas que se acumulam entram na medida e
+// não somem dela (o problema da "omissão coordenada" de uma malha fechada).
+//
+// A busca dobra a taxa oferecida até o p99 passar do alvo (ou o servidor não
+// acompanhar a taxa) e depois faz uma bissecção entre a última taxa boa e a
+// primeira ruim. Cada passo mostra também o tamanho médio dos micro-lotes,
+// lido dos contadores do servidor.
+//
+// Uso: ./loadgen [opcoes]
+//   --connect END       unix:CAMINHO ou tcp:PORTA (padrao: unix:/tmp/fv_server.sock)
+//   --p99-ms X          Alvo do p99 (padrao: 5)
+//   --k K               Vizinhos por consulta (padrao: 5)
+//   --connections N     Conexões simultâneas (padrao: 4)
+//   --seconds S         Duração de cada passo (padrao: 2)
+//   --rate R            Taxa inicial em consultas/s (padrao: 1000)
+//   --dataset ARQ       Consultas tiradas deste dataset (padrao: sintetico)
+//   --shutdown          Encerra o servidor no final
+// ----------------------------------------------------------------------------
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+
+#include "SyntheticData.hpp" // loadInput, clusteredDataset
+#include "QueryServer.hpp"   // connectTo, LatencyHistogram, ServerCounters
+
+using Clock = std::chrono::steady_clock;
+
+struct StepResult {
+    double offered = 0.0;   // consultas/s pedidas
+    double achieved = 0.0;  // respostas/s obtidas
+    double p50_ms = 0.0, p99_ms = 0.0;
+    double mean_batch = 0.0;
+    size_t errors = 0;
+    bool failed = false;    // conexão perdida
+};
+
+// Pede (e zera) os contadores do servidor pela conexão de controle.
+static bool serverCounters(int fd, ServerCounters& out) {
+    WireBuffer body, reply;
+    body.put<uint8_t>(1);
+    WireOp op;
+    return sendFrame(fd, WireOp::Counters, body) && recvFrame(fd, op, reply) && op == WireOp::Counters &&
+           out.read(reply);
+}
+
+/**
+ * @brief Oferece 'rate' consultas/s por 'seconds' segundos, divididas entre as conexões.
+ */
+static StepResult runStep(const std::vector<int>& fds, int control, const std::vector<FeatureVector>& queries, int k,
+                          double rate, double seconds) {
+    StepResult step;
+    step.offered = rate;
+    ServerCounters counters;
+    serverCounters(control, counters); // zera
+
+    const size_t conns = fds.size();
+    const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(conns / rate));
+    const size_t per_conn = std::max<size_t>(1, static_cast<size_t>(rate * seconds / conns));
+    const Clock::time_point start = Clock::now() + std::chrono::milliseconds(10);
+
+    struct Lane {
+        std::mutex lock;
+        std::condition_variable ready;
+        std::deque<Clock::time_point> scheduled; // consultas enviadas e ainda sem resposta
+        bool done = false;
+        LatencyHistogram latencies;
+        size_t errors = 0;
+        bool failed = false;
+        Clock::time_point last_reply;
+    };
+    std::vector<Lane> lanes(conns);
+    std::vector<std::thread> threads;
+
+    for (size_t c = 0; c < conns; ++c) {
+        Lane* lane_ptr = &lanes[c];
+        int fd = fds[c];
+        // Envio: cada conexão tem o seu ritmo, defasado das demais.
+        threads.emplace_back([&, lane_ptr, fd, c] {
+            Lane& lane = *lane_ptr;
+            WireBuffer body;
+            Clock::time_point first = start + interval * c / conns;
+            for (size_t i = 0; i < per_conn; ++i) {
+                Clock::time_point when = first + interval * i;
+                std::this_thread::sleep_until(when);
+                body.clear();
+                body.put<int32_t>(k);
+                body.putVector(queries[(c + i * conns) % queries.size()]);
+                {
+                    std::lock_guard<std::mutex> guard(lane.lock);
+                    lane.scheduled.push_back(when);
+                }
+                lane.ready.notify_one();
+                if (!sendFrame(fd, WireOp::Query, body)) break;
+            }
+            std::lock_guard<std::mutex> guard(lane.lock);
+            lane.done = true;
+            lane.ready.notify_one();
+        });
+        // Recepção: as respostas chegam na ordem dos pedidos.
+        threads.emplace_back([&, lane_ptr, fd] {
+            Lane& lane = *lane_ptr;
+            WireBuffer reply;
+            WireOp op;
+            QueryResult r;
+            while (true) {
+                Clock::time_point when;
+                {
+                    std::unique_lock<std::mutex> lk(lane.lock);
+                    lane.ready.wait(lk, [&] { return lane.done || !lane.scheduled.empty(); });
+                    if (lane.scheduled.empty()) break;
+                    when = lane.scheduled.front();
+                    lane.scheduled.pop_front();
+                }
+                if (!recvFrame(fd, op, reply)) {
+                    lane.failed = true;
+                    break;
+                }
+                lane.last_reply = Clock::now();
+                lane.latencies.record(lane.last_reply - when);
+                if (op != WireOp::Query || !getQueryReply(reply, r) || r.neighbors.size() > static_cast<size_t>(k)) {
+                    lane.errors++;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    LatencyHistogram all;
+    Clock::time_point end = start;
+    for (Lane& lane : lanes) {
+        all.merge(lane.latencies);
+        step.errors += lane.errors;
+        step.failed = step.failed || lane.failed;
+        end = std::max(end, lane.last_reply);
+    }
+    double elapsed = std::chrono::duration<double>(end - start).count();
+    step.achieved = elapsed > 0.0 ? all.count() / elapsed : 0.0;
+    step.p50_ms = all.percentileMs(50.0);
+    step.p99_ms = all.percentileMs(99.0);
+    if (serverCounters(control, counters)) step.mean_batch = counters.meanBatch();
+    return step;
+}
+
+int main(int argc, char* argv[]) {
+    std::string endpoint = "unix:/tmp/fv_server.sock", dataset;
+    double target_ms = 5.0, seconds = 2.0, rate = 1000.0;
+    int k = 5, connections = 4;
+    bool shutdown = false;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--connect" && has_value) endpoint = argv[++i];
+            else if (arg == "--p99-ms" && has_value) target_ms = std::stod(argv[++i]);
+            else if (arg == "--k" && has_value) k = std::stoi(argv[++i]);
+            else if (arg == "--connections" && has_value) connections = std::max(1, std::stoi(argv[++i]));
+            else if (arg == "--seconds" && has_value) seconds = std::stod(argv[++i]);
+            else if (arg == "--rate" && has_value) rate = std::stod(argv[++i]);
+            else if (arg == "--dataset" && has_value) dataset = argv[++i];
+            else if (arg == "--shutdown") shutdown = true;
+            else throw std::invalid_argument(arg);
+        }
+        if (k < 1 || seconds <= 0.0 || rate <= 0.0) throw std::invalid_argument("valor");
+    } catch (const std::exception&) {
+        std::cerr << "Uso: " << argv[0] << " [--connect END] [--p99-ms X] [--k K] [--connections N] [--seconds S]"
+                  << " [--rate R] [--dataset ARQ] [--shutdown]" << std::endl;
+        return 1;
+    }
+
+    const double value_max = (FeatureVector::DIM == 3) ? 255.0 : 1.0;
+    std::vector<FeatureVector> queries;
+    if (dataset.empty()) {
+        queries = clusteredDataset(1000, 50, 0.05 * value_max, value_max, 7, -1);
+    } else {
+        try {
+            queries = loadInput(dataset, value_max);
+        } catch (const std::exception&) {
+            queries.clear();
+        }
+    }
+    if (queries.empty()) {
+        std::cerr << "!! Nenhuma consulta carregada." << std::endl;
+        return 1;
+    }
+
+    int control = connectTo(endpoint);
+    if (control < 0) return 1;
+    std::vector<int> fds;
+    for (int c = 0; c < connections; ++c) {
+        int fd = connectTo(endpoint);
+        if (fd < 0) return 1;
+        fds.push_back(fd);
+    }
+
+    std::cout << ">> carga em " << endpoint << ": alvo p99 <= " << target_ms << " ms, k = " << k << ", " << connections
+              << " conexoes, " << seconds << " s por passo" << std::endl;
+    std::cout << "   oferecida/s | atingida/s | p50_ms | p99_ms | lote_medio | erros" << std::endl;
+
+    // Uma taxa é sustentada se o p99 cabe no alvo e o servidor acompanha o ritmo pedido.
+    auto sustained = [&](const StepResult& s) {
+        return !s.failed && s.errors == 0 && s.p99_ms <= target_ms && s.achieved >= 0.95 * s.offered;
+    };
+    double good = 0.0, bad = 0.0, best_achieved = 0.0;
+    bool ok = true;
+    auto measure = [&](double r) {
+        StepResult s = runStep(fds, control, queries, k, r, seconds);
+        std::cout << "   " << s.offered << " | " << s.achieved << " | " << s.p50_ms << " | " << s.p99_ms << " | "
+                  << s.mean_batch << " | " << s.errors << (s.failed ? "  (conexao perdida)" : "") << std::endl;
+        ok = ok && !s.failed && s.errors == 0;
+        bool pass = sustained(s);
+        if (pass) best_achieved = std::max(best_achieved, s.achieved);
+        return pass;
+    };
+
+    while (ok && bad == 0.0 && rate < 1e7) {
+        if (measure(rate)) {
+            good = rate;
+            rate *= 2.0;
+        } else {
+            bad = rate;
+        }
+    }
+    for (int i = 0; ok && bad > 0.0 && i < 4; ++i) {
+        double mid = (good + bad) / 2.0;
+        if (measure(mid)) {
+            good = mid;
+        } else {
+            bad = mid;
+        }
+    }
+
+    if (good > 0.0) {
+        std::cout << ">> vazao com p99 <= " << target_ms << " ms: " << good << " consultas/s oferecidas ("
+                  << best_achieved << " atingidas)" << std::endl;
+    } else {
+        std::cout << ">> nenhuma taxa testada ficou com p99 <= " << target_ms << " ms" << std::endl;
+    }
+
+    if (shutdown) {
+        WireBuffer empty, reply;
+        WireOp op;
+        sendFrame(control, WireOp::Shutdown, empty);
+        recvFrame(control, op, reply);
+    }
+    for (int fd : fds) ::close(fd);
+    ::close(control);
+    return ok ? 0 : 1;
+}
@@ -1,127 +1,170 @@
 // ----------------------------------------------------------------------------
 // Este programa é o executor principal do experimento de análise de algoritmos.
-// Ele foi projetado para testar o desempenho de uma estrutura de dados de busca
-// por similaridade. O fluxo é o seguinte:
-// 1. Carrega os vetores de características de imagens de um arquivo 'dataset.csv'.
-// 2. Insere todos esses vetores em uma estrutura de dados (da classe 'Lista').
-// 3. Seleciona algumas imagens do próprio dataset para servirem como consulta.
-// 4. Para cada consulta, mede o tempo de busca e o número de comparações.
-// 5. Salva essas métricas em um arquivo de resultados 'results.csv'.
+// Ele mede o desempenho das estruturas de dados de busca por similaridade.
+// O fluxo é o seguinte:
+// 1. Carrega os vetores de características (CSV ou .fvb) ou gera dados sintéticos.
+// 2. Separa o conjunto de consultas (amostra, retiradas do índice ou sintéticas).
+// 3. Calcula uma vez os vizinhos exatos de cada consulta.
+// 4. Para cada estrutura e cada combinação de parâmetros, constrói a estrutura,
+//    mede as consultas (aquecimento + repetições) e avalia a qualidade.
+// 5. Salva uma linha por estrutura/parâmetros/k numa única tabela de resultados.
+//
+// Uso: ./meu_programa [opcoes]   (./meu_programa --help lista as opções)
 // ----------------------------------------------------------------------------
 
+// Conta os bytes vivos no heap (operator new/delete), para conferir memoryUsage().
+#define MEMORY_COUNTER_IMPLEMENTATION
+#include "MemoryUsage.hpp"
+
 //Bibliotecas necessárias
 #include <iostream>
-#include <vector> 
+#include <vector>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <chrono>
-#include <numeric>
 #include <algorithm>
+#include <cmath>
+#include <thread>
 
 // Arquivos do Projeto
 #include "Vector.hpp"          // Define o que é um FeatureVector
-#include "DataStructure.hpp"   // Define a interface que a Lista deve seguir
-#include "Lista.hpp"           // Implementação da Lista
-#include "Hash.hpp"
-#include "Quadtree.hpp"
+#include "DataStructure.hpp"   // Define a interface comum das estruturas
+#include "DatasetIO.hpp"       // Leitura de datasets CSV e binários
+#include "Experiment.hpp"      // Catálogo de estruturas e grade de parâmetros
+#include "SyntheticData.hpp"   // Dados sintéticos agrupados
+#include "Benchmark.hpp"       // Aquecimento, repetições e percentis de latência
+#include "PerfCounters.hpp"    // Contadores de hardware (perf_event_open)
+#include "Evaluation.hpp"      // Vizinhos exatos, recall, precisão e razão de distâncias
+
+static_assert(FeatureVector::DIM >= 3, "O relatorio grava ao menos tres componentes por consulta");
+
 /**
- * @brief Função auxiliar para carregar o dataset de um arquivo CSV.
- * @param filename O nome do arquivo CSV a ser lido (ex: "dataset.csv").
- * @return Um std::vector contendo todos os FeatureVectors lidos do arquivo.
+ * @struct RunOptions
+ * @brief Parâmetros do experimento lidos da linha de comando.
  */
-std::vector<FeatureVector> loadDatasetFromFile(const std::string& filename) {
-    std::vector<FeatureVector> dataset;
-    std::ifstream file(filename);
+struct RunOptions {
+    std::string dataset = "dataset.csv"; // arquivo, ou "sintetico:N[:grupos]"
+    std::string output = "results.csv";
+    std::string per_query;               // vazio = sem relatório por consulta
+    TableFormat format = TableFormat::Csv;
+    std::vector<std::string> structures; // vazio = todas
+    std::vector<std::pair<std::string, std::vector<double>>> overrides; // "estrutura.param" -> valores
+    std::vector<int> ks = {5};
+    size_t queries = 1000;
+    QuerySetKind query_set = QuerySetKind::Random;
+    int threads = 1;
+    int warmup = 1;
+    int repetitions = 5;
+    bool perf = false;
+    std::vector<size_t> sizes;           // vazio = só o conjunto inteiro
+};
 
-    if (!file.is_open()) {
-        std::cerr << "ERRO FATAL: Nao foi possivel abrir o arquivo de dataset '" << filename << "'." << std::endl;
-        std::cerr << "Certifique-se de que o arquivo existe e esta na mesma pasta do executavel." << std::endl;
-        return dataset; // Retorna o vetor vazio para indicar o erro
-    }
-
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.empty() || line.rfind("//", 0) == 0) continue;
-
-        std::stringstream ss(line);
-        std::string value;
-        FeatureVector vec;
-        
-        std::getline(ss, value, ','); vec.image_id = std::stoi(value);
-        std::getline(ss, value, ','); vec.r = std::stod(value);
-        std::getline(ss, value, ','); vec.g = std::stod(value);
-        std::getline(ss, value); vec.b = std::stod(value);
-        
-        dataset.push_back(vec);
-    }
-    
-    file.close();
-    return dataset;
+void printUsage(const char* program) {
+    std::cout << "Uso: " << program << " [opcoes]\n"
+              << "  --dataset ARQ           Dataset CSV ou .fvb (padrao: dataset.csv), ou sintetico:N[:grupos]\n"
+              << "  --structures A,B,...    Estruturas a medir (padrao: todas):\n"
+              << "                          lista, hash, hash-concurrent, hash-sharded, quadtree, quadtree-snapshot,\n"
+              << "                          quadtree-sharded, flat, flat-sq8, quadtree-sq8, ivf-pq, hnsw, vp-tree\n"
+              << "  --param E.P=V1,V2,...   Valores do parametro P da estrutura E (ex.: hnsw.ef=16,64)\n"
+              << "                          curve (lista, flat, hash, quadtree): 0 = insercao, 1 = Morton, 2 = Hilbert\n"
+              << "  --k K1,K2,...           Numeros de vizinhos (padrao: 5)\n"
+              << "  --queries N             Numero de consultas (padrao: 1000)\n"
+              << "  --sizes N1,N2,...       Repete tudo indexando so os N primeiros vetores (curvas de escala)\n"
+              << "  --query-set TIPO        random, heldout ou synthetic (padrao: random)\n"
+              << "  --threads N             Threads da construcao do HNSW e dos vizinhos exatos (padrao: 1)\n"
+              << "  --warmup N              Passadas de aquecimento (padrao: 1)\n"
+              << "  --reps N                Repeticoes medidas (padrao: 5)\n"
+              << "  --output ARQ            Tabela de resultados (padrao: results.csv)\n"
+              << "  --format F              csv, tsv ou json (JSON Lines) (padrao: csv)\n"
+              << "  --per-query ARQ         Tambem grava uma linha CSV por consulta\n"
+              << "  --perf                  Mede contadores de hardware (ciclos, instrucoes, falhas de LLC,\n"
+              << "                          desvios mal previstos) na construcao e nas consultas\n";
 }
 
-// Ponto de entrada do programa
-int main() {
-    // CARREGAR O DATASET
-    std::cout << ">> Iniciando experimento..." << std::endl;
-    std::cout << "1. Carregando vetores do arquivo 'dataset.csv'..." << std::endl;
-    std::vector<FeatureVector> dataset = loadDatasetFromFile("dataset.csv");
-
-    if (dataset.empty()) {
-        std::cerr << "!! Experimento abortado: o dataset nao pode ser carregado." << std::endl;
-        return 1; // Erro
-    }
-    std::cout << "   -> " << dataset.size() << " vetores carregados com sucesso." << std::endl << std::endl;
-
-    // PREPARAR A ESTRUTURA DE DADOS
-    std::cout << "2. Inserindo vetores na sua estrutura de dados 'Lista'..." << std::endl;
-    
-    Lista list_structure;
-    
-    for (const auto& vec : dataset) {
-        list_structure.insert(vec);
+// Divide "a,b,c" em partes.
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> parts;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) parts.push_back(item);
     }
-    std::cout << "   -> Insercao concluida." << std::endl << std::endl;
+    return parts;
+}
 
-    // PREPARAR A ESTRUTURA DE DADOS HASH
-    std::cout << "2.1 Inserindo vetores na sua estrutura de dados 'Hash' ..." << std::endl;
-    HashTable hash_structure(1013, 5, 25); //quantidade de buckets
-    for(const auto& vec : dataset){
-        hash_structure.insert(vec);
+// Interpreta os argumentos; retorna false se algum for inválido.
+bool parseArguments(int argc, char* argv[], RunOptions& opt) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--dataset" && has_value) {
+                opt.dataset = argv[++i];
+            } else if (arg == "--structures" && has_value) {
+                opt.structures = splitList(argv[++i]);
+            } else if (arg == "--param" && has_value) {
+                std::string spec = argv[++i];
+                size_t eq = spec.find('=');
+                if (eq == std::string::npos || spec.find('.') > eq) return false;
+                std::vector<double> values;
+                for (const auto& v : splitList(spec.substr(eq + 1))) values.push_back(std::stod(v));
+                if (values.empty()) return false;
+                opt.overrides.push_back({spec.substr(0, eq), values});
+            } else if (arg == "--k" && has_value) {
+                opt.ks.clear();
+                for (const auto& v : splitList(argv[++i])) opt.ks.push_back(std::stoi(v));
+                if (opt.ks.empty() || *std::min_element(opt.ks.begin(), opt.ks.end()) < 1) return false;
+            } else if (arg == "--queries" && has_value) {
+                opt.queries = std::stoul(argv[++i]);
+            } else if (arg == "--sizes" && has_value) {
+                opt.sizes.clear();
+                for (const auto& v : splitList(argv[++i])) opt.sizes.push_back(std::stoul(v));
+                if (opt.sizes.empty() || *std::min_element(opt.sizes.begin(), opt.sizes.end()) == 0) return false;
+            } else if (arg == "--query-set" && has_value) {
+                std::string kind = argv[++i];
+                if (kind == "random") opt.query_set = QuerySetKind::Random;
+                else if (kind == "heldout") opt.query_set = QuerySetKind::HeldOut;
+                else if (kind == "synthetic") opt.query_set = QuerySetKind::Synthetic;
+                else return false;
+            } else if (arg == "--threads" && has_value) {
+                opt.threads = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--warmup" && has_value) {
+                opt.warmup = std::max(0, std::stoi(argv[++i]));
+            } else if (arg == "--reps" && has_value) {
+                opt.repetitions = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--output" && has_value) {
+                opt.output = argv[++i];
+            } else if (arg == "--format" && has_value) {
+                std::string format = argv[++i];
+                if (format == "csv") opt.format = TableFormat::Csv;
+                else if (format == "tsv") opt.format = TableFormat::Tsv;
+                else if (format == "json") opt.format = TableFormat::Json;
+                else return false;
+            } else if (arg == "--per-query" && has_value) {
+                opt.per_query = argv[++i];
+            } else if (arg == "--perf") {
+                opt.perf = true;
+            } else {
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        return false; // número inválido
     }
-    std::cout << "  -> Insercao Hash concluida" << std::endl << std::endl;
+    return true;
+}
 
-    // PREPARAR A ESTRUTURA DE DADOS QUADTREE
-    std::cout << "2.1 Inserindo vetores na sua estrutura de dados 'Quadtree' ..." << std::endl;
-    Quadtree quad_structure; // conforme sua Quadtree.hpp
-    for (const auto& vec : dataset) {
-        quad_structure.insert(vec);
-    }
-    std::cout << "  -> Insercao Quadtree concluida" << std::endl << std::endl;
-
-    // PREPARAR O ARQUIVO DE SAÍDA
-    std::string results_filename = "results.csv";
-    std::ofstream results_file(results_filename);
-    
-    results_file << "estrutura,query_image_id,tempo_busca_ms,comparacoes,query_r,query_g,query_b,top_k_avg_similarity\n";
-    std::cout << "3. Arquivo de resultados '" << results_filename << "' preparado." << std::endl << std::endl;
-
-    // EXECUTAR OS EXPERIMENTOS DE BUSCA (Lista)
-    std::cout << "4.0 Executando as buscas por similaridade (Lista)..." << std::endl;
-    int k = 5; // O número de vizinhos mais próximos que queremos encontrar
-    int num_queries = std::min((k*2), (int)dataset.size()); // Testaremos com as k*2 primeiras imagens
-
-    for (int i = 0; i < num_queries; ++i) {
-        const FeatureVector& query_vec = dataset[i];
-
-        // Inicio da medição de tempo busca
-        auto start_time = std::chrono::high_resolution_clock::now();
-        
-        QueryResult result = list_structure.query(query_vec, k);
-        
-        // Fim da medição de tempo busca
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration_ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end_time - start_time);
+/**
+ * @brief Grava uma linha por consulta no CSV detalhado.
+ * @details A latência de cada consulta é a mediana das repetições do benchmark.
+ */
+void writeQueryRows(const BenchmarkResult& bench, const std::string& params, int k,
+                    const std::vector<FeatureVector>& queries, const GroundTruth& truth,
+                    std::ofstream& results_file) {
+    for (size_t i = 0; i < bench.results.size(); ++i) {
+        const FeatureVector& query_vec = queries[i];
+        const QueryResult& result = bench.results[i];
 
         // Calcula a similaridade média dos vizinhos encontrados
         double total_similarity = 0.0;
@@ -132,88 +175,220 @@ int main() {
             total_similarity /= result.neighbors.size();
         }
 
+        AccuracyMetrics acc = evaluateQuery(query_vec, result.neighbors, truth.neighbors[i], truth.distances[i]);
+
         // Grava a linha de resultado no arquivo CSV
-        results_file <<"Lista,"
+        results_file << bench.name << ","
+                     << params << ","
+                     << k << ","
                      << query_vec.image_id << ","
-                     << duration_ms.count() << ","
+                     << bench.query_ms[i] << ","
                      << result.comparisons << ","
-                     << query_vec.r << ","
-                     << query_vec.g << ","
-                     << query_vec.b << ","
-                     << total_similarity << "\n";
-        
-        std::cout << "   -> Consulta com ID " << query_vec.image_id << " concluida. (" 
-                  << duration_ms.count() << " ms, " 
-                  << result.comparisons << " comparacoes)" << std::endl;
+                     << static_cast<double>(query_vec[0]) << ","
+                     << static_cast<double>(query_vec[1]) << ","
+                     << static_cast<double>(query_vec[2]) << ","
+                     << total_similarity << ","
+                     << acc.recall << ","
+                     << acc.precision << ","
+                     << acc.distance_ratio;
+        for (double v : result.stats.values()) results_file << "," << v;
+        results_file << "\n";
     }
+}
 
-    // EXECUTAR OS EXPERIMENTOS DE BUSCA (Hash)
-    std::cout << "\n4.1 Executanto as buscas por similaridade (Hash)..." << std::endl;
-    for (int i = 0; i < num_queries; ++i){
-        const FeatureVector& query_vec = dataset[i];
+// Ponto de entrada do programa
+int main(int argc, char* argv[]) {
+    RunOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+    }
+    if (!parseArguments(argc, argv, opt)) {
+        printUsage(argv[0]);
+        return 1;
+    }
 
-        auto start_time = std::chrono::high_resolution_clock::now();
-        QueryResult result = hash_structure.query(query_vec, k);
-        auto end_time = std::chrono::high_resolution_clock::now();
+    const double value_max = (FeatureVector::DIM == 3) ? 255.0 : 1.0; // faixa dos componentes
 
-        auto duration_ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end_time - start_time);
-        double total_similarity = 0.0;
-        if (!result.neighbors.empty()){
-            for(const auto& neighbor : result.neighbors){
-                total_similarity += query_vec.similarityTo(neighbor);
+    // SELECIONAR AS ESTRUTURAS E APLICAR OS PARÂMETROS DA LINHA DE COMANDO
+    std::vector<StructureSpec> catalog = structureCatalog(value_max, opt.threads);
+    std::vector<StructureSpec> selected;
+    if (opt.structures.empty()) {
+        selected = catalog;
+    } else {
+        for (const auto& name : opt.structures) {
+            auto it = std::find_if(catalog.begin(), catalog.end(), [&](const StructureSpec& s) { return s.key == name; });
+            if (it == catalog.end()) {
+                std::cerr << "!! Estrutura desconhecida: '" << name << "'." << std::endl;
+                return 1;
             }
-            total_similarity /= result.neighbors.size();
+            selected.push_back(*it);
+        }
+    }
+    for (const auto& ov : opt.overrides) {
+        size_t dot = ov.first.find('.');
+        std::string structure = ov.first.substr(0, dot), param = ov.first.substr(dot + 1);
+        bool found = false;
+        for (auto& spec : selected) {
+            if (spec.key == structure) found = overrideParam(spec, param, ov.second);
         }
+        if (!found) {
+            std::cerr << "!! Parametro desconhecido (ou estrutura nao selecionada): '" << ov.first << "'." << std::endl;
+            return 1;
+        }
+    }
 
-        results_file << "Hash,"
-                << query_vec.image_id << ","
-                << duration_ms.count() << ","
-                << result.comparisons << ","
-                << query_vec.r << ","
-                << query_vec.g << ","
-                << query_vec.b << ","
-                << total_similarity << "\n";
-
-            std::cout << "   -> Consulta com ID " << query_vec.image_id
-            << " concluida. (" << duration_ms.count()
-            << " ms, " << result.comparisons << " comparacoes)" << std::endl;
+    // CARREGAR O DATASET
+    std::cout << ">> Iniciando experimento..." << std::endl;
+    std::cout << "1. Carregando vetores de '" << opt.dataset << "'..." << std::endl;
+    std::vector<FeatureVector> dataset;
+    try {
+        dataset = loadInput(opt.dataset, value_max);
+    } catch (const std::exception&) {
+        std::cerr << "!! Especificacao de dados sinteticos invalida: '" << opt.dataset << "'." << std::endl;
+        return 1;
     }
 
-    // EXECUTAR OS EXPERIMENTOS DE BUSCA (Quadtree)
-    std::cout << "\n4.1 Executanto as buscas por similaridade (Quadtree)..." << std::endl;
-    for (int i = 0; i < num_queries; ++i){
-        const FeatureVector& query_vec = dataset[i];
+    if (dataset.empty()) {
+        std::cerr << "!! Experimento abortado: o dataset nao pode ser carregado." << std::endl;
+        return 1; // Erro
+    }
+    std::cout << "   -> " << dataset.size() << " vetores carregados com sucesso." << std::endl;
 
-        auto start_time = std::chrono::high_resolution_clock::now();
-        QueryResult result = quad_structure.query(query_vec, k);
-        auto end_time = std::chrono::high_resolution_clock::now();
+    auto query_split = makeQuerySet(opt.query_set, dataset, opt.queries, value_max);
+    dataset = std::move(query_split.first);
+    std::vector<FeatureVector> queries = std::move(query_split.second);
+    std::cout << "   -> " << queries.size() << " consultas (" << querySetName(opt.query_set) << "), "
+              << dataset.size() << " vetores indexados." << std::endl << std::endl;
 
-        auto duration_ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end_time - start_time);
-        double total_similarity = 0.0;
-        if (!result.neighbors.empty()){
-            for(const auto& neighbor : result.neighbors){
-                total_similarity += query_vec.similarityTo(neighbor);
+    // PREPARAR OS ARQUIVOS DE SAÍDA
+    std::ofstream results_file(opt.output);
+    if (!results_file.is_open()) {
+        std::cerr << "!! Nao foi possivel criar '" << opt.output << "'." << std::endl;
+        return 1;
+    }
+    ResultTable table(results_file, opt.format, summaryColumns());
+    std::ofstream per_query_file;
+    if (!opt.per_query.empty()) {
+        per_query_file.open(opt.per_query);
+        // Para histogramas (FEATURE_DIM != 3) as colunas query_* trazem os três primeiros bins.
+        per_query_file << "estrutura,parametros,k,query_image_id,tempo_busca_ms,comparacoes,query_r,query_g,query_b,"
+                          "top_k_avg_similarity,recall_at_k,precision_at_k,distance_ratio";
+        for (const auto& c : QueryStats::columns()) per_query_file << "," << c;
+        per_query_file << "\n";
+    }
+
+    // Contadores de hardware: sem suporte (outro SO, VM, perf_event_paranoid), as colunas ficam vazias.
+    PerfCounters build_counters;
+    if (opt.perf && !build_counters.available()) {
+        std::cout << "   (aviso) contadores de hardware indisponiveis; as colunas de perf ficarao vazias." << std::endl;
+    }
+
+    // EXECUTAR OS EXPERIMENTOS: tamanho x estrutura x parâmetros de construção x parâmetros de consulta x k
+    struct Row {
+        std::string name, params;
+        int k;
+        BuildInfo build;
+        BenchmarkResult bench;
+    };
+    std::vector<Row> rows;
+    int step = 0;
+    std::vector<size_t> sizes = opt.sizes;
+    if (sizes.empty()) sizes.push_back(dataset.size());
+    int k_max = *std::max_element(opt.ks.begin(), opt.ks.end());
+    for (size_t n : sizes) {
+        // Curvas de escala: os N primeiros vetores indexados, sempre com as mesmas consultas.
+        std::vector<FeatureVector> prefix;
+        if (n < dataset.size()) prefix.assign(dataset.begin(), dataset.begin() + n);
+        const std::vector<FeatureVector>& indexed = n < dataset.size() ? prefix : dataset; // sem cópia no caso comum
+
+        // VIZINHOS EXATOS: calculados uma vez por tamanho, para o maior k pedido
+        std::cout << "2. Calculando os vizinhos exatos (" << indexed.size() << " vetores, k = " << k_max << ", "
+                  << opt.threads << " threads)..." << std::endl;
+        GroundTruth truth_max = computeGroundTruth(indexed, queries, k_max, opt.threads);
+        std::vector<GroundTruth> truths;
+        for (int k : opt.ks) truths.push_back(truncateGroundTruth(truth_max, k));
+        std::cout << "   -> Concluido." << std::endl << std::endl;
+
+        for (const auto& spec : selected) {
+            for (const auto& build_params : expandGrid(spec.build_params)) {
+                std::cout << "3." << step++ << " Construindo '" << spec.label << "' (" << formatParams(build_params) << ")..." << std::endl;
+                BuildInfo build;
+                build.vectors = indexed.size();
+                long long heap_before = heapBytesInUse();
+                if (opt.perf) build_counters.start();
+                auto build_start = std::chrono::steady_clock::now();
+                std::unique_ptr<DataStructure> structure = spec.build(indexed, build_params);
+                auto build_end = std::chrono::steady_clock::now();
+                if (opt.perf) build.perf = build_counters.stop();
+                if (heap_before >= 0) build.heap_bytes = heapBytesInUse() - heap_before;
+                build.ms = std::chrono::duration<double, std::milli>(build_end - build_start).count();
+                build.memory = structure->memoryUsage();
+                std::cout << "   -> Construcao: " << build.ms << " ms, memoria: " << build.memory.total() / 1024.0
+                          << " KiB (payload " << build.memory.payload / 1024.0 << ", overhead " << build.memory.overhead / 1024.0
+                          << ", folga " << build.memory.slack / 1024.0 << ")" << std::endl;
+
+                for (const auto& query_params : expandGrid(spec.query_params)) {
+                    if (spec.configure) spec.configure(*structure, query_params);
+                    ParamSet all = build_params;
+                    all.insert(query_params.begin(), query_params.end());
+                    std::string params = formatParams(all);
+
+                    for (size_t ki = 0; ki < opt.ks.size(); ++ki) {
+                        BenchmarkConfig config;
+                        config.k = opt.ks[ki];
+                        config.warmup_passes = opt.warmup;
+                        config.repetitions = opt.repetitions;
+                        config.perf_counters = opt.perf;
+
+                        BenchmarkResult bench = runBenchmark(spec.label, *structure, queries, truths[ki], config);
+                        table.row(summaryValues(bench, params, opt.query_set, config, build));
+                        if (per_query_file.is_open()) {
+                            writeQueryRows(bench, params, config.k, queries, truths[ki], per_query_file);
+                        }
+                        std::cout << "   => [" << params << "] recall@" << config.k << ": " << bench.accuracy.recall
+                                  << ", precisao: " << bench.accuracy.precision
+                                  << ", razao de distancias: " << bench.accuracy.distance_ratio
+                                  << ", p50: " << bench.latency.p50 << " ms, p99: " << bench.latency.p99 << " ms" << std::endl;
+                        if (bench.query_perf.any()) {
+                            const PerfSample& qp = bench.query_perf;
+                            std::cout << "      por consulta: " << qp.cycles() << " ciclos, " << qp.instructions()
+                                      << " instrucoes (IPC " << qp.instructions() / qp.cycles() << "), "
+                                      << qp.llcMisses() << " falhas de LLC, " << qp.branchMisses()
+                                      << " desvios mal previstos" << std::endl;
+                        }
+                        bench.results.clear();
+                        rows.push_back({spec.label, params, config.k, build, std::move(bench)});
+                    }
+                }
             }
-            total_similarity /= result.neighbors.size();
         }
 
-        results_file << "Quadtree,"
-                << query_vec.image_id << ","
-                << duration_ms.count() << ","
-                << result.comparisons << ","
-                << query_vec.r << ","
-                << query_vec.g << ","
-                << query_vec.b << ","
-                << total_similarity << "\n";
-
-            std::cout << "   -> Consulta com ID " << query_vec.image_id
-            << " concluida. (" << duration_ms.count()
-            << " ms, " << result.comparisons << " comparacoes)" << std::endl;
     }
 
     results_file.close();
+    if (per_query_file.is_open()) per_query_file.close();
+
+    // Tabela resumo: custo x qualidade de cada configuração
+    std::cout << "\n4. Resumo (" << opt.repetitions << " repeticoes de " << queries.size() << " consultas)" << std::endl;
+    std::cout << "   estrutura | parametros | vetores | k | construcao_ms | memoria_KiB | media_ms | p50_ms | p99_ms | p99.9_ms | consultas/s"
+              << " | comparacoes | recall | precisao | razao_dist" << std::endl;
+    for (const auto& row : rows) {
+        const BenchmarkResult& b = row.bench;
+        std::cout << "   " << row.name << " | " << row.params << " | " << row.build.vectors << " | " << row.k << " | " << row.build.ms
+                  << " | " << row.build.memory.total() / 1024.0
+                  << " | " << b.latency.mean << " | " << b.latency.p50 << " | " << b.latency.p99
+                  << " | " << b.latency.p999 << " | " << b.latency.throughput_qps << " | " << b.mean_comparisons
+                  << " | " << b.accuracy.recall << " | " << b.accuracy.precision
+                  << " | " << b.accuracy.distance_ratio << std::endl;
+    }
+
     std::cout << "\n>> Experimentos finalizados com sucesso!" << std::endl;
-    std::cout << "   Resultados salvos em '" << results_filename << "'." << std::endl;
+    std::cout << "   Resultados salvos em '" << opt.output << "'";
+    if (!opt.per_query.empty()) std::cout << " e '" << opt.per_query << "' (por consulta)";
+    std::cout << "." << std::endl;
 
     return 0;
 }
@@ -0,0 +1,142 @@
+// server.cpp
+// ----------------------------------------------------------------------------
+// Servidor de consultas por similaridade. Carrega o dataset, constrói uma das
+// estruturas do catálogo uma vez e passa a atender consultas k-NN (e
+// inserções/remoções) pelo protocolo binário de Protocol.hpp, num socket Unix
+// ou TCP de loopback, até receber SIGINT/SIGTERM ou uma requisição Shutdown.
+// As requisições simultâneas são agrupadas em micro-lotes (QueryServer.hpp).
+// Ao sair, imprime os contadores de vazão e latência.
+//
+// Uso: ./server [opcoes]
+//   --dataset ARQ          CSV, .fvb ou sintetico:N[:grupos] (padrao: dataset.csv)
+//   --structure NOME       Estrutura do catalogo (padrao: flat)
+//   --param P=V            Parametro da estrutura (ex.: ef=128); pode repetir. Sem ele, a construcao
+//                          usa o padrao do catalogo e a consulta um valor de servico (servingParams:
+//                          ef=64 no hnsw, nprobe=8 no ivf-pq)
+//   --listen END           unix:CAMINHO ou tcp:PORTA (padrao: unix:/tmp/fv_server.sock)
+//   --batch N              Maior micro-lote (padrao: 64)
+//   --batch-wait-us N      Espera por mais requisicoes depois da primeira (padrao: 100)
+//   --report S             Imprime os contadores a cada S segundos (padrao: 0 = so no fim)
+//   --cache N              Cache de N resultados na frente da estrutura (padrao: 0 = sem cache)
+//   --cache-cell X         Celula de quantizacao da chave do cache (padrao: 0 = consulta exata)
+// ----------------------------------------------------------------------------
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <csignal>
+#include <algorithm>
+
+#include "Experiment.hpp"    // structureCatalog
+#include "SyntheticData.hpp" // loadInput
+#include "QueryServer.hpp"
+#include "ResultCache.hpp"
+
+static QueryServer* running = nullptr;
+
+static void onSignal(int) {
+    if (running) running->requestStop();
+}
+
+int main(int argc, char* argv[]) {
+    std::string dataset = "dataset.csv", structure = "flat", endpoint = "unix:/tmp/fv_server.sock";
+    std::vector<std::pair<std::string, double>> overrides;
+    size_t max_batch = 64;
+    int batch_wait_us = 100;
+    double report_seconds = 0.0;
+    size_t cache_entries = 0;
+    double cache_cell = 0.0;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--dataset" && has_value) {
+                dataset = argv[++i];
+            } else if (arg == "--structure" && has_value) {
+                structure = argv[++i];
+            } else if (arg == "--param" && has_value) {
+                std::string spec = argv[++i];
+                size_t eq = spec.find('=');
+                if (eq == std::string::npos) throw std::invalid_argument(spec);
+                overrides.push_back({spec.substr(0, eq), std::stod(spec.substr(eq + 1))});
+            } else if (arg == "--listen" && has_value) {
+                endpoint = argv[++i];
+            } else if (arg == "--batch" && has_value) {
+                max_batch = std::stoul(argv[++i]);
+            } else if (arg == "--batch-wait-us" && has_value) {
+                batch_wait_us = std::stoi(argv[++i]);
+            } else if (arg == "--report" && has_value) {
+                report_seconds = std::stod(argv[++i]);
+            } else if (arg == "--cache" && has_value) {
+                cache_entries = std::stoul(argv[++i]);
+            } else if (arg == "--cache-cell" && has_value) {
+                cache_cell = std::stod(argv[++i]);
+            } else {
+                throw std::invalid_argument(arg);
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Uso: " << argv[0] << " [--dataset ARQ] [--structure NOME] [--param P=V] [--listen END]"
+                  << " [--batch N] [--batch-wait-us N] [--report S] [--cache N] [--cache-cell X]" << std::endl;
+        return 1;
+    }
+
+    const double value_max = (FeatureVector::DIM == 3) ? 255.0 : 1.0;
+    std::vector<StructureSpec> catalog = structureCatalog(value_max, 1);
+    auto spec = std::find_if(catalog.begin(), catalog.end(), [&](const StructureSpec& s) { return s.key == structure; });
+    if (spec == catalog.end()) {
+        std::cerr << "!! Estrutura desconhecida: '" << structure << "'." << std::endl;
+        return 1;
+    }
+    for (const auto& ov : overrides) {
+        if (!overrideParam(*spec, ov.first, {ov.second})) {
+            std::cerr << "!! Parametro desconhecido: '" << ov.first << "'." << std::endl;
+            return 1;
+        }
+    }
+    ParamSet params = servingParams(*spec);
+    for (const auto& ov : overrides) params[ov.first] = ov.second; // --param vale sobre o valor de serviço
+
+    std::cout << ">> Carregando '" << dataset << "'..." << std::endl;
+    std::vector<FeatureVector> data;
+    try {
+        data = loadInput(dataset, value_max);
+    } catch (const std::exception&) {
+        std::cerr << "!! Especificacao de dados sinteticos invalida: '" << dataset << "'." << std::endl;
+        return 1;
+    }
+    if (data.empty()) {
+        std::cerr << "!! Nenhum vetor carregado." << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<DataStructure> index = spec->build(data, params);
+    if (spec->configure) spec->configure(*index, params);
+    std::vector<FeatureVector>().swap(data);
+    std::cout << ">> '" << spec->label << "' (" << formatParams(params) << ") construida em "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+              << " ms" << std::endl;
+    CachedIndex* cache = nullptr;
+    if (cache_entries > 0) {
+        // Só a thread executora do servidor consulta a estrutura, então ela não precisa ser thread-safe.
+        auto wrapped = std::make_unique<CachedIndex>(std::move(index), cache_entries, cache_cell, true);
+        cache = wrapped.get();
+        index = std::move(wrapped);
+    }
+
+    QueryServer server(*index, max_batch, batch_wait_us);
+    running = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::cout << ">> Atendendo em " << endpoint << " (lote ate " << max_batch << ", espera " << batch_wait_us
+              << " us)" << std::endl;
+    if (!server.run(endpoint, report_seconds)) return 1;
+    running = nullptr;
+
+    std::cout << ">> Servidor encerrado (contadores desde o inicio ou desde a ultima zeragem pedida por um cliente):" << std::endl;
+    printServerCounters(server.counters());
+    if (cache) printCacheStats(cache->stats());
+    return 0;
+}